@@ -2353,13 +2353,13 @@ heap_prepare_insert(Relation relation, HeapTuple tup, TransactionId xid,
 {
 	/*
 	 * Parallel operations are required to be strictly read-only in a parallel
-	 * worker.  Parallel inserts are not safe even in the leader in the
-	 * general case, because group locking means that heavyweight locks for
-	 * relation extension or GIN page locks will not conflict between members
-	 * of a lock group, but we don't prohibit that case here because there are
-	 * useful special cases that we can safely allow, such as CREATE TABLE AS.
+	 * worker, unless the worker was set up for inserting with
+	 * AllowParallelWorkerInserts, as parallel COPY FROM workers are.  Relation
+	 * extension and page locks conflict between members of a lock group, so
+	 * those inserts are safe.  Parallel inserts in the leader are allowed, as
+	 * there are useful special cases such as CREATE TABLE AS.
 	 */
-	if (IsParallelWorker())
+	if (IsParallelWorker() && !ParallelWorkerInsertsAllowed())
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_TRANSACTION_STATE),
 				 errmsg("cannot insert tuples in a parallel worker")));
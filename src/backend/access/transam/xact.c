@@ -222,6 +222,12 @@ static SubTransactionId currentSubTransactionId;
 static CommandId currentCommandId;
 static bool currentCommandIdUsed;
 
+/*
+ * Set in a parallel worker that is allowed to insert tuples, because the
+ * leader assigned the XID and used the command ID before launching it.
+ */
+static bool parallelWorkerInsertsAllowed = false;
+
 /*
  * xactStartTimestamp is the value of transaction_timestamp().
  * stmtStartTimestamp is the value of statement_timestamp().
@@ -666,11 +672,12 @@ GetCurrentCommandId(bool used)
 	{
 		/*
 		 * Forbid setting currentCommandIdUsed in a parallel worker, because
-		 * we have no provision for communicating this back to the master.  We
-		 * could relax this restriction when currentCommandIdUsed was already
-		 * true at the start of the parallel operation.
+		 * we have no provision for communicating this back to the master.
+		 * Workers allowed to insert are OK, since AllowParallelWorkerInserts
+		 * checked that it was already true at the start of the parallel
+		 * operation.
 		 */
-		Assert(!IsParallelWorker());
+		Assert(!IsParallelWorker() || parallelWorkerInsertsAllowed);
 		currentCommandIdUsed = true;
 	}
 	return currentCommandId;
@@ -912,6 +919,37 @@ IsInParallelMode(void)
 	return CurrentTransactionState->parallelModeLevel != 0;
 }
 
+/*
+ *	AllowParallelWorkerInserts
+ *
+ * Allow this parallel worker to insert tuples.  That's only possible if the
+ * leader assigned the transaction ID and marked the command ID as used before
+ * launching us, since we can't report either back to it.  The caller is
+ * responsible for everything else that makes its inserts safe.
+ */
+void
+AllowParallelWorkerInserts(void)
+{
+	Assert(IsParallelWorker());
+
+	if (!TransactionIdIsValid(CurrentTransactionState->transactionId) ||
+		!currentCommandIdUsed)
+		elog(ERROR, "parallel leader did not prepare the transaction for inserts");
+
+	parallelWorkerInsertsAllowed = true;
+}
+
+/*
+ *	ParallelWorkerInsertsAllowed
+ *
+ * Has AllowParallelWorkerInserts been called in this parallel worker?
+ */
+bool
+ParallelWorkerInsertsAllowed(void)
+{
+	return parallelWorkerInsertsAllowed;
+}
+
 /*
  *	CommandCounterIncrement
  */
@@ -4982,8 +5020,9 @@ Size
 EstimateTransactionStateSpace(void)
 {
 	TransactionState s;
-	Size		nxids = 6;		/* iso level, deferrable, top & current XID,
-								 * command counter, XID count */
+	Size		nxids = 7;		/* iso level, deferrable, top & current XID,
+								 * command counter and whether it's used, XID
+								 * count */
 
 	for (s = CurrentTransactionState; s != NULL; s = s->parent)
 	{
@@ -5003,13 +5042,13 @@ EstimateTransactionStateSpace(void)
  *
  * We need to save and restore XactDeferrable, XactIsoLevel, and the XIDs
  * associated with this transaction.  The first eight bytes of the result
- * contain XactDeferrable and XactIsoLevel; the next twelve bytes contain the
+ * contain XactDeferrable and XactIsoLevel; the next sixteen bytes contain the
  * XID of the top-level transaction, the XID of the current transaction
- * (or, in each case, InvalidTransactionId if none), and the current command
- * counter.  After that, the next 4 bytes contain a count of how many
- * additional XIDs follow; this is followed by all of those XIDs one after
- * another.  We emit the XIDs in sorted order for the convenience of the
- * receiving process.
+ * (or, in each case, InvalidTransactionId if none), the current command
+ * counter, and whether it has been used.  After that, the next 4 bytes
+ * contain a count of how many additional XIDs follow; this is followed by
+ * all of those XIDs one after another.  We emit the XIDs in sorted order for
+ * the convenience of the receiving process.
  */
 void
 SerializeTransactionState(Size maxsize, char *start_address)
@@ -5026,6 +5065,7 @@ SerializeTransactionState(Size maxsize, char *start_address)
 	result[c++] = XactTopTransactionId;
 	result[c++] = CurrentTransactionState->transactionId;
 	result[c++] = (TransactionId) currentCommandId;
+	result[c++] = (TransactionId) currentCommandIdUsed;
 	Assert(maxsize >= c * sizeof(TransactionId));
 
 	/*
@@ -5092,8 +5132,9 @@ StartParallelWorkerTransaction(char *tstatespace)
 	XactTopTransactionId = tstate[2];
 	CurrentTransactionState->transactionId = tstate[3];
 	currentCommandId = tstate[4];
-	nParallelCurrentXids = (int) tstate[5];
-	ParallelCurrentXids = &tstate[6];
+	currentCommandIdUsed = (bool) tstate[5];
+	nParallelCurrentXids = (int) tstate[6];
+	ParallelCurrentXids = &tstate[7];
 
 	CurrentTransactionState->blockState = TBLOCK_PARALLEL_INPROGRESS;
 }
@@ -20,11 +20,13 @@
 
 #include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/parallel.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/dependency.h"
 #include "catalog/pg_authid.h"
+#include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "commands/copy.h"
 #include "commands/defrem.h"
@@ -37,15 +39,21 @@
 #include "libpq/pqformat.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
+#include "optimizer/clauses.h"
 #include "optimizer/optimizer.h"
 #include "nodes/makefuncs.h"
 #include "parser/parse_coerce.h"
 #include "parser/parse_collate.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_relation.h"
+#include "pgstat.h"
+#include "port/atomics.h"
 #include "port/pg_bswap.h"
+#include "port/simd.h"
+#include "postmaster/bgworker_internals.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/fd.h"
+#include "storage/shm_mq.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
@@ -133,6 +141,7 @@ typedef struct CopyStateData
 	copy_data_source_cb data_source_cb; /* function for reading data */
 	bool		binary;			/* binary format? */
 	bool		freeze;			/* freeze rows on loading? */
+	int			parallel_workers;	/* max parallel workers for COPY FROM */
 	bool		csv_mode;		/* Comma Separated Value format? */
 	bool		header_line;	/* CSV header line? */
 	char	   *null_print;		/* NULL marker string (server encoding!) */
@@ -186,6 +195,16 @@ typedef struct CopyStateData
 
 	TransitionCaptureState *transition_capture;
 
+	/*
+	 * In a parallel COPY FROM worker, the input lines come from chunks sent
+	 * by the leader instead of from the data source; see
+	 * CopyReadLineFromChunk.
+	 */
+	shm_mq_handle *chunk_mqh;	/* queue to receive chunks from, or NULL */
+	char	   *chunk_data;		/* current chunk */
+	Size		chunk_len;		/* length of current chunk */
+	Size		chunk_pos;		/* next byte to process in it */
+
 	/*
 	 * These variables are used to reduce overhead in textual COPY FROM.
 	 *
@@ -233,6 +252,84 @@ typedef struct
 	uint64		processed;		/* # of tuples processed */
 } DR_copy;
 
+/*
+ * COPY FROM buffers tuples for heap_multi_insert separately for each target
+ * relation, so that loading a partitioned table whose input does not arrive
+ * sorted by partition still gets reasonably sized batches.  All buffers are
+ * flushed together when the total number or size of buffered tuples gets too
+ * large, which bounds the memory used by the tuples themselves.
+ *
+ * No more than this many tuples per CopyMultiInsertBuffer.  Don't make this
+ * too big, as we could end up with up to MAX_PARTITION_BUFFERS buffers being
+ * kept around, plus any number created since the last flush.
+ */
+#define MAX_BUFFERED_TUPLES		1000
+
+/* Flush buffers if the tuples stored add up to this many bytes */
+#define MAX_BUFFERED_BYTES		65535
+
+/* Trim the list of buffers back down to this number after flushing */
+#define MAX_PARTITION_BUFFERS	32
+
+/* Tuples waiting to be multi-inserted into a single relation */
+typedef struct CopyMultiInsertBuffer
+{
+	HeapTuple	tuples[MAX_BUFFERED_TUPLES];	/* tuples to insert */
+	uint64		linenos[MAX_BUFFERED_TUPLES];	/* their input line numbers */
+	ResultRelInfo *resultRelInfo;	/* relation to insert them into */
+	TupleTableSlot *slot;		/* slot of the relation's rowtype */
+	BulkInsertState bistate;	/* bulk insert state for the relation */
+	int			nused;			/* number of tuples in 'tuples' */
+} CopyMultiInsertBuffer;
+
+/* All the multi-insert buffers of a COPY FROM */
+typedef struct CopyMultiInsertInfo
+{
+	List	   *multiInsertBuffers; /* list of CopyMultiInsertBuffer */
+	int			bufferedTuples; /* number of tuples buffered over all buffers */
+	Size		bufferedBytes;	/* total size of those tuples */
+	CopyState	cstate;			/* COPY FROM state */
+	EState	   *estate;			/* executor state used for COPY FROM */
+	CommandId	mycid;			/* command id for the inserts */
+	int			hi_options;		/* heap_multi_insert options */
+} CopyMultiInsertInfo;
+
+/*
+ * In a parallel COPY FROM, the leader reads the input, splits it into lines
+ * and converts them to server encoding, just as CopyReadLine always does.
+ * The lines are passed to the workers in chunks through a shm_mq per worker,
+ * and each worker runs an ordinary CopyFrom over them: it parses the lines,
+ * calls the input functions, checks constraints and inserts the rows.
+ *
+ * In a chunk, each line is preceded by its line number as a uint64 and its
+ * length as a uint32.  The line numbers are sent along because a CSV line
+ * can span several lines of input.
+ */
+#define PARALLEL_KEY_COPY_SHARED		UINT64CONST(0xC000000000000001)
+#define PARALLEL_KEY_COPY_ARGS			UINT64CONST(0xC000000000000002)
+#define PARALLEL_KEY_COPY_QUEUES		UINT64CONST(0xC000000000000003)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xC000000000000004)
+
+#define PARALLEL_COPY_QUEUE_SIZE		(256 * 1024)
+#define PARALLEL_COPY_CHUNK_SIZE		(64 * 1024)
+
+/* Shared state for parallel COPY FROM */
+typedef struct ParallelCopyShared
+{
+	Oid			relid;			/* target table */
+	pg_atomic_uint64 processed; /* rows inserted by all workers */
+} ParallelCopyShared;
+
+/* Leader's state for parallel COPY FROM */
+typedef struct ParallelCopyLeader
+{
+	ParallelContext *pcxt;
+	ParallelCopyShared *shared;
+	int			nqueues;		/* number of workers launched */
+	shm_mq_handle **queues;		/* their chunk queues */
+	int			next_queue;		/* queue to send the next chunk to */
+} ParallelCopyLeader;
+
 
 /*
  * These macros centralize code used to process line_buf and raw_buf buffers.
@@ -316,13 +413,16 @@ static uint64 DoCopyTo(CopyState cstate);
 static uint64 CopyTo(CopyState cstate);
 static void CopyOneRowTo(CopyState cstate,
 			 Datum *values, bool *nulls);
-static void CopyFromInsertBatch(CopyState cstate, EState *estate,
-					CommandId mycid, int hi_options,
-					ResultRelInfo *resultRelInfo, TupleTableSlot *myslot,
-					BulkInsertState bistate,
-					int nBufferedTuples, HeapTuple *bufferedTuples,
-					uint64 firstBufferedLineNo);
+static bool CopyFromParallelOK(CopyState cstate);
+static uint64 ParallelCopyFrom(CopyState cstate, List *attnamelist,
+				 List *options);
+static void ParallelCopySendChunk(ParallelCopyLeader *leader,
+					  StringInfo chunk);
+static void ParallelCopyDetachQueues(ParallelCopyLeader *leader);
+static int	ParallelCopyNoData(void *outbuf, int minread, int maxread);
+static bool CopyReadNextLine(CopyState cstate);
 static bool CopyReadLine(CopyState cstate);
+static bool CopyReadLineFromChunk(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 static int	CopyReadAttributesText(CopyState cstate);
 static int	CopyReadAttributesCSV(CopyState cstate);
@@ -1027,7 +1127,11 @@ DoCopy(ParseState *pstate, const CopyStmt *stmt,
 		cstate = BeginCopyFrom(pstate, rel, stmt->filename, stmt->is_program,
 							   NULL, stmt->attlist, stmt->options);
 		cstate->whereClause = whereClause;
-		*processed = CopyFrom(cstate);	/* copy from file to database */
+		if (CopyFromParallelOK(cstate))
+			*processed = ParallelCopyFrom(cstate, stmt->attlist,
+										  stmt->options);
+		else
+			*processed = CopyFrom(cstate);	/* copy from file to database */
 		EndCopyFrom(cstate);
 	}
 	else
@@ -1072,6 +1176,7 @@ ProcessCopyOptions(ParseState *pstate,
 				   List *options)
 {
 	bool		format_specified = false;
+	bool		parallel_specified = false;
 	ListCell   *option;
 
 	/* Support external use for option sanity checking */
@@ -1118,6 +1223,23 @@ ProcessCopyOptions(ParseState *pstate,
 						 parser_errposition(pstate, defel->location)));
 			cstate->freeze = defGetBoolean(defel);
 		}
+		else if (strcmp(defel->defname, "parallel") == 0)
+		{
+			if (parallel_specified)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options"),
+						 parser_errposition(pstate, defel->location)));
+			parallel_specified = true;
+			cstate->parallel_workers = defGetInt32(defel);
+			if (cstate->parallel_workers < 0 ||
+				cstate->parallel_workers > MAX_PARALLEL_WORKER_LIMIT)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("argument to option \"%s\" must be between 0 and %d",
+								defel->defname, MAX_PARALLEL_WORKER_LIMIT),
+						 parser_errposition(pstate, defel->location)));
+		}
 		else if (strcmp(defel->defname, "delimiter") == 0)
 		{
 			if (cstate->delim)
@@ -1387,6 +1509,12 @@ ProcessCopyOptions(ParseState *pstate,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("COPY force null only available using COPY FROM")));
 
+	/* Check parallel */
+	if (cstate->parallel_workers > 0 && !is_from)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("COPY parallel only available using COPY FROM")));
+
 	/* Don't allow the delimiter to appear in the null string. */
 	if (strchr(cstate->null_print, cstate->delim[0]) != NULL)
 		ereport(ERROR,
@@ -2303,6 +2431,287 @@ limit_printout_length(const char *str)
 	return res;
 }
 
+/*
+ * Allocate memory and initialize a new CopyMultiInsertBuffer for this
+ * ResultRelInfo.  'slot' must be a slot of the relation's rowtype.
+ */
+static CopyMultiInsertBuffer *
+CopyMultiInsertBufferInit(ResultRelInfo *rri, TupleTableSlot *slot)
+{
+	CopyMultiInsertBuffer *buffer;
+
+	buffer = (CopyMultiInsertBuffer *) palloc(sizeof(CopyMultiInsertBuffer));
+	buffer->resultRelInfo = rri;
+	buffer->slot = slot;
+	buffer->bistate = GetBulkInsertState();
+	buffer->nused = 0;
+
+	return buffer;
+}
+
+/*
+ * Make a new buffer for this ResultRelInfo.
+ */
+static inline void
+CopyMultiInsertInfoSetupBuffer(CopyMultiInsertInfo *miinfo,
+							   ResultRelInfo *rri, TupleTableSlot *slot)
+{
+	CopyMultiInsertBuffer *buffer;
+
+	buffer = CopyMultiInsertBufferInit(rri, slot);
+
+	/* Setup back-link so we can easily find this buffer again */
+	rri->ri_CopyMultiInsertBuffer = buffer;
+	/* Record that we're tracking this buffer */
+	miinfo->multiInsertBuffers = lappend(miinfo->multiInsertBuffers, buffer);
+}
+
+/*
+ * Initialize an already allocated CopyMultiInsertInfo.
+ *
+ * If rri is a non-partitioned table then a CopyMultiInsertBuffer is set up
+ * for that table.  Buffers for partitions are set up when the first tuple is
+ * routed to them.
+ */
+static void
+CopyMultiInsertInfoInit(CopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
+						TupleTableSlot *slot, CopyState cstate,
+						EState *estate, CommandId mycid, int hi_options)
+{
+	miinfo->multiInsertBuffers = NIL;
+	miinfo->bufferedTuples = 0;
+	miinfo->bufferedBytes = 0;
+	miinfo->cstate = cstate;
+	miinfo->estate = estate;
+	miinfo->mycid = mycid;
+	miinfo->hi_options = hi_options;
+
+	if (rri->ri_RelationDesc->rd_rel->relkind != RELKIND_PARTITIONED_TABLE)
+		CopyMultiInsertInfoSetupBuffer(miinfo, rri, slot);
+}
+
+/*
+ * Returns true if the buffers are full
+ */
+static inline bool
+CopyMultiInsertInfoIsFull(CopyMultiInsertInfo *miinfo)
+{
+	if (miinfo->bufferedTuples >= MAX_BUFFERED_TUPLES ||
+		miinfo->bufferedBytes >= MAX_BUFFERED_BYTES)
+		return true;
+	return false;
+}
+
+/*
+ * Returns true if we have no buffered tuples
+ */
+static inline bool
+CopyMultiInsertInfoIsEmpty(CopyMultiInsertInfo *miinfo)
+{
+	return miinfo->bufferedTuples == 0;
+}
+
+/*
+ * Write the tuples stored in 'buffer' out to the heap, then update indexes
+ * and run AFTER ROW INSERT triggers.
+ */
+static inline void
+CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
+						   CopyMultiInsertBuffer *buffer)
+{
+	MemoryContext oldcontext;
+	int			i;
+	uint64		save_cur_lineno;
+	CopyState	cstate = miinfo->cstate;
+	EState	   *estate = miinfo->estate;
+	ResultRelInfo *resultRelInfo = buffer->resultRelInfo;
+	ResultRelInfo *save_resultRelInfo = estate->es_result_relation_info;
+	TupleTableSlot *slot = buffer->slot;
+	int			nused = buffer->nused;
+	bool		line_buf_valid = cstate->line_buf_valid;
+
+	if (nused == 0)
+		return;
+
+	/*
+	 * Print error context information correctly, if one of the operations
+	 * below fail.
+	 */
+	cstate->line_buf_valid = false;
+	save_cur_lineno = cstate->cur_lineno;
+
+	/*
+	 * heap_multi_insert leaks memory, so switch to short-lived memory context
+	 * before calling it.
+	 */
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	heap_multi_insert(resultRelInfo->ri_RelationDesc,
+					  buffer->tuples,
+					  nused,
+					  miinfo->mycid,
+					  miinfo->hi_options,
+					  buffer->bistate);
+	MemoryContextSwitchTo(oldcontext);
+
+	/* For ExecInsertIndexTuples() to work on the relation's indexes */
+	estate->es_result_relation_info = resultRelInfo;
+
+	/*
+	 * If there are any indexes, update them for all the inserted tuples, and
+	 * run AFTER ROW INSERT triggers.
+	 */
+	if (resultRelInfo->ri_NumIndices > 0)
+	{
+		for (i = 0; i < nused; i++)
+		{
+			List	   *recheckIndexes;
+
+			cstate->cur_lineno = buffer->linenos[i];
+			ExecStoreHeapTuple(buffer->tuples[i], slot, false);
+			recheckIndexes =
+				ExecInsertIndexTuples(slot, &(buffer->tuples[i]->t_self),
+									  estate, false, NULL, NIL);
+			ExecARInsertTriggers(estate, resultRelInfo,
+								 slot,
+								 recheckIndexes, cstate->transition_capture);
+			list_free(recheckIndexes);
+		}
+	}
+
+	/*
+	 * There's no indexes, but see if we need to run AFTER ROW INSERT triggers
+	 * anyway.
+	 */
+	else if (resultRelInfo->ri_TrigDesc != NULL &&
+			 (resultRelInfo->ri_TrigDesc->trig_insert_after_row ||
+			  resultRelInfo->ri_TrigDesc->trig_insert_new_table))
+	{
+		for (i = 0; i < nused; i++)
+		{
+			cstate->cur_lineno = buffer->linenos[i];
+			ExecStoreHeapTuple(buffer->tuples[i], slot, false);
+			ExecARInsertTriggers(estate, resultRelInfo,
+								 slot,
+								 NIL, cstate->transition_capture);
+		}
+	}
+
+	/* The tuples themselves are freed by our caller */
+	ExecClearTuple(slot);
+	buffer->nused = 0;
+
+	/* reset everything we changed to what it was */
+	estate->es_result_relation_info = save_resultRelInfo;
+	cstate->line_buf_valid = line_buf_valid;
+	cstate->cur_lineno = save_cur_lineno;
+}
+
+/*
+ * Free this buffer and its bulk insert state.
+ *
+ * The buffer must be flushed before cleanup.
+ */
+static inline void
+CopyMultiInsertBufferCleanup(CopyMultiInsertBuffer *buffer)
+{
+	/* Ensure buffer was flushed */
+	Assert(buffer->nused == 0);
+
+	/* Remove back-link to ourself */
+	buffer->resultRelInfo->ri_CopyMultiInsertBuffer = NULL;
+
+	FreeBulkInsertState(buffer->bistate);
+
+	pfree(buffer);
+}
+
+/*
+ * Write out all stored tuples in all buffers out to the tables.
+ *
+ * Once flushed we also trim the tracked buffers list down to size by removing
+ * the buffers created earliest first.  The buffer of 'curr_rri', the
+ * relation the current tuple goes to, is never removed.
+ *
+ * The caller is responsible for freeing the memory of the flushed tuples.
+ */
+static inline void
+CopyMultiInsertInfoFlush(CopyMultiInsertInfo *miinfo, ResultRelInfo *curr_rri)
+{
+	ListCell   *lc;
+
+	foreach(lc, miinfo->multiInsertBuffers)
+	{
+		CopyMultiInsertBuffer *buffer = (CopyMultiInsertBuffer *) lfirst(lc);
+
+		CopyMultiInsertBufferFlush(miinfo, buffer);
+	}
+
+	miinfo->bufferedTuples = 0;
+	miinfo->bufferedBytes = 0;
+
+	/*
+	 * Trim the list of tracked buffers down if it exceeds the limit.  The
+	 * buffers created first seem the least likely to be needed again.
+	 */
+	while (list_length(miinfo->multiInsertBuffers) > MAX_PARTITION_BUFFERS)
+	{
+		CopyMultiInsertBuffer *buffer;
+
+		buffer = (CopyMultiInsertBuffer *) linitial(miinfo->multiInsertBuffers);
+
+		/*
+		 * We never want to remove the buffer that's currently being used, so
+		 * if we happen to find that then move it to the end of the list.
+		 */
+		if (buffer->resultRelInfo == curr_rri)
+		{
+			miinfo->multiInsertBuffers = list_delete_first(miinfo->multiInsertBuffers);
+			miinfo->multiInsertBuffers = lappend(miinfo->multiInsertBuffers, buffer);
+			buffer = (CopyMultiInsertBuffer *) linitial(miinfo->multiInsertBuffers);
+		}
+
+		CopyMultiInsertBufferCleanup(buffer);
+		miinfo->multiInsertBuffers = list_delete_first(miinfo->multiInsertBuffers);
+	}
+}
+
+/*
+ * Cleanup allocated buffers and free memory
+ */
+static inline void
+CopyMultiInsertInfoCleanup(CopyMultiInsertInfo *miinfo)
+{
+	ListCell   *lc;
+
+	foreach(lc, miinfo->multiInsertBuffers)
+		CopyMultiInsertBufferCleanup(lfirst(lc));
+
+	list_free(miinfo->multiInsertBuffers);
+	miinfo->multiInsertBuffers = NIL;
+}
+
+/*
+ * Add a tuple to the buffer of the relation it goes to.  The tuple must stay
+ * valid until the buffers are next flushed.
+ */
+static inline void
+CopyMultiInsertInfoStore(CopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
+						 HeapTuple tuple, uint64 lineno)
+{
+	CopyMultiInsertBuffer *buffer = rri->ri_CopyMultiInsertBuffer;
+
+	Assert(buffer != NULL);
+	Assert(buffer->nused < MAX_BUFFERED_TUPLES);
+
+	buffer->tuples[buffer->nused] = tuple;
+	buffer->linenos[buffer->nused] = lineno;
+	buffer->nused++;
+
+	/* Update how many tuples are stored and their size */
+	miinfo->bufferedTuples++;
+	miinfo->bufferedBytes += tuple->t_len;
+}
+
 /*
  * Copy FROM file to relation.
  */
@@ -2317,6 +2726,7 @@ CopyFrom(CopyState cstate)
 	ResultRelInfo *target_resultRelInfo;
 	ResultRelInfo *prevResultRelInfo = NULL;
 	EState	   *estate = CreateExecutorState(); /* for ExecConstraints() */
+	CopyMultiInsertInfo multiInsertInfo = {0};	/* pacify compiler */
 	ModifyTableState *mtstate;
 	ExprContext *econtext;
 	TupleTableSlot *myslot;
@@ -2330,20 +2740,10 @@ CopyFrom(CopyState cstate)
 	BulkInsertState bistate;
 	CopyInsertMethod insertMethod;
 	uint64		processed = 0;
-	int			nBufferedTuples = 0;
 	bool		has_before_insert_row_trig;
 	bool		has_instead_insert_row_trig;
 	bool		leafpart_use_multi_insert = false;
 
-#define MAX_BUFFERED_TUPLES 1000
-#define RECHECK_MULTI_INSERT_THRESHOLD 1000
-	HeapTuple  *bufferedTuples = NULL;	/* initialize to silence warning */
-	Size		bufferedTuplesSize = 0;
-	uint64		firstBufferedLineNo = 0;
-	uint64		lastPartitionSampleLineNo = 0;
-	uint64		nPartitionChanges = 0;
-	double		avgTuplesPerPartChange = 0;
-
 	Assert(cstate->rel);
 
 	/*
@@ -2587,8 +2987,8 @@ CopyFrom(CopyState cstate)
 		 * For partitioned tables we can't support multi-inserts when there
 		 * are any statement level insert triggers. It might be possible to
 		 * allow partitioned tables with such triggers in the future, but for
-		 * now, CopyFromInsertBatch expects that any before row insert and
-		 * statement level insert triggers are on the same relation.
+		 * now, CopyMultiInsertBufferFlush expects that any before row insert
+		 * and statement level insert triggers are on the same relation.
 		 */
 		insertMethod = CIM_SINGLE;
 	}
@@ -2620,8 +3020,7 @@ CopyFrom(CopyState cstate)
 	{
 		/*
 		 * For partitioned tables, we may still be able to perform bulk
-		 * inserts for sets of consecutive tuples which belong to the same
-		 * partition.  However, the possibility of this depends on which types
+		 * inserts.  However, the possibility of this depends on which types
 		 * of triggers exist on the partition.  We must disable bulk inserts
 		 * if the partition is a foreign table or it has any before row insert
 		 * or insert instead triggers (same as we checked above for the parent
@@ -2630,18 +3029,14 @@ CopyFrom(CopyState cstate)
 		 * have the intermediate insert method of CIM_MULTI_CONDITIONAL to
 		 * flag that we must later determine if we can use bulk-inserts for
 		 * the partition being inserted into.
-		 *
-		 * Normally, when performing bulk inserts we just flush the insert
-		 * buffer whenever it becomes full, but for the partitioned table
-		 * case, we flush it whenever the current tuple does not belong to the
-		 * same partition as the previous tuple.
 		 */
 		if (proute)
 			insertMethod = CIM_MULTI_CONDITIONAL;
 		else
 			insertMethod = CIM_MULTI;
 
-		bufferedTuples = palloc(MAX_BUFFERED_TUPLES * sizeof(HeapTuple));
+		CopyMultiInsertInfoInit(&multiInsertInfo, resultRelInfo, myslot,
+								cstate, estate, mycid, hi_options);
 	}
 
 	has_before_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
@@ -2691,6 +3086,14 @@ CopyFrom(CopyState cstate)
 		 */
 		ResetPerTupleExprContext(estate);
 
+		/*
+		 * Free the tuples formed so far, unless some are still waiting in
+		 * the multi-insert buffers.  Tuples that were inserted one at a time
+		 * are not needed past the iteration that formed them.
+		 */
+		if (CopyMultiInsertInfoIsEmpty(&multiInsertInfo))
+			MemoryContextReset(batchcontext);
+
 		/*
 		 * Switch to per-tuple context before calling NextCopyFrom, which does
 		 * evaluate default expressions etc. and requires per-tuple context.
@@ -2741,76 +3144,6 @@ CopyFrom(CopyState cstate)
 
 			if (prevResultRelInfo != resultRelInfo)
 			{
-				/* Check if we can multi-insert into this partition */
-				if (insertMethod == CIM_MULTI_CONDITIONAL)
-				{
-					/*
-					 * When performing bulk-inserts into partitioned tables we
-					 * must insert the tuples seen so far to the heap whenever
-					 * the partition changes.
-					 */
-					if (nBufferedTuples > 0)
-					{
-						MemoryContext	oldcontext;
-
-						CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-											prevResultRelInfo, myslot, bistate,
-											nBufferedTuples, bufferedTuples,
-											firstBufferedLineNo);
-						nBufferedTuples = 0;
-						bufferedTuplesSize = 0;
-
-						/*
-						 * The tuple is already allocated in the batch context, which
-						 * we want to reset.  So to keep the tuple we copy it into the
-						 * short-lived (per-tuple) context, reset the batch context
-						 * and then copy it back into the per-batch one.
-						 */
-						oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-						tuple = heap_copytuple(tuple);
-						MemoryContextSwitchTo(oldcontext);
-
-						/* cleanup the old batch */
-						MemoryContextReset(batchcontext);
-
-						/* copy the tuple back to the per-batch context */
-						oldcontext = MemoryContextSwitchTo(batchcontext);
-						tuple = heap_copytuple(tuple);
-						MemoryContextSwitchTo(oldcontext);
-
-						/*
-						 * Also push the tuple copy to the slot (resetting the context
-						 * invalidated the slot contents).
-						 */
-						ExecStoreHeapTuple(tuple, slot, false);
-					}
-
-					nPartitionChanges++;
-
-					/*
-					 * Here we adaptively enable multi-inserts based on the
-					 * average number of tuples from recent multi-insert
-					 * batches.  We recalculate the average every
-					 * RECHECK_MULTI_INSERT_THRESHOLD tuples instead of taking
-					 * the average over the whole copy.  This allows us to
-					 * enable multi-inserts when we get periods in the copy
-					 * stream that have tuples commonly belonging to the same
-					 * partition, and disable when the partition is changing
-					 * too often.
-					 */
-					if (unlikely(lastPartitionSampleLineNo <= (cstate->cur_lineno -
-															   RECHECK_MULTI_INSERT_THRESHOLD)
-								 && cstate->cur_lineno >= RECHECK_MULTI_INSERT_THRESHOLD))
-					{
-						avgTuplesPerPartChange =
-							(cstate->cur_lineno - lastPartitionSampleLineNo) /
-							(double) nPartitionChanges;
-
-						lastPartitionSampleLineNo = cstate->cur_lineno;
-						nPartitionChanges = 0;
-					}
-				}
-
 				/* Determine which triggers exist on this partition */
 				has_before_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
 											  resultRelInfo->ri_TrigDesc->trig_insert_before_row);
@@ -2819,18 +3152,41 @@ CopyFrom(CopyState cstate)
 											   resultRelInfo->ri_TrigDesc->trig_insert_instead_row);
 
 				/*
-				 * Tests have shown that using multi-inserts when the
-				 * partition changes on every tuple slightly decreases the
-				 * performance, however, there are benefits even when only
-				 * some batches have just 2 tuples, so let's enable
-				 * multi-inserts even when the average is quite low.
+				 * Disable multi-inserts when the partition has BEFORE/INSTEAD
+				 * OF triggers, or if the partition is a foreign partition.
 				 */
 				leafpart_use_multi_insert = insertMethod == CIM_MULTI_CONDITIONAL &&
-					avgTuplesPerPartChange >= 1.3 &&
 					!has_before_insert_row_trig &&
 					!has_instead_insert_row_trig &&
 					resultRelInfo->ri_FdwRoutine == NULL;
 
+				/* Set the multi-insert buffer to use for this partition. */
+				if (leafpart_use_multi_insert)
+				{
+					if (resultRelInfo->ri_CopyMultiInsertBuffer == NULL)
+					{
+						TupleTableSlot *partslot;
+
+						partslot = resultRelInfo->ri_PartitionInfo->pi_PartitionTupleSlot;
+						CopyMultiInsertInfoSetupBuffer(&multiInsertInfo,
+													   resultRelInfo,
+													   partslot ? partslot : myslot);
+					}
+				}
+				else if (insertMethod == CIM_MULTI_CONDITIONAL &&
+						 !CopyMultiInsertInfoIsEmpty(&multiInsertInfo))
+				{
+					/*
+					 * Flush pending inserts if this partition can't use
+					 * batching, so rows are visible to triggers etc.  The
+					 * current tuple is in the batch context too, so leave
+					 * freeing that to the next iteration, but flushing may
+					 * have used myslot, so put the tuple back in it.
+					 */
+					CopyMultiInsertInfoFlush(&multiInsertInfo, resultRelInfo);
+					ExecStoreHeapTuple(tuple, slot, false);
+				}
+
 				/*
 				 * We'd better make the bulk insert mechanism gets a new
 				 * buffer when the partition being inserted into changes.
@@ -2943,30 +3299,15 @@ CopyFrom(CopyState cstate)
 				if (insertMethod == CIM_MULTI || leafpart_use_multi_insert)
 				{
 					/* Add this tuple to the tuple buffer */
-					if (nBufferedTuples == 0)
-						firstBufferedLineNo = cstate->cur_lineno;
-					bufferedTuples[nBufferedTuples++] = tuple;
-					bufferedTuplesSize += tuple->t_len;
+					CopyMultiInsertInfoStore(&multiInsertInfo, resultRelInfo,
+											 tuple, cstate->cur_lineno);
 
 					/*
-					 * If the buffer filled up, flush it.  Also flush if the
-					 * total size of all the tuples in the buffer becomes
-					 * large, to avoid using large amounts of memory for the
-					 * buffer when the tuples are exceptionally wide.
+					 * If enough tuples have been buffered, flush them all.
+					 * The batch context is reset at the top of the loop.
 					 */
-					if (nBufferedTuples == MAX_BUFFERED_TUPLES ||
-						bufferedTuplesSize > 65535)
-					{
-						CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-											resultRelInfo, myslot, bistate,
-											nBufferedTuples, bufferedTuples,
-											firstBufferedLineNo);
-						nBufferedTuples = 0;
-						bufferedTuplesSize = 0;
-
-						/* free memory occupied by tuples from the batch */
-						MemoryContextReset(batchcontext);
-					}
+					if (CopyMultiInsertInfoIsFull(&multiInsertInfo))
+						CopyMultiInsertInfoFlush(&multiInsertInfo, resultRelInfo);
 				}
 				else
 				{
@@ -3026,20 +3367,13 @@ CopyFrom(CopyState cstate)
 	}
 
 	/* Flush any remaining buffered tuples */
-	if (nBufferedTuples > 0)
+	if (insertMethod != CIM_SINGLE)
 	{
-		if (insertMethod == CIM_MULTI_CONDITIONAL)
-		{
-			CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-								prevResultRelInfo, myslot, bistate,
-								nBufferedTuples, bufferedTuples,
-								firstBufferedLineNo);
-		}
-		else
-			CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-								resultRelInfo, myslot, bistate,
-								nBufferedTuples, bufferedTuples,
-								firstBufferedLineNo);
+		if (!CopyMultiInsertInfoIsEmpty(&multiInsertInfo))
+			CopyMultiInsertInfoFlush(&multiInsertInfo, NULL);
+
+		/* Tear down the multi-insert buffer data */
+		CopyMultiInsertInfoCleanup(&multiInsertInfo);
 	}
 
 	/* Done, clean up */
@@ -3097,85 +3431,337 @@ CopyFrom(CopyState cstate)
 }
 
 /*
- * A subroutine of CopyFrom, to write the current batch of buffered heap
- * tuples to the heap. Also updates indexes and runs AFTER ROW INSERT
- * triggers.
+ * Can COPY FROM be done in parallel?
+ *
+ * The workers insert the rows themselves, so everything that happens for
+ * each row must be parallel safe: the input functions, default expressions,
+ * the WHERE clause, and the table's CHECK constraints and index expressions.
+ * We also stay away from anything that needs coordination beyond what the
+ * workers can do on their own: triggers, tuple routing, FREEZE, binary
+ * format, and temporary tables, which workers can't access at all.
  */
-static void
-CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
-					int hi_options, ResultRelInfo *resultRelInfo,
-					TupleTableSlot *myslot, BulkInsertState bistate,
-					int nBufferedTuples, HeapTuple *bufferedTuples,
-					uint64 firstBufferedLineNo)
+static bool
+CopyFromParallelOK(CopyState cstate)
 {
-	MemoryContext oldcontext;
+	List	   *exprs = NIL;
+	ListCell   *cur;
 	int			i;
-	uint64		save_cur_lineno;
-	bool		line_buf_valid = cstate->line_buf_valid;
 
-	/*
-	 * Print error context information correctly, if one of the operations
-	 * below fail.
-	 */
-	cstate->line_buf_valid = false;
-	save_cur_lineno = cstate->cur_lineno;
+	if (cstate->parallel_workers == 0 ||
+		cstate->binary || cstate->freeze ||
+		!IsUnderPostmaster || IsInParallelMode() ||
+		IsolationIsSerializable())
+		return false;
+
+	if (cstate->rel->rd_rel->relkind != RELKIND_RELATION ||
+		cstate->rel->rd_rel->relpersistence == RELPERSISTENCE_TEMP)
+		return false;
+
+	foreach(cur, cstate->attnumlist)
+	{
+		int			attnum = lfirst_int(cur);
+
+		if (func_parallel(cstate->in_functions[attnum - 1].fn_oid) !=
+			PROPARALLEL_SAFE)
+			return false;
+	}
+
+	for (i = 0; i < cstate->num_defaults; i++)
+		exprs = lappend(exprs, cstate->defexprs[i]->expr);
+	if (cstate->whereClause)
+		exprs = lappend(exprs, cstate->whereClause);
+
+	return max_parallel_hazard_for_insert(cstate->rel, (Node *) exprs) ==
+		PROPARALLEL_SAFE;
+}
+
+/*
+ * Copy FROM file to relation, using parallel workers.
+ *
+ * attnamelist and options are passed on to the workers, which set up their
+ * own CopyState from them.  If no workers can be launched, we fall back to
+ * CopyFrom.
+ */
+static uint64
+ParallelCopyFrom(CopyState cstate, List *attnamelist, List *options)
+{
+	ParallelCopyLeader leader;
+	ParallelContext *pcxt;
+	ParallelCopyShared *shared;
+	char	   *copyargs;
+	char	   *sharedargs;
+	char	   *sharedquery;
+	char	   *queuespace;
+	int			querylen;
+	int			nqueues;
+	int			i;
+	uint64		processed;
+	StringInfoData chunk;
+	ErrorContextCallback errcallback;
 
 	/*
-	 * heap_multi_insert leaks memory, so switch to short-lived memory context
-	 * before calling it.
+	 * The workers can't assign the transaction ID or mark the command ID as
+	 * used, so do that before starting them.
 	 */
-	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	heap_multi_insert(resultRelInfo->ri_RelationDesc,
-					  bufferedTuples,
-					  nBufferedTuples,
-					  mycid,
-					  hi_options,
-					  bistate);
-	MemoryContextSwitchTo(oldcontext);
+	(void) GetCurrentTransactionId();
+	(void) GetCurrentCommandId(true);
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "ParallelCopyMain",
+								 cstate->parallel_workers, false);
+	nqueues = pcxt->nworkers;
+
+	copyargs = nodeToString(list_make3(attnamelist, options,
+									   cstate->whereClause));
+
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelCopyShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, strlen(copyargs) + 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(PARALLEL_COPY_QUEUE_SIZE, nqueues));
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+
+	/* Estimate space for the query text, if there is one */
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+	else
+		querylen = 0;			/* keep compiler quiet */
+
+	InitializeParallelDSM(pcxt);
+
+	shared = (ParallelCopyShared *)
+		shm_toc_allocate(pcxt->toc, sizeof(ParallelCopyShared));
+	shared->relid = RelationGetRelid(cstate->rel);
+	pg_atomic_init_u64(&shared->processed, 0);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COPY_SHARED, shared);
+
+	sharedargs = (char *) shm_toc_allocate(pcxt->toc, strlen(copyargs) + 1);
+	strcpy(sharedargs, copyargs);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COPY_ARGS, sharedargs);
+
+	queuespace = (char *)
+		shm_toc_allocate(pcxt->toc,
+						 mul_size(PARALLEL_COPY_QUEUE_SIZE, nqueues));
+	for (i = 0; i < nqueues; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = shm_mq_create(queuespace + (Size) i * PARALLEL_COPY_QUEUE_SIZE,
+						   PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COPY_QUEUES, queuespace);
+
+	if (debug_query_string)
+	{
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	LaunchParallelWorkers(pcxt);
+
+	/* If no workers were successfully launched, do it ourselves */
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return CopyFrom(cstate);
+	}
+
+	leader.pcxt = pcxt;
+	leader.shared = shared;
+	leader.nqueues = pcxt->nworkers_launched;
+	leader.queues = (shm_mq_handle **)
+		palloc(leader.nqueues * sizeof(shm_mq_handle *));
+	for (i = 0; i < leader.nqueues; i++)
+		leader.queues[i] =
+			shm_mq_attach((shm_mq *) (queuespace +
+									  (Size) i * PARALLEL_COPY_QUEUE_SIZE),
+						  pcxt->seg, pcxt->worker[i].bgwhandle);
+	leader.next_queue = 0;
 
 	/*
-	 * If there are any indexes, update them for all the inserted tuples, and
-	 * run AFTER ROW INSERT triggers.
+	 * Set up callback to identify error line number.  It's only installed
+	 * while reading the input, since errors from the workers that we rethrow
+	 * elsewhere carry their own line number.
 	 */
-	if (resultRelInfo->ri_NumIndices > 0)
+	errcallback.callback = CopyFromErrorCallback;
+	errcallback.arg = (void *) cstate;
+
+	/* Split the input into chunks of whole lines, and hand them out */
+	initStringInfo(&chunk);
+	for (;;)
 	{
-		for (i = 0; i < nBufferedTuples; i++)
-		{
-			List	   *recheckIndexes;
+		bool		found;
+		uint32		len;
 
-			cstate->cur_lineno = firstBufferedLineNo + i;
-			ExecStoreHeapTuple(bufferedTuples[i], myslot, false);
-			recheckIndexes =
-				ExecInsertIndexTuples(myslot, &(bufferedTuples[i]->t_self),
-									  estate, false, NULL, NIL);
-			ExecARInsertTriggers(estate, resultRelInfo,
-								 myslot,
-								 recheckIndexes, cstate->transition_capture);
-			list_free(recheckIndexes);
+		CHECK_FOR_INTERRUPTS();
+
+		errcallback.previous = error_context_stack;
+		error_context_stack = &errcallback;
+		found = CopyReadNextLine(cstate);
+		error_context_stack = errcallback.previous;
+
+		if (!found)
+			break;
+
+		len = cstate->line_buf.len;
+
+		appendBinaryStringInfo(&chunk, (char *) &cstate->cur_lineno,
+							   sizeof(uint64));
+		appendBinaryStringInfo(&chunk, (char *) &len, sizeof(uint32));
+		appendBinaryStringInfo(&chunk, cstate->line_buf.data, len);
+
+		if (chunk.len >= PARALLEL_COPY_CHUNK_SIZE)
+		{
+			ParallelCopySendChunk(&leader, &chunk);
+			resetStringInfo(&chunk);
 		}
 	}
+	if (chunk.len > 0)
+		ParallelCopySendChunk(&leader, &chunk);
+	pfree(chunk.data);
 
 	/*
-	 * There's no indexes, but see if we need to run AFTER ROW INSERT triggers
-	 * anyway.
+	 * In the old protocol, tell pqcomm that we can process normal protocol
+	 * messages again.
 	 */
-	else if (resultRelInfo->ri_TrigDesc != NULL &&
-			 (resultRelInfo->ri_TrigDesc->trig_insert_after_row ||
-			  resultRelInfo->ri_TrigDesc->trig_insert_new_table))
+	if (cstate->copy_dest == COPY_OLD_FE)
+		pq_endmsgread();
+
+	/* Detaching tells the workers there's nothing more to come */
+	ParallelCopyDetachQueues(&leader);
+	WaitForParallelWorkersToFinish(pcxt);
+
+	processed = pg_atomic_read_u64(&shared->processed);
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	return processed;
+}
+
+/*
+ * Send a chunk of lines to the next worker in turn.
+ */
+static void
+ParallelCopySendChunk(ParallelCopyLeader *leader, StringInfo chunk)
+{
+	shm_mq_result res;
+
+	res = shm_mq_send(leader->queues[leader->next_queue],
+					  chunk->len, chunk->data, false);
+	if (res != SHM_MQ_SUCCESS)
+	{
+		/*
+		 * The worker is gone, most likely because it failed.  Let the others
+		 * finish, so that we can report its error.
+		 */
+		ParallelCopyDetachQueues(leader);
+		WaitForParallelWorkersToFinish(leader->pcxt);
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("parallel COPY worker exited unexpectedly")));
+	}
+
+	leader->next_queue = (leader->next_queue + 1) % leader->nqueues;
+}
+
+/*
+ * Detach from all the chunk queues, if not done already.
+ */
+static void
+ParallelCopyDetachQueues(ParallelCopyLeader *leader)
+{
+	int			i;
+
+	for (i = 0; i < leader->nqueues; i++)
 	{
-		for (i = 0; i < nBufferedTuples; i++)
+		if (leader->queues[i] != NULL)
 		{
-			cstate->cur_lineno = firstBufferedLineNo + i;
-			ExecStoreHeapTuple(bufferedTuples[i], myslot, false);
-			ExecARInsertTriggers(estate, resultRelInfo,
-								 myslot,
-								 NIL, cstate->transition_capture);
+			shm_mq_detach(leader->queues[i]);
+			leader->queues[i] = NULL;
 		}
 	}
+}
 
-	/* reset cur_lineno and line_buf_valid to what they were */
-	cstate->line_buf_valid = line_buf_valid;
-	cstate->cur_lineno = save_cur_lineno;
+/*
+ * Data source for the CopyState of a parallel COPY FROM worker.  It is never
+ * used, since the lines come from the leader instead.
+ */
+static int
+ParallelCopyNoData(void *outbuf, int minread, int maxread)
+{
+	elog(ERROR, "parallel COPY worker cannot read input data");
+	return 0;					/* keep compiler quiet */
+}
+
+/*
+ * Perform work within a launched parallel COPY FROM worker.
+ */
+void
+ParallelCopyMain(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelCopyShared *shared;
+	List	   *copyargs;
+	char	   *queuespace;
+	shm_mq	   *mq;
+	ParseState *pstate;
+	Relation	rel;
+	CopyState	cstate;
+	uint64		processed;
+
+	/* The leader prepared the transaction for our inserts */
+	AllowParallelWorkerInserts();
+
+	/* Set debug_query_string for individual workers first */
+	debug_query_string = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, true);
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	shared = shm_toc_lookup(toc, PARALLEL_KEY_COPY_SHARED, false);
+	copyargs = (List *)
+		stringToNode(shm_toc_lookup(toc, PARALLEL_KEY_COPY_ARGS, false));
+
+	/* Attach to our chunk queue */
+	queuespace = shm_toc_lookup(toc, PARALLEL_KEY_COPY_QUEUES, false);
+	mq = (shm_mq *) (queuespace +
+					 (Size) ParallelWorkerNumber * PARALLEL_COPY_QUEUE_SIZE);
+	shm_mq_set_receiver(mq, MyProc);
+
+	/* Open the table with the lock mode DoCopy uses */
+	rel = table_open(shared->relid, RowExclusiveLock);
+
+	pstate = make_parsestate(NULL);
+	pstate->p_sourcetext = debug_query_string;
+	addRangeTableEntryForRelation(pstate, rel, RowExclusiveLock,
+								  NULL, false, false);
+
+	cstate = BeginCopyFrom(pstate, rel, NULL, false, ParallelCopyNoData,
+						   linitial(copyargs), lsecond(copyargs));
+	cstate->whereClause = lthird(copyargs);
+
+	/*
+	 * The leader already skipped the header line and converted the lines to
+	 * server encoding.
+	 */
+	cstate->header_line = false;
+	cstate->file_encoding = GetDatabaseEncoding();
+	cstate->need_transcoding = false;
+	cstate->encoding_embeds_ascii = false;
+	cstate->chunk_mqh = shm_mq_attach(mq, seg, NULL);
+
+	processed = CopyFrom(cstate);
+	pg_atomic_add_fetch_u64(&shared->processed, processed);
+
+	EndCopyFrom(cstate);
+	free_parsestate(pstate);
+	table_close(rel, RowExclusiveLock);
 }
 
 /*
@@ -3441,30 +4027,12 @@ bool
 NextCopyFromRawFields(CopyState cstate, char ***fields, int *nfields)
 {
 	int			fldct;
-	bool		done;
 
 	/* only available for text or csv input */
 	Assert(!cstate->binary);
 
-	/* on input just throw the header line away */
-	if (cstate->cur_lineno == 0 && cstate->header_line)
-	{
-		cstate->cur_lineno++;
-		if (CopyReadLine(cstate))
-			return false;		/* done */
-	}
-
-	cstate->cur_lineno++;
-
 	/* Actually read the line into memory here */
-	done = CopyReadLine(cstate);
-
-	/*
-	 * EOF at start of line means we're done.  If we see EOF after some
-	 * characters, we act as though it was newline followed by EOF, ie,
-	 * process the line and then exit loop on next iteration.
-	 */
-	if (done && cstate->line_buf.len == 0)
+	if (!CopyReadNextLine(cstate))
 		return false;
 
 	/* Parse the line into de-escaped field values */
@@ -3685,6 +4253,35 @@ EndCopyFrom(CopyState cstate)
 	EndCopy(cstate);
 }
 
+/*
+ * Read the next line of text or csv input into line_buf, skipping the header
+ * line if there is one.  Return false if no more lines.
+ */
+static bool
+CopyReadNextLine(CopyState cstate)
+{
+	bool		done;
+
+	/* on input just throw the header line away */
+	if (cstate->cur_lineno == 0 && cstate->header_line)
+	{
+		cstate->cur_lineno++;
+		if (CopyReadLine(cstate))
+			return false;		/* done */
+	}
+
+	cstate->cur_lineno++;
+
+	done = CopyReadLine(cstate);
+
+	/*
+	 * EOF at start of line means we're done.  If we see EOF after some
+	 * characters, we act as though it was newline followed by EOF, ie,
+	 * process the line and then exit loop on next iteration.
+	 */
+	return !(done && cstate->line_buf.len == 0);
+}
+
 /*
  * Read the next input line and stash it in line_buf, with conversion to
  * server encoding.
@@ -3701,6 +4298,14 @@ CopyReadLine(CopyState cstate)
 	resetStringInfo(&cstate->line_buf);
 	cstate->line_buf_valid = true;
 
+	/* In a parallel worker, the leader did all the work already */
+	if (cstate->chunk_mqh != NULL)
+	{
+		result = CopyReadLineFromChunk(cstate);
+		cstate->line_buf_converted = true;
+		return result;
+	}
+
 	/* Mark that encoding conversion hasn't occurred yet */
 	cstate->line_buf_converted = false;
 
@@ -3779,6 +4384,48 @@ CopyReadLine(CopyState cstate)
 	return result;
 }
 
+/*
+ * CopyReadLineFromChunk - CopyReadLine for a parallel COPY FROM worker
+ *
+ * Copies the next line of the current chunk into line_buf and sets
+ * cur_lineno to its line number, receiving a new chunk from the leader first
+ * if needed.  Returns true with an empty line_buf once the leader has sent
+ * everything.
+ */
+static bool
+CopyReadLineFromChunk(CopyState cstate)
+{
+	uint32		len;
+
+	if (cstate->chunk_pos >= cstate->chunk_len)
+	{
+		shm_mq_result res;
+		Size		nbytes;
+		void	   *data;
+
+		res = shm_mq_receive(cstate->chunk_mqh, &nbytes, &data, false);
+		if (res == SHM_MQ_DETACHED)
+			return true;
+		Assert(res == SHM_MQ_SUCCESS);
+
+		cstate->chunk_data = data;
+		cstate->chunk_len = nbytes;
+		cstate->chunk_pos = 0;
+	}
+
+	memcpy(&cstate->cur_lineno, cstate->chunk_data + cstate->chunk_pos,
+		   sizeof(uint64));
+	cstate->chunk_pos += sizeof(uint64);
+	memcpy(&len, cstate->chunk_data + cstate->chunk_pos, sizeof(uint32));
+	cstate->chunk_pos += sizeof(uint32);
+	Assert(cstate->chunk_pos + len <= cstate->chunk_len);
+	appendBinaryStringInfo(&cstate->line_buf,
+						   cstate->chunk_data + cstate->chunk_pos, len);
+	cstate->chunk_pos += len;
+
+	return false;
+}
+
 /*
  * CopyReadLineText - inner loop of CopyReadLine for text mode
  */
@@ -3792,6 +4439,9 @@ CopyReadLineText(CopyState cstate)
 	bool		hit_eof = false;
 	bool		result = false;
 	char		mblen_str[2];
+	int			vector_scan_from = 0;
+	char		vector_specialc1 = '\\';
+	char		vector_specialc2 = '\\';
 
 	/* CSV variables */
 	bool		first_char_in_line = true;
@@ -3807,6 +4457,10 @@ CopyReadLineText(CopyState cstate)
 		/* ignore special escape processing if it's the same as quotec */
 		if (quotec == escapec)
 			escapec = '\0';
+
+		/* the vectorized scan below must also stop at these */
+		vector_specialc1 = quotec;
+		vector_specialc2 = escapec ? escapec : quotec;
 	}
 
 	mblen_str[1] = '\0';
@@ -3831,6 +4485,11 @@ CopyReadLineText(CopyState cstate)
 	 *
 	 * For a little extra speed within the loop, we copy raw_buf and
 	 * raw_buf_len into local variables.
+	 *
+	 * Most characters need no processing at all, so before looking at them
+	 * one at a time we skip over runs of uninteresting ones a vector at a
+	 * time.  vector_scan_from is where the last vector that did contain
+	 * something interesting ends; there's no point trying again before then.
 	 */
 	copy_raw_buf = cstate->raw_buf;
 	raw_buf_ptr = cstate->raw_buf_index;
@@ -3863,6 +4522,7 @@ CopyReadLineText(CopyState cstate)
 				hit_eof = true;
 			raw_buf_ptr = 0;
 			copy_buf_len = cstate->raw_buf_len;
+			vector_scan_from = 0;
 
 			/*
 			 * If we are completely out of data, break out of the loop,
@@ -3876,6 +4536,45 @@ CopyReadLineText(CopyState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip over whole vectors that contain no newline, backslash, or (in
+		 * CSV mode) quote or escape character.  If the encoding could embed
+		 * any of those in a multibyte character, we must also stop at
+		 * anything that might start one.  The skipped characters cannot
+		 * change the CSV quoting state, except to end an escape sequence.
+		 */
+		if (raw_buf_ptr >= vector_scan_from)
+		{
+			int			start_ptr = raw_buf_ptr;
+
+			while (raw_buf_ptr + (int) sizeof(Vector8) <= copy_buf_len)
+			{
+				Vector8		chunk;
+
+				vector8_load(&chunk, (const uint8 *) &copy_raw_buf[raw_buf_ptr]);
+				if (vector8_has(chunk, '\n') ||
+					vector8_has(chunk, '\r') ||
+					vector8_has(chunk, '\\') ||
+					vector8_has(chunk, (uint8) vector_specialc1) ||
+					vector8_has(chunk, (uint8) vector_specialc2) ||
+					(cstate->encoding_embeds_ascii &&
+					 vector8_is_highbit_set(chunk)))
+				{
+					vector_scan_from = raw_buf_ptr + sizeof(Vector8);
+					break;
+				}
+				raw_buf_ptr += sizeof(Vector8);
+			}
+
+			if (raw_buf_ptr > start_ptr)
+			{
+				first_char_in_line = false;
+				last_was_esc = false;
+				if (raw_buf_ptr >= copy_buf_len)
+					continue;
+			}
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = raw_buf_ptr;
 		c = copy_raw_buf[raw_buf_ptr++];
@@ -4245,7 +4944,23 @@ CopyReadAttributesText(CopyState cstate)
 		 * de-escaping is actually the right thing to do; therefore we *must
 		 * not* throw any syntax errors before we've done the null-marker
 		 * check.
+		 *
+		 * Fields without a delimiter or backslash in their first bytes are
+		 * common enough that we first copy those a vector at a time.
 		 */
+		while (line_end_ptr - cur_ptr >= (int) sizeof(Vector8))
+		{
+			Vector8		chunk;
+
+			vector8_load(&chunk, (const uint8 *) cur_ptr);
+			if (vector8_has(chunk, (uint8) delimc) ||
+				vector8_has(chunk, '\\'))
+				break;
+			memcpy(output_ptr, cur_ptr, sizeof(Vector8));
+			output_ptr += sizeof(Vector8);
+			cur_ptr += sizeof(Vector8);
+		}
+
 		for (;;)
 		{
 			char		c;
@@ -4471,12 +5186,28 @@ CopyReadAttributesCSV(CopyState cstate)
 		 * The loop starts in "not quote" mode and then toggles between that
 		 * and "in quote" mode. The loop exits normally if it is in "not
 		 * quote" mode and a delimiter or line end is seen.
+		 *
+		 * On entering either mode, we first copy a vector at a time as long
+		 * as there is nothing that could make us leave it.
 		 */
 		for (;;)
 		{
 			char		c;
 
 			/* Not in quote */
+			while (line_end_ptr - cur_ptr >= (int) sizeof(Vector8))
+			{
+				Vector8		chunk;
+
+				vector8_load(&chunk, (const uint8 *) cur_ptr);
+				if (vector8_has(chunk, (uint8) delimc) ||
+					vector8_has(chunk, (uint8) quotec))
+					break;
+				memcpy(output_ptr, cur_ptr, sizeof(Vector8));
+				output_ptr += sizeof(Vector8);
+				cur_ptr += sizeof(Vector8);
+			}
+
 			for (;;)
 			{
 				end_ptr = cur_ptr;
@@ -4500,6 +5231,19 @@ CopyReadAttributesCSV(CopyState cstate)
 			}
 
 			/* In quote */
+			while (line_end_ptr - cur_ptr >= (int) sizeof(Vector8))
+			{
+				Vector8		chunk;
+
+				vector8_load(&chunk, (const uint8 *) cur_ptr);
+				if (vector8_has(chunk, (uint8) quotec) ||
+					vector8_has(chunk, (uint8) escapec))
+					break;
+				memcpy(output_ptr, cur_ptr, sizeof(Vector8));
+				output_ptr += sizeof(Vector8);
+				cur_ptr += sizeof(Vector8);
+			}
+
 			for (;;)
 			{
 				end_ptr = cur_ptr;
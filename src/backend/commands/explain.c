@@ -79,6 +79,8 @@ static void show_upper_qual(List *qual, const char *qlabel,
 				ExplainState *es);
 static void show_sort_keys(SortState *sortstate, List *ancestors,
 			   ExplainState *es);
+static void show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+						   List *ancestors, ExplainState *es);
 static void show_merge_append_keys(MergeAppendState *mstate, List *ancestors,
 					   ExplainState *es);
 static void show_agg_keys(AggState *astate, List *ancestors,
@@ -100,7 +102,14 @@ static void show_sortorder_options(StringInfo buf, Node *sortexpr,
 static void show_tablesample(TableSampleClause *tsc, PlanState *planstate,
 				 List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
+static void show_incremental_sort_info(IncrementalSortState *incrsortstate,
+						   ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
+static void show_hashagg_info(AggState *aggstate, ExplainState *es);
+static void show_resultcache_info(ResultCacheState *rcstate, List *ancestors,
+					  ExplainState *es);
+static void show_bloom_filter(SeqScanState *sstate, List *ancestors,
+				  ExplainState *es);
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
 					ExplainState *es);
 static void show_instrumentation_count(const char *qlabel, int which,
@@ -1139,6 +1148,12 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Sort:
 			pname = sname = "Sort";
 			break;
+		case T_IncrementalSort:
+			pname = sname = "Incremental Sort";
+			break;
+		case T_ResultCache:
+			pname = sname = "Result Cache";
+			break;
 		case T_Group:
 			pname = sname = "Group";
 			break;
@@ -1243,6 +1258,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		}
 		if (plan->parallel_aware)
 			appendStringInfoString(es->str, "Parallel ");
+		if (plan->async_capable)
+			appendStringInfoString(es->str, "Async ");
 		appendStringInfoString(es->str, pname);
 		es->indent++;
 	}
@@ -1262,6 +1279,7 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		if (custom_name)
 			ExplainPropertyText("Custom Plan Provider", custom_name, es);
 		ExplainPropertyBool("Parallel Aware", plan->parallel_aware, es);
+		ExplainPropertyBool("Async Capable", plan->async_capable, es);
 	}
 
 	switch (nodeTag(plan))
@@ -1551,12 +1569,19 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (es->analyze)
 				show_tidbitmap_info((BitmapHeapScanState *) planstate, es);
 			break;
+		case T_SeqScan:
+			show_scan_qual(plan->qual, "Filter", planstate, ancestors, es);
+			if (plan->qual)
+				show_instrumentation_count("Rows Removed by Filter", 1,
+										   planstate, es);
+			show_bloom_filter(castNode(SeqScanState, planstate), ancestors,
+							  es);
+			break;
 		case T_SampleScan:
 			show_tablesample(((SampleScan *) plan)->tablesample,
 							 planstate, ancestors, es);
 			/* fall through to print additional fields the same as SeqScan */
 			/* FALLTHROUGH */
-		case T_SeqScan:
 		case T_ValuesScan:
 		case T_CteScan:
 		case T_NamedTuplestoreScan:
@@ -1753,6 +1778,7 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			show_hashagg_info((AggState *) planstate, es);
 			break;
 		case T_Group:
 			show_group_keys(castNode(GroupState, planstate), ancestors, es);
@@ -1763,8 +1789,22 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			break;
 		case T_Sort:
 			show_sort_keys(castNode(SortState, planstate), ancestors, es);
+			if (plan->parallel_aware)
+				ExplainPropertyInteger("Merge Ranges", NULL,
+									   list_length(((Sort *) plan)->rangeBounds) + 1,
+									   es);
 			show_sort_info(castNode(SortState, planstate), es);
 			break;
+		case T_IncrementalSort:
+			show_incremental_sort_keys(castNode(IncrementalSortState, planstate),
+									   ancestors, es);
+			show_incremental_sort_info(castNode(IncrementalSortState, planstate),
+									   es);
+			break;
+		case T_ResultCache:
+			show_resultcache_info(castNode(ResultCacheState, planstate),
+								  ancestors, es);
+			break;
 		case T_MergeAppend:
 			show_merge_append_keys(castNode(MergeAppendState, planstate),
 								   ancestors, es);
@@ -2105,6 +2145,27 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
 						 ancestors, es);
 }
 
+/*
+ * Show the sort keys for an IncrementalSort node, along with the prefix of
+ * them by which the input is already sorted.
+ */
+static void
+show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+						   List *ancestors, ExplainState *es)
+{
+	IncrementalSort *plan = (IncrementalSort *) incrsortstate->ss.ps.plan;
+
+	show_sort_group_keys((PlanState *) incrsortstate, "Sort Key",
+						 plan->sort.numCols, plan->sort.sortColIdx,
+						 plan->sort.sortOperators, plan->sort.collations,
+						 plan->sort.nullsFirst,
+						 ancestors, es);
+	show_sort_group_keys((PlanState *) incrsortstate, "Presorted Key",
+						 plan->nPresortedCols, plan->sort.sortColIdx,
+						 NULL, NULL, NULL,
+						 ancestors, es);
+}
+
 /*
  * Likewise, for a MergeAppend node.
  */
@@ -2639,6 +2700,188 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 	}
 }
 
+/*
+ * Show information on hash aggregate memory usage and batches.
+ */
+static void
+show_hashagg_info(AggState *aggstate, ExplainState *es)
+{
+	Agg		   *agg = (Agg *) aggstate->ss.ps.plan;
+	long		memPeakKb = (aggstate->hash_mem_peak + 1023) / 1024;
+	long		diskKb = (aggstate->hash_disk_used + 1023) / 1024;
+
+	if (!es->analyze)
+		return;
+
+	if (agg->aggstrategy != AGG_HASHED &&
+		agg->aggstrategy != AGG_MIXED)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("HashAgg Batches", NULL,
+							   aggstate->hash_batches_used, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
+		ExplainPropertyInteger("Disk Usage", "kB", diskKb, es);
+	}
+	else
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "Batches: %d  Memory Usage: %ldkB",
+						 aggstate->hash_batches_used, memPeakKb);
+		if (aggstate->hash_ever_spilled)
+			appendStringInfo(es->str, "  Disk Usage: %ldkB", diskKb);
+		appendStringInfoChar(es->str, '\n');
+	}
+}
+
+/*
+ * If it's EXPLAIN ANALYZE, show the number of sort batches and the space used
+ * by the largest of them for an IncrementalSort node
+ */
+static void
+show_incremental_sort_info(IncrementalSortState *incrsortstate,
+						   ExplainState *es)
+{
+	if (!es->analyze || incrsortstate->batches == 0)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("Sort Batches", NULL,
+							   incrsortstate->batches, es);
+		ExplainPropertyInteger("Peak Sort Space Used", "kB",
+							   incrsortstate->peakMemorySpace, es);
+		ExplainPropertyInteger("Peak Sort Disk Used", "kB",
+							   incrsortstate->peakDiskSpace, es);
+	}
+	else
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "Sort Batches: " INT64_FORMAT "  Peak Memory: %ldkB",
+						 incrsortstate->batches,
+						 incrsortstate->peakMemorySpace);
+		if (incrsortstate->peakDiskSpace > 0)
+			appendStringInfo(es->str, "  Peak Disk: %ldkB",
+							 incrsortstate->peakDiskSpace);
+		appendStringInfoChar(es->str, '\n');
+	}
+}
+
+/*
+ * Show the cache key of a ResultCache node, and its cache statistics if it's
+ * EXPLAIN ANALYZE
+ */
+static void
+show_resultcache_info(ResultCacheState *rcstate, List *ancestors,
+					  ExplainState *es)
+{
+	Plan	   *plan = ((PlanState *) rcstate)->plan;
+	ListCell   *lc;
+	List	   *context;
+	StringInfoData keystr;
+	char	   *separator = "";
+	bool		useprefix;
+	long		memPeakKb;
+
+	initStringInfo(&keystr);
+
+	/* Set up deparsing context */
+	context = set_deparse_context_planstate(es->deparse_cxt,
+											(Node *) rcstate,
+											ancestors);
+	useprefix = list_length(es->rtable) > 1;
+
+	foreach(lc, ((ResultCache *) plan)->param_exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		appendStringInfoString(&keystr, separator);
+
+		appendStringInfoString(&keystr, deparse_expression(expr, context,
+														   useprefix, false));
+		separator = ", ";
+	}
+
+	ExplainPropertyText("Cache Key", keystr.data, es);
+
+	pfree(keystr.data);
+
+	if (!es->analyze)
+		return;
+
+	/*
+	 * mem_peak is only set when we freed memory, so we must use mem_used when
+	 * mem_peak is 0.
+	 */
+	if (rcstate->stats.mem_peak > 0)
+		memPeakKb = (rcstate->stats.mem_peak + 1023) / 1024;
+	else
+		memPeakKb = (rcstate->mem_used + 1023) / 1024;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("Cache Hits", NULL,
+							   rcstate->stats.cache_hits, es);
+		ExplainPropertyInteger("Cache Misses", NULL,
+							   rcstate->stats.cache_misses, es);
+		ExplainPropertyInteger("Cache Evictions", NULL,
+							   rcstate->stats.cache_evictions, es);
+		ExplainPropertyInteger("Cache Overflows", NULL,
+							   rcstate->stats.cache_overflows, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
+	}
+	else
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT
+						 "  Evictions: " UINT64_FORMAT
+						 "  Overflows: " UINT64_FORMAT
+						 "  Memory Usage: %ldkB\n",
+						 rcstate->stats.cache_hits,
+						 rcstate->stats.cache_misses,
+						 rcstate->stats.cache_evictions,
+						 rcstate->stats.cache_overflows,
+						 memPeakKb);
+	}
+}
+
+/*
+ * Show the keys a SeqScan uses to probe its parent hash join's bloom filter,
+ * and if it's EXPLAIN ANALYZE, the number of rows the filter removed.
+ */
+static void
+show_bloom_filter(SeqScanState *sstate, List *ancestors, ExplainState *es)
+{
+	SeqScan    *plan = (SeqScan *) sstate->ss.ps.plan;
+	List	   *context;
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	if (plan->bloomkeys == NIL)
+		return;
+
+	/* Set up deparsing context */
+	context = set_deparse_context_planstate(es->deparse_cxt,
+											(Node *) sstate,
+											ancestors);
+
+	foreach(lc, plan->bloomkeys)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		result = lappend(result,
+						 deparse_expression(expr, context, es->verbose,
+											false));
+	}
+
+	ExplainPropertyList("Bloom Filter Keys", result, es);
+
+	show_instrumentation_count("Rows Removed by Bloom Filter", 2,
+							   (PlanState *) sstate, es);
+}
+
 /*
  * If it's EXPLAIN ANALYZE, show exact/lossy pages for a BitmapHeapScan node
  */
@@ -2840,6 +3083,11 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage)
 				if (usage->temp_blks_written > 0)
 					appendStringInfo(es->str, " written=%ld",
 									 usage->temp_blks_written);
+				if (usage->temp_compressed_bytes > 0)
+					appendStringInfo(es->str,
+									 " uncompressed=" INT64_FORMAT "kB compressed=" INT64_FORMAT "kB",
+									 (usage->temp_uncompressed_bytes + 1023) / 1024,
+									 (usage->temp_compressed_bytes + 1023) / 1024);
 			}
 			appendStringInfoChar(es->str, '\n');
 		}
@@ -2880,6 +3128,12 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage)
 							   usage->temp_blks_read, es);
 		ExplainPropertyInteger("Temp Written Blocks", NULL,
 							   usage->temp_blks_written, es);
+		ExplainPropertyInteger("Temp Uncompressed", "kB",
+							   (usage->temp_uncompressed_bytes + 1023) / 1024,
+							   es);
+		ExplainPropertyInteger("Temp Compressed", "kB",
+							   (usage->temp_compressed_bytes + 1023) / 1024,
+							   es);
 		if (track_io_timing)
 		{
 			ExplainPropertyFloat("I/O Read Time", "ms",
@@ -120,6 +120,22 @@ PrepareQuery(PrepareStmt *stmt, const char *queryString,
 		}
 	}
 
+	/*
+	 * If the shared plan cache is enabled, another session might have
+	 * analyzed the same statement already, in which case we're done.
+	 */
+	if (CompleteCachedPlanFromShared(plansource,
+									 argtypes,
+									 nargs,
+									 CURSOR_OPT_PARALLEL_OK,
+									 true))
+	{
+		StorePreparedStatement(stmt->name,
+							   plansource,
+							   true);
+		return;
+	}
+
 	/*
 	 * Analyze the statement using these parameter types (any parameters
 	 * passed in from above us will not be visible to it), allowing
@@ -0,0 +1,517 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.c
+ *	  Batch evaluation of simple scan quals
+ *
+ * Most scan quals on analytic queries are simple comparisons of a column
+ * with a constant, such as "l_shipdate <= '1998-09-02'" or "x > 10".  When
+ * evaluated through the expression interpreter, each of those costs a round
+ * of step dispatch and an fmgr call per tuple.  Here we instead recognize
+ * such clauses at executor startup, and evaluate them over a whole batch of
+ * tuples at a time: the referenced columns are first deformed into plain
+ * C arrays, then each clause is applied with a tight loop that narrows down
+ * a selection vector of the tuples that still qualify.
+ *
+ * Only comparisons between integer, date, timestamptz and float columns and
+ * a non-null constant are handled.  All of the underlying operators are
+ * leakproof and cannot fail, so it's safe to evaluate them ahead of the
+ * remaining quals.  Everything else is handed back to the caller as the
+ * residual qual, to be evaluated per tuple as usual.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "catalog/pg_type.h"
+#include "executor/execBatch.h"
+#include "executor/executor.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/float.h"
+#include "utils/fmgroids.h"
+#include "utils/rel.h"
+
+
+/*
+ * Comparison functions we know how to evaluate in batch mode.  Within each
+ * family, the argument types differ only in width, which we paper over by
+ * widening everything to int64 or float8.  Note that F_TIMESTAMP_xx are the
+ * timestamptz functions; the plain timestamp ones have no fmgroids symbol.
+ */
+typedef struct BatchCmpFunc
+{
+	Oid			funcid;
+	BatchCmpOp	op;
+} BatchCmpFunc;
+
+#define BATCH_CMP_FAMILY(prefix) \
+	{F_##prefix##EQ, BATCH_CMP_EQ}, \
+	{F_##prefix##NE, BATCH_CMP_NE}, \
+	{F_##prefix##LT, BATCH_CMP_LT}, \
+	{F_##prefix##LE, BATCH_CMP_LE}, \
+	{F_##prefix##GT, BATCH_CMP_GT}, \
+	{F_##prefix##GE, BATCH_CMP_GE}
+
+static const BatchCmpFunc batch_cmp_funcs[] =
+{
+	BATCH_CMP_FAMILY(INT2),
+	BATCH_CMP_FAMILY(INT4),
+	BATCH_CMP_FAMILY(INT8),
+	BATCH_CMP_FAMILY(INT24),
+	BATCH_CMP_FAMILY(INT42),
+	BATCH_CMP_FAMILY(INT28),
+	BATCH_CMP_FAMILY(INT82),
+	BATCH_CMP_FAMILY(INT48),
+	BATCH_CMP_FAMILY(INT84),
+	BATCH_CMP_FAMILY(DATE_),
+	BATCH_CMP_FAMILY(TIMESTAMP_),
+	BATCH_CMP_FAMILY(FLOAT4),
+	BATCH_CMP_FAMILY(FLOAT8),
+	BATCH_CMP_FAMILY(FLOAT48),
+	BATCH_CMP_FAMILY(FLOAT84)
+};
+
+static bool batch_col_type(Oid typid, BatchColType *type);
+static bool batch_qual_clause(BatchQual *bq, Expr *clause, Index scanrelid,
+				  TupleDesc tupdesc);
+static int	batch_qual_column(BatchQual *bq, AttrNumber attno,
+				  BatchColType type);
+
+
+/* ----------------------------------------------------------------
+ *		ExecInitBatchQual
+ *
+ *		Split the implicit-AND qual list of a scan node into the clauses
+ *		that can be evaluated in batch mode and the rest, which are
+ *		returned in *residual.  Returns NULL if there are no batchable
+ *		clauses.  Batches can hold up to maxtuples tuples.
+ * ----------------------------------------------------------------
+ */
+BatchQual *
+ExecInitBatchQual(List *qual, ScanState *node, int maxtuples,
+				  List **residual)
+{
+	Scan	   *scan = (Scan *) node->ps.plan;
+	TupleDesc	tupdesc = RelationGetDescr(node->ss_currentRelation);
+	BatchQual  *bq;
+	ListCell   *lc;
+	int			i;
+
+	Assert(maxtuples > 0 && maxtuples <= PG_UINT16_MAX + 1);
+
+	bq = (BatchQual *) palloc0(sizeof(BatchQual));
+	bq->columns = (BatchQualColumn *)
+		palloc(list_length(qual) * sizeof(BatchQualColumn));
+	bq->clauses = (BatchQualClause *)
+		palloc(list_length(qual) * sizeof(BatchQualClause));
+	bq->maxtuples = maxtuples;
+
+	*residual = NIL;
+	foreach(lc, qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(lc);
+
+		if (!batch_qual_clause(bq, clause, scan->scanrelid, tupdesc))
+			*residual = lappend(*residual, clause);
+	}
+
+	if (bq->nclauses == 0)
+	{
+		pfree(bq->columns);
+		pfree(bq->clauses);
+		pfree(bq);
+		return NULL;
+	}
+
+	for (i = 0; i < bq->ncolumns; i++)
+	{
+		BatchQualColumn *col = &bq->columns[i];
+
+		if (col->isfloat)
+			col->fvals = (float8 *) palloc(maxtuples * sizeof(float8));
+		else
+			col->ivals = (int64 *) palloc(maxtuples * sizeof(int64));
+		col->nulls = (bool *) palloc(maxtuples * sizeof(bool));
+	}
+
+	bq->slot = ExecInitExtraTupleSlot(node->ps.state, tupdesc,
+									  &TTSOpsHeapTuple);
+
+	return bq;
+}
+
+/*
+ * Can the column type be loaded into the batch arrays, and how?
+ */
+static bool
+batch_col_type(Oid typid, BatchColType *type)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			*type = BATCH_COL_INT2;
+			return true;
+		case INT4OID:
+		case DATEOID:
+			*type = BATCH_COL_INT4;
+			return true;
+		case INT8OID:
+		case TIMESTAMPTZOID:
+			*type = BATCH_COL_INT8;
+			return true;
+		case FLOAT4OID:
+			*type = BATCH_COL_FLOAT4;
+			return true;
+		case FLOAT8OID:
+			*type = BATCH_COL_FLOAT8;
+			return true;
+		default:
+			return false;
+	}
+}
+
+#define BATCH_COL_IS_FLOAT(type) \
+	((type) == BATCH_COL_FLOAT4 || (type) == BATCH_COL_FLOAT8)
+
+/* ----------------------------------------------------------------
+ *		ExecGetSimpleCompare
+ *
+ *		If the clause is a "Var op Const" or "Const op Var" comparison of
+ *		the kind that can be evaluated without going through fmgr, fill
+ *		*cmp and return true.  "Const op Var" is reported as the equivalent
+ *		"Var op Const".  It's up to the caller to check that the Var is one
+ *		it can fetch.
+ *
+ *		This is used by the batch quals, and also by the expression
+ *		compiler for its fused comparison steps.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecGetSimpleCompare(Expr *clause, SimpleCompare *cmp)
+{
+	OpExpr	   *opexpr;
+	Var		   *var;
+	Const	   *con;
+	BatchCmpOp	op;
+	BatchColType consttype;
+	bool		commuted;
+	int			i;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	opexpr = (OpExpr *) clause;
+	if (opexpr->opretset || list_length(opexpr->args) != 2)
+		return false;
+
+	if (IsA(linitial(opexpr->args), Var) && IsA(lsecond(opexpr->args), Const))
+	{
+		var = (Var *) linitial(opexpr->args);
+		con = (Const *) lsecond(opexpr->args);
+		commuted = false;
+	}
+	else if (IsA(linitial(opexpr->args), Const) &&
+			 IsA(lsecond(opexpr->args), Var))
+	{
+		con = (Const *) linitial(opexpr->args);
+		var = (Var *) lsecond(opexpr->args);
+		commuted = true;
+	}
+	else
+		return false;
+
+	if (con->constisnull)
+		return false;
+
+	set_opfuncid(opexpr);
+	for (i = 0; i < lengthof(batch_cmp_funcs); i++)
+	{
+		if (batch_cmp_funcs[i].funcid == opexpr->opfuncid)
+			break;
+	}
+	if (i >= lengthof(batch_cmp_funcs))
+		return false;
+	op = batch_cmp_funcs[i].op;
+
+	if (!batch_col_type(var->vartype, &cmp->coltype) ||
+		!batch_col_type(con->consttype, &consttype) ||
+		BATCH_COL_IS_FLOAT(cmp->coltype) != BATCH_COL_IS_FLOAT(consttype))
+		return false;
+
+	if (commuted)
+	{
+		switch (op)
+		{
+			case BATCH_CMP_LT:
+				op = BATCH_CMP_GT;
+				break;
+			case BATCH_CMP_LE:
+				op = BATCH_CMP_GE;
+				break;
+			case BATCH_CMP_GT:
+				op = BATCH_CMP_LT;
+				break;
+			case BATCH_CMP_GE:
+				op = BATCH_CMP_LE;
+				break;
+			default:
+				break;
+		}
+	}
+
+	cmp->var = var;
+	cmp->op = op;
+	cmp->ival = 0;
+	cmp->fval = 0;
+	switch (consttype)
+	{
+		case BATCH_COL_INT2:
+			cmp->ival = DatumGetInt16(con->constvalue);
+			break;
+		case BATCH_COL_INT4:
+			cmp->ival = DatumGetInt32(con->constvalue);
+			break;
+		case BATCH_COL_INT8:
+			cmp->ival = DatumGetInt64(con->constvalue);
+			break;
+		case BATCH_COL_FLOAT4:
+			cmp->fval = DatumGetFloat4(con->constvalue);
+			break;
+		case BATCH_COL_FLOAT8:
+			cmp->fval = DatumGetFloat8(con->constvalue);
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * If the clause is a simple comparison on a column of the scanned relation,
+ * add it to bq and return true.
+ */
+static bool
+batch_qual_clause(BatchQual *bq, Expr *clause, Index scanrelid,
+				  TupleDesc tupdesc)
+{
+	SimpleCompare cmp;
+	Var		   *var;
+	BatchQualClause *bqc;
+
+	if (!ExecGetSimpleCompare(clause, &cmp))
+		return false;
+
+	var = cmp.var;
+	if (var->varno != scanrelid || var->varlevelsup != 0 ||
+		var->varattno <= 0 || var->varattno > tupdesc->natts)
+		return false;
+	if (TupleDescAttr(tupdesc, var->varattno - 1)->atttypid != var->vartype)
+		return false;
+
+	bqc = &bq->clauses[bq->nclauses++];
+	bqc->colno = batch_qual_column(bq, var->varattno, cmp.coltype);
+	bqc->op = cmp.op;
+	bqc->ival = cmp.ival;
+	bqc->fval = cmp.fval;
+
+	return true;
+}
+
+/*
+ * Find or add the batch column for attno, and return its index.
+ */
+static int
+batch_qual_column(BatchQual *bq, AttrNumber attno, BatchColType type)
+{
+	BatchQualColumn *col;
+	int			i;
+
+	for (i = 0; i < bq->ncolumns; i++)
+	{
+		if (bq->columns[i].attno == attno)
+			return i;
+	}
+
+	col = &bq->columns[bq->ncolumns];
+	col->attno = attno;
+	col->type = type;
+	col->isfloat = BATCH_COL_IS_FLOAT(type);
+	col->ivals = NULL;
+	col->fvals = NULL;
+	col->nulls = NULL;
+
+	bq->maxattno = Max(bq->maxattno, attno);
+
+	return bq->ncolumns++;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBatchQualReset
+ *
+ *		Start collecting a new batch.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBatchQualReset(BatchQual *bq)
+{
+	bq->ntuples = 0;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBatchQualAddTuple
+ *
+ *		Deform the columns we need from the tuple into the next slot of
+ *		the batch arrays.  The tuple isn't referenced afterwards.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBatchQualAddTuple(BatchQual *bq, HeapTuple tuple)
+{
+	TupleTableSlot *slot = bq->slot;
+	int			n = bq->ntuples++;
+	int			i;
+
+	Assert(n < bq->maxtuples);
+
+	ExecStoreHeapTuple(tuple, slot, false);
+	slot_getsomeattrs(slot, bq->maxattno);
+
+	for (i = 0; i < bq->ncolumns; i++)
+	{
+		BatchQualColumn *col = &bq->columns[i];
+		Datum		value = slot->tts_values[col->attno - 1];
+
+		col->nulls[n] = slot->tts_isnull[col->attno - 1];
+		if (col->nulls[n])
+			continue;
+
+		switch (col->type)
+		{
+			case BATCH_COL_INT2:
+				col->ivals[n] = DatumGetInt16(value);
+				break;
+			case BATCH_COL_INT4:
+				col->ivals[n] = DatumGetInt32(value);
+				break;
+			case BATCH_COL_INT8:
+				col->ivals[n] = DatumGetInt64(value);
+				break;
+			case BATCH_COL_FLOAT4:
+				col->fvals[n] = DatumGetFloat4(value);
+				break;
+			case BATCH_COL_FLOAT8:
+				col->fvals[n] = DatumGetFloat8(value);
+				break;
+		}
+	}
+
+	ExecClearTuple(slot);
+}
+
+/*
+ * Keep those members of the selection vector that pass "test", which is an
+ * expression over idx.  Tuples with a null column value never pass, since
+ * all the comparison functions are strict.
+ */
+#define BATCH_FILTER(test) \
+	do { \
+		for (i = 0; i < nsel; i++) \
+		{ \
+			int			idx = sel[i]; \
+			\
+			if (!nulls[idx] && (test)) \
+				sel[nkeep++] = idx; \
+		} \
+	} while (0)
+
+/* ----------------------------------------------------------------
+ *		ExecBatchQualEval
+ *
+ *		Evaluate the batch quals over the current batch.  The indexes of
+ *		the tuples that pass all of them are stored in ascending order in
+ *		sel, which must have room for the whole batch, and their number
+ *		is returned.
+ * ----------------------------------------------------------------
+ */
+int
+ExecBatchQualEval(BatchQual *bq, uint16 *sel)
+{
+	int			nsel = bq->ntuples;
+	int			c;
+	int			i;
+
+	for (i = 0; i < nsel; i++)
+		sel[i] = i;
+
+	for (c = 0; c < bq->nclauses && nsel > 0; c++)
+	{
+		BatchQualClause *bqc = &bq->clauses[c];
+		BatchQualColumn *col = &bq->columns[bqc->colno];
+		bool	   *nulls = col->nulls;
+		int			nkeep = 0;
+
+		if (col->isfloat)
+		{
+			float8	   *vals = col->fvals;
+			float8		cval = bqc->fval;
+
+			/* float8_xx() sort NaNs above all other values, as usual */
+			switch (bqc->op)
+			{
+				case BATCH_CMP_EQ:
+					BATCH_FILTER(float8_eq(vals[idx], cval));
+					break;
+				case BATCH_CMP_NE:
+					BATCH_FILTER(float8_ne(vals[idx], cval));
+					break;
+				case BATCH_CMP_LT:
+					BATCH_FILTER(float8_lt(vals[idx], cval));
+					break;
+				case BATCH_CMP_LE:
+					BATCH_FILTER(float8_le(vals[idx], cval));
+					break;
+				case BATCH_CMP_GT:
+					BATCH_FILTER(float8_gt(vals[idx], cval));
+					break;
+				case BATCH_CMP_GE:
+					BATCH_FILTER(float8_ge(vals[idx], cval));
+					break;
+			}
+		}
+		else
+		{
+			int64	   *vals = col->ivals;
+			int64		cval = bqc->ival;
+
+			switch (bqc->op)
+			{
+				case BATCH_CMP_EQ:
+					BATCH_FILTER(vals[idx] == cval);
+					break;
+				case BATCH_CMP_NE:
+					BATCH_FILTER(vals[idx] != cval);
+					break;
+				case BATCH_CMP_LT:
+					BATCH_FILTER(vals[idx] < cval);
+					break;
+				case BATCH_CMP_LE:
+					BATCH_FILTER(vals[idx] <= cval);
+					break;
+				case BATCH_CMP_GT:
+					BATCH_FILTER(vals[idx] > cval);
+					break;
+				case BATCH_CMP_GE:
+					BATCH_FILTER(vals[idx] >= cval);
+					break;
+			}
+		}
+
+		nsel = nkeep;
+	}
+
+	return nsel;
+}
@@ -55,15 +55,28 @@ typedef struct LastAttnumInfo
 	AttrNumber	last_scan;
 } LastAttnumInfo;
 
+typedef struct CSEWalkerContext
+{
+	List	   *candidates;		/* shareable calls, in tree order */
+	bool		unsafe;			/* current subtree unsafe to share? */
+} CSEWalkerContext;
+
 static void ExecReadyExpr(ExprState *state);
 static void ExecInitExprRec(Expr *node, ExprState *state,
 				Datum *resv, bool *resnull);
+static void ExecInitExprNode(Expr *node, ExprState *state,
+				 Datum *resv, bool *resnull);
 static void ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args,
 			 Oid funcid, Oid inputcollid,
 			 ExprState *state);
+static bool ExecFuncUsageTracked(Oid funcid);
+static void ExecInitScanVarCmpConst(ExprEvalStep *scratch, OpExpr *op,
+						SimpleCompare *cmp);
 static void ExecInitExprSlots(ExprState *state, Node *node);
 static void ExecPushExprSlots(ExprState *state, LastAttnumInfo *info);
 static bool get_last_attnums_walker(Node *node, LastAttnumInfo *info);
+static void ExecInitCommonSubexprs(ExprState *state, Node *node);
+static bool cse_candidates_walker(Node *node, CSEWalkerContext *context);
 static void ExecComputeSlotInfo(ExprState *state, ExprEvalStep *op);
 static void ExecInitWholeRowVar(ExprEvalStep *scratch, Var *variable,
 					ExprState *state);
@@ -227,6 +240,9 @@ ExecInitQual(List *qual, PlanState *parent)
 	/* Insert EEOP_*_FETCHSOME steps as needed */
 	ExecInitExprSlots(state, (Node *) qual);
 
+	/* Look for subexpressions occurring more than once */
+	ExecInitCommonSubexprs(state, (Node *) qual);
+
 	/*
 	 * ExecQual() needs to return false for an expression returning NULL. That
 	 * allows us to short-circuit the evaluation the first time a NULL is
@@ -371,6 +387,9 @@ ExecBuildProjectionInfo(List *targetList,
 	/* Insert EEOP_*_FETCHSOME steps as needed */
 	ExecInitExprSlots(state, (Node *) targetList);
 
+	/* Look for subexpressions occurring more than once */
+	ExecInitCommonSubexprs(state, (Node *) targetList);
+
 	/* Now compile each tlist column */
 	foreach(lc, targetList)
 	{
@@ -638,12 +657,65 @@ ExecReadyExpr(ExprState *state)
  * node - expression to evaluate
  * state - ExprState to whose ->steps to append the necessary operations
  * resv / resnull - where to store the result of the node into
+ *
+ * If node is one of the ExprState's common subexpressions, its evaluation is
+ * bracketed by EEOP_CSE_LOAD and EEOP_CSE_STORE steps, so that only the
+ * first occurrence evaluated at runtime does the actual work.
  */
 static void
 ExecInitExprRec(Expr *node, ExprState *state,
 				Datum *resv, bool *resnull)
 {
 	ExprEvalStep scratch = {0};
+	ListCell   *lc;
+	int			cseno = 0;
+	int			loadstep;
+
+	foreach(lc, state->cse_exprs)
+	{
+		if (equal(node, lfirst(lc)))
+			break;
+		cseno++;
+	}
+	if (lc == NULL)
+	{
+		ExecInitExprNode(node, state, resv, resnull);
+		return;
+	}
+
+	scratch.resvalue = resv;
+	scratch.resnull = resnull;
+	scratch.d.cse.value = &state->cse_values[cseno];
+	scratch.d.cse.isnull = &state->cse_nulls[cseno];
+	scratch.d.cse.valid = &state->cse_valid[cseno];
+	scratch.d.cse.jumpdone = -1;	/* adjust later */
+	scratch.d.cse.make_ro = false;
+
+	scratch.opcode = EEOP_CSE_LOAD;
+	ExprEvalPushStep(state, &scratch);
+	loadstep = state->steps_len - 1;
+
+	ExecInitExprNode(node, state, resv, resnull);
+
+	/*
+	 * The value may be used multiple times, so force it to R/O - but only if
+	 * it could be an expanded datum.
+	 */
+	scratch.opcode = EEOP_CSE_STORE;
+	scratch.d.cse.make_ro = (get_typlen(exprType((Node *) node)) == -1);
+	ExprEvalPushStep(state, &scratch);
+
+	state->steps[loadstep].d.cse.jumpdone = state->steps_len;
+}
+
+/*
+ * Workhorse for ExecInitExprRec: append the steps for node itself.
+ */
+static void
+ExecInitExprNode(Expr *node, ExprState *state,
+				 Datum *resv, bool *resnull)
+{
+	ExprEvalStep scratch = {0};
 
 	/* Guard against stack overflow due to overly complex expressions */
 	check_stack_depth();
@@ -890,6 +962,24 @@ ExecInitExprRec(Expr *node, ExprState *state,
 		case T_OpExpr:
 			{
 				OpExpr	   *op = (OpExpr *) node;
+				SimpleCompare cmp;
+
+				/*
+				 * Comparisons of a scan column with a constant are common
+				 * enough in quals to deserve a fused step that doesn't go
+				 * through fmgr.  That also bypasses function usage tracking,
+				 * so don't do it if track_functions would count this call.
+				 */
+				if (ExecGetSimpleCompare((Expr *) op, &cmp) &&
+					cmp.var->varattno > 0 &&
+					cmp.var->varno != INNER_VAR &&
+					cmp.var->varno != OUTER_VAR &&
+					!ExecFuncUsageTracked(op->opfuncid))
+				{
+					ExecInitScanVarCmpConst(&scratch, op, &cmp);
+					ExprEvalPushStep(state, &scratch);
+					break;
+				}
 
 				ExecInitFunc(&scratch, node,
 							 op->args, op->opfuncid, op->inputcollid,
@@ -2246,6 +2336,48 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 	}
 }
 
+/*
+ * Would calls of the function be counted under the current track_functions
+ * setting?  This is the same test ExecInitFunc uses to pick the FUSAGE
+ * opcodes.
+ */
+static bool
+ExecFuncUsageTracked(Oid funcid)
+{
+	FmgrInfo	flinfo;
+
+	fmgr_info(funcid, &flinfo);
+
+	return pgstat_track_functions > flinfo.fn_stats;
+}
+
+/*
+ * Prepare a fused EEOP_SCAN_VAR_CMP_CONST step for a comparison that
+ * ExecGetSimpleCompare() recognized, setting up *scratch so it is ready to
+ * be pushed.
+ */
+static void
+ExecInitScanVarCmpConst(ExprEvalStep *scratch, OpExpr *op,
+						SimpleCompare *cmp)
+{
+	AclResult	aclresult;
+
+	/* Same permission checks as ExecInitFunc would make */
+	aclresult = pg_proc_aclcheck(op->opfuncid, GetUserId(), ACL_EXECUTE);
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, OBJECT_FUNCTION,
+					   get_func_name(op->opfuncid));
+	InvokeFunctionExecuteHook(op->opfuncid);
+
+	scratch->opcode = EEOP_SCAN_VAR_CMP_CONST;
+	scratch->d.cmpconst.attnum = cmp->var->varattno - 1;
+	scratch->d.cmpconst.vartype = cmp->var->vartype;
+	scratch->d.cmpconst.coltype = cmp->coltype;
+	scratch->d.cmpconst.op = cmp->op;
+	scratch->d.cmpconst.ival = cmp->ival;
+	scratch->d.cmpconst.fval = cmp->fval;
+}
+
 /*
  * Add expression steps deforming the ExprState's inner/outer/scan slots
  * as much as required by the expression.
@@ -2357,6 +2489,116 @@ get_last_attnums_walker(Node *node, LastAttnumInfo *info)
 								  (void *) info);
 }
 
+/*
+ * Find the subexpressions that occur more than once in node, which is a
+ * qual or target list about to be compiled into state, and set up state to
+ * evaluate each of them only once per evaluation of the whole expression.
+ *
+ * The remembered values are not computed eagerly: whichever occurrence gets
+ * evaluated first computes and stores the value, later ones just fetch it.
+ * So subexpressions in CASE arms and other conditionally evaluated places
+ * are still only evaluated when the original expression would have been.
+ */
+static void
+ExecInitCommonSubexprs(ExprState *state, Node *node)
+{
+	CSEWalkerContext context;
+	List	   *common = NIL;
+	ListCell   *lc;
+	ExprEvalStep scratch = {0};
+	int			ncse;
+
+	context.candidates = NIL;
+	context.unsafe = false;
+	(void) cse_candidates_walker(node, &context);
+
+	foreach(lc, context.candidates)
+	{
+		Node	   *candidate = (Node *) lfirst(lc);
+		ListCell   *lc2;
+
+		if (list_member(common, candidate))
+			continue;
+
+		for_each_cell(lc2, lnext(lc))
+		{
+			if (equal(candidate, lfirst(lc2)))
+			{
+				if (!contain_volatile_functions(candidate))
+					common = lappend(common, candidate);
+				break;
+			}
+		}
+	}
+	list_free(context.candidates);
+
+	if (common == NIL)
+		return;
+
+	ncse = list_length(common);
+	state->cse_exprs = common;
+	state->cse_values = (Datum *) palloc(ncse * sizeof(Datum));
+	state->cse_nulls = (bool *) palloc(ncse * sizeof(bool));
+	state->cse_valid = (bool *) palloc(ncse * sizeof(bool));
+
+	/* Forget the previous evaluation's values at the start of each one */
+	scratch.opcode = EEOP_CSE_RESET;
+	scratch.d.cse_reset.valid = state->cse_valid;
+	scratch.d.cse_reset.ncse = ncse;
+	ExprEvalPushStep(state, &scratch);
+}
+
+/*
+ * Collect the function and operator calls in node that could be evaluated
+ * once and shared with equal() expressions elsewhere in the tree, in
+ * context->candidates.  A call can't be shared if it references values that
+ * depend on where in the tree it appears (CaseTestExpr and friends), or
+ * contains set-returning functions or subplans.  Volatility is checked by
+ * the caller, and only for calls that do occur more than once, since it's
+ * comparatively expensive to determine.
+ *
+ * We don't look into the arguments of Aggrefs and such, since those aren't
+ * evaluated as part of this expression.
+ */
+static bool
+cse_candidates_walker(Node *node, CSEWalkerContext *context)
+{
+	bool		sibling_unsafe;
+
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, CaseTestExpr) ||
+		IsA(node, CoerceToDomainValue) ||
+		IsA(node, SubPlan) ||
+		IsA(node, AlternativeSubPlan) ||
+		(IsA(node, FuncExpr) && ((FuncExpr *) node)->funcretset) ||
+		(IsA(node, OpExpr) && ((OpExpr *) node)->opretset))
+	{
+		context->unsafe = true;
+		return false;
+	}
+
+	if (IsA(node, Aggref) ||
+		IsA(node, WindowFunc) ||
+		IsA(node, GroupingFunc))
+		return false;
+
+	/* Determine the node's own safety, independently of its siblings */
+	sibling_unsafe = context->unsafe;
+	context->unsafe = false;
+
+	/* Visit all children, so that safe parts of unsafe ones are found too */
+	(void) expression_tree_walker(node, cse_candidates_walker,
+								  (void *) context);
+
+	if (!context->unsafe && (IsA(node, FuncExpr) || IsA(node, OpExpr)))
+		context->candidates = lappend(context->candidates, node);
+
+	context->unsafe |= sibling_unsafe;
+	return false;
+}
+
 /*
  * Compute additional information for EEOP_*_FETCHSOME ops.
  *
@@ -3212,6 +3454,7 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 					  FunctionCallInfo fcinfo, AggStatePerTrans pertrans,
 					  int transno, int setno, int setoff, bool ishash)
 {
+	int			adjust_nullcheck_jumpnull = -1;
 	int			adjust_init_jumpnull = -1;
 	int			adjust_strict_jumpnull = -1;
 	ExprContext *aggcontext;
@@ -3221,6 +3464,22 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 	else
 		aggcontext = aggstate->aggcontexts[setno];
 
+	/*
+	 * A hashed grouping set may have no per-group state for the current
+	 * input tuple, if the tuple's group has been spilled to disk (or the
+	 * tuple is being reprocessed for a different grouping set).  Skip the
+	 * transition in that case.
+	 */
+	if (ishash)
+	{
+		scratch->opcode = EEOP_AGG_PLAIN_PERGROUP_NULLCHECK;
+		scratch->d.agg_plain_pergroup_nullcheck.setoff = setoff;
+		scratch->d.agg_plain_pergroup_nullcheck.jumpnull = -1;	/* adjust later */
+		ExprEvalPushStep(state, scratch);
+
+		adjust_nullcheck_jumpnull = state->steps_len - 1;
+	}
+
 	/*
 	 * If the initial value for the transition state doesn't exist in the
 	 * pg_aggregate table then we will let the first non-NULL value returned
@@ -3284,6 +3543,13 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 	ExprEvalPushStep(state, scratch);
 
 	/* adjust jumps so they jump till after transition invocation */
+	if (adjust_nullcheck_jumpnull != -1)
+	{
+		ExprEvalStep *as = &state->steps[adjust_nullcheck_jumpnull];
+
+		Assert(as->d.agg_plain_pergroup_nullcheck.jumpnull == -1);
+		as->d.agg_plain_pergroup_nullcheck.jumpnull = state->steps_len;
+	}
 	if (adjust_init_jumpnull != -1)
 	{
 		ExprEvalStep *as = &state->steps[adjust_init_jumpnull];
@@ -3451,3 +3717,196 @@ ExecBuildGroupingEqual(TupleDesc ldesc, TupleDesc rdesc,
 
 	return state;
 }
+
+/*
+ * Build an ExprState that computes a 32 bit hash value over some columns of
+ * the expression context's outer tuple, as TupleHashTableHash() does.
+ *
+ * The hash values of the individual columns are combined by rotating the
+ * running value left by one bit, and XORing in the next column's hash, NULLs
+ * hashing to zero.
+ *
+ * desc: tuple descriptor of the to-be-hashed tuples
+ * ops: slot type of the to-be-hashed tuples, or NULL if not known
+ * hashfunctions: hash functions to use, one per column
+ * numCols: the number of attributes to be hashed
+ * keyColIdx: array of attribute column numbers
+ * init_value: starting value of the hash
+ * parent: parent executor node
+ */
+ExprState *
+ExecBuildHash32FromAttrs(TupleDesc desc, const TupleTableSlotOps *ops,
+						 FmgrInfo *hashfunctions, int numCols,
+						 const AttrNumber *keyColIdx, uint32 init_value,
+						 PlanState *parent)
+{
+	ExprState  *state = makeNode(ExprState);
+	ExprEvalStep scratch = {0};
+	int			natt;
+	int			maxatt = -1;
+
+	state->expr = NULL;
+	state->flags = 0;
+	state->parent = parent;
+
+	/* compute max needed attribute */
+	for (natt = 0; natt < numCols; natt++)
+	{
+		int			attno = keyColIdx[natt];
+
+		if (attno > maxatt)
+			maxatt = attno;
+	}
+
+	/* push deform step, unless there's nothing to hash */
+	if (maxatt > 0)
+	{
+		scratch.opcode = EEOP_OUTER_FETCHSOME;
+		scratch.d.fetch.last_var = maxatt;
+		scratch.d.fetch.fixed = false;
+		scratch.d.fetch.known_desc = desc;
+		scratch.d.fetch.kind = ops;
+		ExecComputeSlotInfo(state, &scratch);
+		ExprEvalPushStep(state, &scratch);
+	}
+
+	scratch.opcode = EEOP_HASHDATUM_SET_INITVAL;
+	scratch.d.hashdatum_initvalue.init_value = UInt32GetDatum(init_value);
+	scratch.resvalue = &state->resvalue;
+	scratch.resnull = &state->resnull;
+	ExprEvalPushStep(state, &scratch);
+
+	for (natt = 0; natt < numCols; natt++)
+	{
+		int			attno = keyColIdx[natt];
+		Form_pg_attribute att = TupleDescAttr(desc, attno - 1);
+		FmgrInfo   *finfo = &hashfunctions[natt];
+		FunctionCallInfo fcinfo;
+
+		fcinfo = palloc0(SizeForFunctionCallInfo(1));
+		InitFunctionCallInfoData(*fcinfo, finfo, 1,
+								 InvalidOid, NULL, NULL);
+
+		/* fetch the column into the hash function's argument */
+		scratch.opcode = EEOP_OUTER_VAR;
+		scratch.d.var.attnum = attno - 1;
+		scratch.d.var.vartype = att->atttypid;
+		scratch.resvalue = &fcinfo->args[0].value;
+		scratch.resnull = &fcinfo->args[0].isnull;
+		ExprEvalPushStep(state, &scratch);
+
+		/* and combine its hash into the result */
+		scratch.opcode = EEOP_HASHDATUM_NEXT32;
+		scratch.d.hashdatum.finfo = finfo;
+		scratch.d.hashdatum.fcinfo_data = fcinfo;
+		scratch.d.hashdatum.fn_addr = finfo->fn_addr;
+		scratch.d.hashdatum.jumpdone = -1;
+		scratch.resvalue = &state->resvalue;
+		scratch.resnull = &state->resnull;
+		ExprEvalPushStep(state, &scratch);
+	}
+
+	scratch.resvalue = NULL;
+	scratch.resnull = NULL;
+	scratch.opcode = EEOP_DONE;
+	ExprEvalPushStep(state, &scratch);
+
+	ExecReadyExpr(state);
+
+	return state;
+}
+
+/*
+ * Build an ExprState that computes a 32 bit hash value over a list of key
+ * expressions, as ExecHashGetHashValue() does.  Hash values are combined the
+ * same way as in ExecBuildHash32FromAttrs().
+ *
+ * hash_exprs: list of key expressions
+ * hashfunc_oids: OIDs of the hash functions to use, one per key
+ * reject_nulls: per key, whether a NULL value means the tuple cannot match;
+ *		if so, evaluation stops and returns NULL
+ * init_value: starting value of the hash
+ * parent: parent executor node
+ *
+ * Compared to evaluating the keys one by one and calling the hash functions
+ * through fmgr, this saves a good deal of per-key overhead, and lets JIT
+ * compilation inline the hash functions.
+ */
+ExprState *
+ExecBuildHash32Expr(List *hash_exprs, const Oid *hashfunc_oids,
+					const bool *reject_nulls, uint32 init_value,
+					PlanState *parent)
+{
+	ExprState  *state = makeNode(ExprState);
+	ExprEvalStep scratch = {0};
+	List	   *adjust_jumps = NIL;
+	ListCell   *lc;
+	int			i = 0;
+
+	Assert(hash_exprs != NIL);
+
+	state->expr = (Expr *) hash_exprs;
+	state->parent = parent;
+
+	/* Insert EEOP_*_FETCHSOME steps as needed */
+	ExecInitExprSlots(state, (Node *) hash_exprs);
+
+	scratch.opcode = EEOP_HASHDATUM_SET_INITVAL;
+	scratch.d.hashdatum_initvalue.init_value = UInt32GetDatum(init_value);
+	scratch.resvalue = &state->resvalue;
+	scratch.resnull = &state->resnull;
+	ExprEvalPushStep(state, &scratch);
+
+	foreach(lc, hash_exprs)
+	{
+		Expr	   *expr = (Expr *) lfirst(lc);
+		FmgrInfo   *finfo;
+		FunctionCallInfo fcinfo;
+
+		finfo = palloc0(sizeof(FmgrInfo));
+		fcinfo = palloc0(SizeForFunctionCallInfo(1));
+		fmgr_info(hashfunc_oids[i], finfo);
+		fmgr_info_set_expr((Node *) expr, finfo);
+		InitFunctionCallInfoData(*fcinfo, finfo, 1,
+								 InvalidOid, NULL, NULL);
+
+		/* evaluate the key into the hash function's argument */
+		ExecInitExprRec(expr, state,
+						&fcinfo->args[0].value, &fcinfo->args[0].isnull);
+
+		/* and combine its hash into the result */
+		scratch.opcode = reject_nulls[i] ?
+			EEOP_HASHDATUM_NEXT32_STRICT : EEOP_HASHDATUM_NEXT32;
+		scratch.d.hashdatum.finfo = finfo;
+		scratch.d.hashdatum.fcinfo_data = fcinfo;
+		scratch.d.hashdatum.fn_addr = finfo->fn_addr;
+		scratch.d.hashdatum.jumpdone = -1;
+		scratch.resvalue = &state->resvalue;
+		scratch.resnull = &state->resnull;
+		ExprEvalPushStep(state, &scratch);
+
+		if (reject_nulls[i])
+			adjust_jumps = lappend_int(adjust_jumps, state->steps_len - 1);
+
+		i++;
+	}
+
+	/* adjust jump targets */
+	foreach(lc, adjust_jumps)
+	{
+		ExprEvalStep *as = &state->steps[lfirst_int(lc)];
+
+		Assert(as->opcode == EEOP_HASHDATUM_NEXT32_STRICT);
+		Assert(as->d.hashdatum.jumpdone == -1);
+		as->d.hashdatum.jumpdone = state->steps_len;
+	}
+
+	scratch.resvalue = NULL;
+	scratch.resnull = NULL;
+	scratch.opcode = EEOP_DONE;
+	ExprEvalPushStep(state, &scratch);
+
+	ExecReadyExpr(state);
+
+	return state;
+}
@@ -71,6 +71,7 @@
 #include "utils/date.h"
 #include "utils/datum.h"
 #include "utils/expandedrecord.h"
+#include "utils/float.h"
 #include "utils/lsyscache.h"
 #include "utils/timestamp.h"
 #include "utils/typcache.h"
@@ -159,6 +160,77 @@ static Datum ExecJustAssignInnerVar(ExprState *state, ExprContext *econtext, boo
 static Datum ExecJustAssignOuterVar(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustAssignScanVar(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustApplyFuncToCase(ExprState *state, ExprContext *econtext, bool *isnull);
+static Datum ExecJustScanVarCmpConst(ExprState *state, ExprContext *econtext, bool *isnull);
+static Datum ExecJustScanVarCmpConstQual(ExprState *state, ExprContext *econtext, bool *isnull);
+
+
+/*
+ * Evaluate the comparison of an EEOP_SCAN_VAR_CMP_CONST step for a non-null
+ * value of the Var.  The results match those of the underlying comparison
+ * functions, including float8's treatment of NaNs.
+ */
+static inline bool
+ExecCmpConst(ExprEvalStep *op, Datum value)
+{
+	if (op->d.cmpconst.coltype == BATCH_COL_FLOAT4 ||
+		op->d.cmpconst.coltype == BATCH_COL_FLOAT8)
+	{
+		float8		val;
+		float8		cval = op->d.cmpconst.fval;
+
+		if (op->d.cmpconst.coltype == BATCH_COL_FLOAT4)
+			val = DatumGetFloat4(value);
+		else
+			val = DatumGetFloat8(value);
+
+		switch (op->d.cmpconst.op)
+		{
+			case BATCH_CMP_EQ:
+				return float8_eq(val, cval);
+			case BATCH_CMP_NE:
+				return float8_ne(val, cval);
+			case BATCH_CMP_LT:
+				return float8_lt(val, cval);
+			case BATCH_CMP_LE:
+				return float8_le(val, cval);
+			case BATCH_CMP_GT:
+				return float8_gt(val, cval);
+			case BATCH_CMP_GE:
+				return float8_ge(val, cval);
+		}
+	}
+	else
+	{
+		int64		val;
+		int64		cval = op->d.cmpconst.ival;
+
+		if (op->d.cmpconst.coltype == BATCH_COL_INT2)
+			val = DatumGetInt16(value);
+		else if (op->d.cmpconst.coltype == BATCH_COL_INT4)
+			val = DatumGetInt32(value);
+		else
+			val = DatumGetInt64(value);
+
+		switch (op->d.cmpconst.op)
+		{
+			case BATCH_CMP_EQ:
+				return val == cval;
+			case BATCH_CMP_NE:
+				return val != cval;
+			case BATCH_CMP_LT:
+				return val < cval;
+			case BATCH_CMP_LE:
+				return val <= cval;
+			case BATCH_CMP_GT:
+				return val > cval;
+			case BATCH_CMP_GE:
+				return val >= cval;
+		}
+	}
+
+	pg_unreachable();
+	return false;
+}
 
 
 /*
@@ -253,6 +325,21 @@ ExecReadyInterpretedExpr(ExprState *state)
 			state->evalfunc_private = (void *) ExecJustApplyFuncToCase;
 			return;
 		}
+		else if (step0 == EEOP_SCAN_FETCHSOME &&
+				 step1 == EEOP_SCAN_VAR_CMP_CONST)
+		{
+			state->evalfunc_private = (void *) ExecJustScanVarCmpConst;
+			return;
+		}
+	}
+	else if (state->steps_len == 4 &&
+			 state->steps[0].opcode == EEOP_SCAN_FETCHSOME &&
+			 state->steps[1].opcode == EEOP_SCAN_VAR_CMP_CONST &&
+			 state->steps[2].opcode == EEOP_QUAL)
+	{
+		/* single-clause qual, as made by ExecInitQual */
+		state->evalfunc_private = (void *) ExecJustScanVarCmpConstQual;
+		return;
 	}
 	else if (state->steps_len == 2 &&
 			 state->steps[0].opcode == EEOP_CONST)
@@ -329,6 +416,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_FUNCEXPR_STRICT,
 		&&CASE_EEOP_FUNCEXPR_FUSAGE,
 		&&CASE_EEOP_FUNCEXPR_STRICT_FUSAGE,
+		&&CASE_EEOP_SCAN_VAR_CMP_CONST,
 		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
 		&&CASE_EEOP_BOOL_AND_STEP,
 		&&CASE_EEOP_BOOL_AND_STEP_LAST,
@@ -385,10 +473,17 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_WINDOW_FUNC,
 		&&CASE_EEOP_SUBPLAN,
 		&&CASE_EEOP_ALTERNATIVE_SUBPLAN,
+		&&CASE_EEOP_CSE_RESET,
+		&&CASE_EEOP_CSE_LOAD,
+		&&CASE_EEOP_CSE_STORE,
+		&&CASE_EEOP_HASHDATUM_SET_INITVAL,
+		&&CASE_EEOP_HASHDATUM_NEXT32,
+		&&CASE_EEOP_HASHDATUM_NEXT32_STRICT,
 		&&CASE_EEOP_AGG_STRICT_DESERIALIZE,
 		&&CASE_EEOP_AGG_DESERIALIZE,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK_ARGS,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK_NULLS,
+		&&CASE_EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
 		&&CASE_EEOP_AGG_INIT_TRANS,
 		&&CASE_EEOP_AGG_STRICT_TRANS_CHECK,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_BYVAL,
@@ -670,6 +765,29 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_SCAN_VAR_CMP_CONST)
+		{
+			int			attnum = op->d.cmpconst.attnum;
+
+			/* See EEOP_INNER_VAR comments */
+
+			Assert(attnum >= 0 && attnum < scanslot->tts_nvalid);
+			if (scanslot->tts_isnull[attnum])
+			{
+				/* all the comparison functions are strict */
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+			}
+			else
+			{
+				*op->resvalue =
+					BoolGetDatum(ExecCmpConst(op, scanslot->tts_values[attnum]));
+				*op->resnull = false;
+			}
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * If any of its clauses is FALSE, an AND's result is FALSE regardless
 		 * of the states of the rest of the clauses, so we can stop evaluating
@@ -1494,6 +1612,76 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_CSE_RESET)
+		{
+			/* not common enough to inline */
+			ExecEvalCSEReset(state, op, econtext);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CSE_LOAD)
+		{
+			/* if the subexpression was already evaluated, skip it */
+			if (*op->d.cse.valid)
+			{
+				*op->resvalue = *op->d.cse.value;
+				*op->resnull = *op->d.cse.isnull;
+				EEO_JUMP(op->d.cse.jumpdone);
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CSE_STORE)
+		{
+			ExecEvalCSEStore(state, op, econtext);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_HASHDATUM_SET_INITVAL)
+		{
+			*op->resvalue = op->d.hashdatum_initvalue.init_value;
+			*op->resnull = false;
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_HASHDATUM_NEXT32_STRICT)
+		{
+			/* a NULL key means the tuple can't match, return NULL */
+			if (op->d.hashdatum.fcinfo_data->args[0].isnull)
+			{
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+
+				EEO_JUMP(op->d.hashdatum.jumpdone);
+			}
+
+			/* fallthrough */
+		}
+
+		EEO_CASE(EEOP_HASHDATUM_NEXT32)
+		{
+			FunctionCallInfo fcinfo = op->d.hashdatum.fcinfo_data;
+			uint32		hashvalue = DatumGetUInt32(*op->resvalue);
+
+			/* rotate hash value left 1 bit at each step */
+			hashvalue = (hashvalue << 1) | ((hashvalue & 0x80000000) ? 1 : 0);
+
+			/* a NULL key leaves it unmodified, i.e. acts as hashing to zero */
+			if (!fcinfo->args[0].isnull)
+			{
+				fcinfo->isnull = false;
+				hashvalue ^= DatumGetUInt32(op->d.hashdatum.fn_addr(fcinfo));
+			}
+
+			*op->resvalue = UInt32GetDatum(hashvalue);
+
+			EEO_NEXT();
+		}
+
 		/* evaluate a strict aggregate deserialization function */
 		EEO_CASE(EEOP_AGG_STRICT_DESERIALIZE)
 		{
@@ -1556,6 +1744,26 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Check for a NULL pointer to the per-group states.  Hash aggregation
+		 * leaves that NULL for grouping sets the current input tuple is not
+		 * being aggregated into, e.g. because its group has been spilled to
+		 * disk.
+		 */
+		EEO_CASE(EEOP_AGG_PLAIN_PERGROUP_NULLCHECK)
+		{
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerGroup pergroup_allaggs;
+
+			pergroup_allaggs = aggstate->all_pergroups
+				[op->d.agg_plain_pergroup_nullcheck.setoff];
+
+			if (pergroup_allaggs == NULL)
+				EEO_JUMP(op->d.agg_plain_pergroup_nullcheck.jumpnull);
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * Initialize an aggregate's first value if necessary.
 		 */
@@ -1814,6 +2022,14 @@ CheckExprStillValid(ExprState *state, ExprContext *econtext)
 					CheckVarSlotCompatibility(scanslot, attnum + 1, op->d.var.vartype);
 					break;
 				}
+
+			case EEOP_SCAN_VAR_CMP_CONST:
+				{
+					int			attnum = op->d.cmpconst.attnum;
+
+					CheckVarSlotCompatibility(scanslot, attnum + 1, op->d.cmpconst.vartype);
+					break;
+				}
 			default:
 				break;
 		}
@@ -2119,6 +2335,44 @@ ExecJustApplyFuncToCase(ExprState *state, ExprContext *econtext, bool *isnull)
 	return d;
 }
 
+/* Compare scan Var with a constant, using the fused comparison step */
+static Datum
+ExecJustScanVarCmpConst(ExprState *state, ExprContext *econtext, bool *isnull)
+{
+	ExprEvalStep *op = &state->steps[1];
+	int			attnum = op->d.cmpconst.attnum + 1;
+	TupleTableSlot *slot = econtext->ecxt_scantuple;
+	Datum		d;
+
+	CheckOpSlotCompatibility(&state->steps[0], slot);
+
+	/* See comments in ExecJustInnerVar */
+	d = slot_getattr(slot, attnum, isnull);
+	if (*isnull)
+		return (Datum) 0;
+	return BoolGetDatum(ExecCmpConst(op, d));
+}
+
+/* Same as above, as a qual: NULL counts as false */
+static Datum
+ExecJustScanVarCmpConstQual(ExprState *state, ExprContext *econtext, bool *isnull)
+{
+	ExprEvalStep *op = &state->steps[1];
+	int			attnum = op->d.cmpconst.attnum + 1;
+	TupleTableSlot *slot = econtext->ecxt_scantuple;
+	Datum		d;
+	bool		attnull;
+
+	CheckOpSlotCompatibility(&state->steps[0], slot);
+
+	/* See comments in ExecJustInnerVar */
+	d = slot_getattr(slot, attnum, &attnull);
+	*isnull = false;
+	if (attnull)
+		return BoolGetDatum(false);
+	return BoolGetDatum(ExecCmpConst(op, d));
+}
+
 #if defined(EEO_USE_COMPUTED_GOTO)
 /*
  * Comparator used when building address->opcode lookup table for
@@ -2257,6 +2511,57 @@ ExecEvalFuncExprStrictFusage(ExprState *state, ExprEvalStep *op,
 	pgstat_end_function_usage(&fcusage, true);
 }
 
+/*
+ * Evaluate a fused scan Var / constant comparison.
+ *
+ * The interpreter does this inline; this out-of-line version is for JIT.
+ */
+void
+ExecEvalScanVarCmpConst(ExprState *state, ExprEvalStep *op,
+						ExprContext *econtext)
+{
+	TupleTableSlot *scanslot = econtext->ecxt_scantuple;
+	int			attnum = op->d.cmpconst.attnum;
+
+	Assert(attnum >= 0 && attnum < scanslot->tts_nvalid);
+	if (scanslot->tts_isnull[attnum])
+	{
+		*op->resvalue = (Datum) 0;
+		*op->resnull = true;
+	}
+	else
+	{
+		*op->resvalue =
+			BoolGetDatum(ExecCmpConst(op, scanslot->tts_values[attnum]));
+		*op->resnull = false;
+	}
+}
+
+/*
+ * Forget the values of all common subexpressions, at the start of a new
+ * evaluation of the expression.
+ */
+void
+ExecEvalCSEReset(ExprState *state, ExprEvalStep *op, ExprContext *econtext)
+{
+	memset(op->d.cse_reset.valid, 0, op->d.cse_reset.ncse * sizeof(bool));
+}
+
+/*
+ * Remember the just-computed value of a common subexpression, for use by
+ * its other occurrences.
+ */
+void
+ExecEvalCSEStore(ExprState *state, ExprEvalStep *op, ExprContext *econtext)
+{
+	if (op->d.cse.make_ro && !*op->resnull)
+		*op->resvalue = MakeExpandedObjectReadOnlyInternal(*op->resvalue);
+
+	*op->d.cse.value = *op->resvalue;
+	*op->d.cse.isnull = *op->resnull;
+	*op->d.cse.valid = true;
+}
+
 /*
  * Evaluate a PARAM_EXEC parameter.
  *
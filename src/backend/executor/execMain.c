@@ -1628,7 +1628,15 @@ ExecutePlan(EState *estate,
 
 	estate->es_use_parallel_mode = use_parallel_mode;
 	if (use_parallel_mode)
+	{
+		/*
+		 * An INSERT can't assign a transaction ID once parallel mode has
+		 * started, so make sure we have one beforehand.
+		 */
+		if (operation == CMD_INSERT)
+			(void) GetCurrentTransactionId();
 		EnterParallelMode();
+	}
 
 	/*
 	 * Loop until we've processed the proper number of tuples from the plan.
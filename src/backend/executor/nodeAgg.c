@@ -194,6 +194,50 @@
  *	  transition values.  hashcontext is the single context created to support
  *	  all hash tables.
  *
+ *	  Spilling To Disk
+ *
+ *	  When performing hash aggregation, if the hash tables grow beyond
+ *	  work_mem, we enter "spill mode".  In spill mode, we advance the
+ *	  transition states only for groups already in the hash tables.  For
+ *	  tuples that would need to create a new hash table entry (and initialize
+ *	  new transition states), we instead spill them to disk, to be processed
+ *	  later.  The tuples are spilled in a partitioned manner, so that
+ *	  subsequent batches are smaller and less likely to exceed work_mem (if a
+ *	  batch does exceed work_mem, it must be spilled recursively).
+ *
+ *	  Spilled data is written to BufFile temporary files, one per partition.
+ *	  Each spilled tuple is stored as its hash value followed by the input
+ *	  tuple in MinimalTuple format, so that the hash need not be recomputed
+ *	  when the batch is read back in.
+ *
+ *	  Note that the partitioning is done per grouping set: a tuple is spilled
+ *	  (once) for each hashed grouping set it could not be aggregated into,
+ *	  and each batch processes just one grouping set.  The other sets' per-
+ *	  group pointers are left NULL while a batch is processed, which causes
+ *	  the transition expression to skip them (see
+ *	  EEOP_AGG_PLAIN_PERGROUP_NULLCHECK).
+ *
+ *	  Note also that the memory limit is only checked when a new group is
+ *	  created, so transition states that keep growing after their group
+ *	  was created (e.g. array_agg()) can still push the hash tables past
+ *	  work_mem.
+ *
+ *	  Parallel Hash Aggregation
+ *
+ *	  A parallel-aware Agg node (AGG_HASHED, no grouping sets) runs below a
+ *	  Gather and performs the complete aggregation, rather than leaving the
+ *	  combining of partial groups to the leader.  Each participant reads its
+ *	  share of the (partial) input and routes every tuple, by the high bits
+ *	  of its hash value, to one of a set of partitions stored in shared
+ *	  tuplestores.  Once all participants are done with the input (they wait
+ *	  for each other on a barrier), each participant repeatedly claims a
+ *	  whole partition, aggregates it in a private hash table and emits the
+ *	  finished groups.  Since all tuples of a group land in the same
+ *	  partition, no group is ever emitted twice, and the total memory used is
+ *	  about that of one partition per participant.  A claimed partition is
+ *	  processed just like a spilled batch, so partitions that don't fit in
+ *	  work_mem are spilled further using the remaining hash bits.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -229,15 +273,111 @@
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "pgstat.h"
+#include "storage/barrier.h"
+#include "storage/buffile.h"
+#include "storage/sharedfileset.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/dynahash.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/sharedtuplestore.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
 #include "utils/datum.h"
 
 
+/*
+ * Control how many partitions are created when spilling HashAgg to
+ * disk.
+ *
+ * HASHAGG_PARTITION_FACTOR is multiplied by the estimated number of
+ * partitions needed such that each partition will fit in memory. The factor
+ * is set higher than one because there's not a high cost to having a few too
+ * many partitions, and it makes it less likely that a partition will need to
+ * be spilled recursively. Another benefit of having more, smaller partitions
+ * is that small hash tables may perform better than large ones due to memory
+ * caching effects.
+ *
+ * We also specify a min and max number of partitions per spill. Too few might
+ * mean a lot of wasted I/O from repeated spilling of the same tuples. Too
+ * many will result in lots of memory wasted buffering the spill files (which
+ * could instead be spent on a larger hash table).
+ */
+#define HASHAGG_PARTITION_FACTOR 1.50
+#define HASHAGG_MIN_PARTITIONS 4
+#define HASHAGG_MAX_PARTITIONS 256
+
+/*
+ * Memory each participant of a Parallel HashAggregate uses to buffer writes
+ * to one shared partition.  This matches sharedtuplestore.c's chunk size.
+ */
+#define HASHAGG_PARALLEL_WRITE_BUFFER (4 * BLCKSZ)
+
+/*
+ * Represents partitioned spill data for a single hashtable. Contains the
+ * necessary information to route tuples to the correct partition, and to
+ * transform the spilled data into new batches.
+ *
+ * The high bits are used for partition selection (when recursing, we ignore
+ * the bits that have already been used for partition selection at an earlier
+ * level).
+ */
+typedef struct HashAggSpill
+{
+	int			npartitions;	/* number of partitions */
+	BufFile   **partitions;		/* spill files, created on first write */
+	int64	   *ntuples;		/* number of tuples in each partition */
+	uint32		mask;			/* mask to find partition from hash value */
+	int			shift;			/* after masking, shift by this amount */
+} HashAggSpill;
+
+/*
+ * Represents work to be done for one pass of hash aggregation (with only one
+ * grouping set).
+ *
+ * Also tracks the bits of the hash already used for partition selection by
+ * earlier iterations, so that this batch can use new bits. If all bits have
+ * already been used, no partitioning will be done (any spilled data will go
+ * to a single output file).
+ */
+typedef struct HashAggBatch
+{
+	int			setno;			/* grouping set */
+	int			used_bits;		/* number of bits of hash already used */
+	BufFile    *input_file;		/* input partition */
+	SharedTuplestoreAccessor *input_sts;	/* or shared input partition */
+	int64		input_tuples;	/* number of tuples in this batch */
+} HashAggBatch;
+
+/*
+ * Shared state for Parallel HashAggregate, in the DSM segment.
+ *
+ * The barrier only has two phases: PHA_PARTITIONING while participants are
+ * routing input tuples to the shared partitions, and PHA_AGGREGATING once
+ * all of them are done and partitions may be claimed (by incrementing
+ * next_partition).  The SharedTuplestores for the partitions follow the
+ * struct, each taking sts_size bytes.
+ */
+typedef struct ParallelAggState
+{
+	Barrier		barrier;		/* synchronizes the end of partitioning */
+	SharedFileSet fileset;		/* space for the partitions' files */
+	int			nparticipants;	/* number of participants, incl. leader */
+	int			npartitions;	/* number of partitions (a power of two) */
+	int			partition_bits; /* log2(npartitions) */
+	Size		sts_size;		/* space for each SharedTuplestore */
+	pg_atomic_uint32 next_partition;	/* next partition to be claimed */
+	char		partitions[FLEXIBLE_ARRAY_MEMBER];
+} ParallelAggState;
+
+#define PHA_PARTITIONING				0
+#define PHA_AGGREGATING					1
+
+#define ParallelAggPartition(pstate, i) \
+	((SharedTuplestore *) ((pstate)->partitions + (i) * (pstate)->sts_size))
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
@@ -272,11 +412,42 @@ static TupleTableSlot *project_aggregates(AggState *aggstate);
 static Bitmapset *find_unaggregated_cols(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void build_hash_table(AggState *aggstate);
-static TupleHashEntryData *lookup_hash_entry(AggState *aggstate);
+static void prepare_hash_slot(AggStatePerHash perhash,
+				  TupleTableSlot *inputslot);
+static void initialize_hash_entry(AggState *aggstate,
+					  TupleHashTable hashtable,
+					  TupleHashEntry entry);
 static void lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
+static bool agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_hash_table_in_memory(AggState *aggstate);
+static Size hash_agg_mem_used(AggState *aggstate);
+static void hash_agg_check_limits(AggState *aggstate);
+static void hash_agg_enter_spill_mode(AggState *aggstate);
+static long hash_choose_num_buckets(double hashentrysize, long ngroups,
+						Size memory);
+static int hash_choose_num_partitions(double input_groups,
+						   double hashentrysize,
+						   int used_bits,
+						   int *log2_npartitions);
+static void hashagg_spill_init(HashAggSpill *spill, int used_bits,
+				   double input_groups, double hashentrysize);
+static void hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
+					TupleTableSlot *inputslot, uint32 hash);
+static void hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill,
+					 int setno, int used_bits);
+static void hashagg_finish_initial_spills(AggState *aggstate);
+static MinimalTuple hashagg_batch_read(HashAggBatch *batch, uint32 *hashp);
+static void hashagg_reset_spill_state(AggState *aggstate);
+static void agg_partition_parallel_input(AggState *aggstate);
+static bool hashagg_claim_partition(AggState *aggstate);
+static int	hashagg_parallel_num_partitions(AggState *aggstate,
+								int nparticipants, int *partition_bits);
+static Size hashagg_parallel_state_size(int npartitions, int nparticipants);
+static void hashagg_parallel_initialize(AggState *aggstate,
+							ParallelAggState *pstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
 						  AggState *aggstate, EState *estate,
@@ -1251,8 +1422,8 @@ find_unaggregated_cols_walker(Node *node, Bitmapset **colnos)
  * To implement hashed aggregation, we need a hashtable that stores a
  * representative tuple and an array of AggStatePerGroup structs for each
  * distinct set of GROUP BY column values.  We compute the hash key from the
- * GROUP BY columns.  The per-group data is allocated in lookup_hash_entry(),
- * for each entry.
+ * GROUP BY columns.  The per-group data is allocated in
+ * initialize_hash_entry(), for each entry.
  *
  * We have a separate hashtable and associated perhash data structure for each
  * grouping set for which we're doing hashing.
@@ -1266,18 +1437,27 @@ build_hash_table(AggState *aggstate)
 {
 	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
 	Size		additionalsize;
+	Size		memory;
 	int			i;
 
 	Assert(aggstate->aggstrategy == AGG_HASHED || aggstate->aggstrategy == AGG_MIXED);
 
 	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
 
+	/* the hash tables share the memory limit */
+	memory = aggstate->hash_mem_limit / aggstate->num_hashes;
+
 	for (i = 0; i < aggstate->num_hashes; ++i)
 	{
 		AggStatePerHash perhash = &aggstate->perhash[i];
+		long		nbuckets;
 
 		Assert(perhash->aggnode->numGroups > 0);
 
+		nbuckets = hash_choose_num_buckets(aggstate->hashentrysize,
+										   perhash->aggnode->numGroups,
+										   memory);
+
 		if (perhash->hashtable)
 			ResetTupleHashTable(perhash->hashtable);
 		else
@@ -1287,9 +1467,9 @@ build_hash_table(AggState *aggstate)
 														perhash->hashGrpColIdxHash,
 														perhash->eqfuncoids,
 														perhash->hashfunctions,
-														perhash->aggnode->numGroups,
+														nbuckets,
 														additionalsize,
-														aggstate->ss.ps.state->es_query_cxt,
+														aggstate->hash_metacxt,
 														aggstate->hashcontext->ecxt_per_tuple_memory,
 														tmpmem,
 														DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
@@ -1304,7 +1484,7 @@ build_hash_table(AggState *aggstate)
  * at all.  Only columns of the first two types need to be stored in the
  * hashtable, and getting rid of the others can make the table entries
  * significantly smaller.  The hashtable only contains the relevant columns,
- * and is packed/unpacked in lookup_hash_entry() / agg_retrieve_hash_table()
+ * and is packed/unpacked in lookup_hash_entries() / agg_retrieve_hash_table()
  * into the format of the normal input descriptor.
  *
  * Additional columns, in addition to the columns grouped by, come from two
@@ -1440,21 +1620,13 @@ hash_agg_entry_size(int numAggs)
 }
 
 /*
- * Find or create a hashtable entry for the tuple group containing the current
- * tuple (already set in tmpcontext's outertuple slot), in the current grouping
- * set (which the caller must have selected - note that initialize_aggregate
- * depends on this).
- *
- * When called, CurrentMemoryContext should be the per-query context.
+ * Transfer just the columns needed by the hash table from the input tuple
+ * into perhash->hashslot.
  */
-static TupleHashEntryData *
-lookup_hash_entry(AggState *aggstate)
+static void
+prepare_hash_slot(AggStatePerHash perhash, TupleTableSlot *inputslot)
 {
-	TupleTableSlot *inputslot = aggstate->tmpcontext->ecxt_outertuple;
-	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
 	TupleTableSlot *hashslot = perhash->hashslot;
-	TupleHashEntryData *entry;
-	bool		isnew;
 	int			i;
 
 	/* transfer just the needed columns into hashslot */
@@ -1469,53 +1641,97 @@ lookup_hash_entry(AggState *aggstate)
 		hashslot->tts_isnull[i] = inputslot->tts_isnull[varNumber];
 	}
 	ExecStoreVirtualTuple(hashslot);
+}
 
-	/* find or create the hashtable entry using the filtered tuple */
-	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, &isnew);
+/*
+ * Initialize a freshly-created hash table entry: allocate and initialize the
+ * per-group transition states, and check whether the new group pushed the
+ * hash tables over the memory limit.
+ *
+ * The caller must have selected the entry's grouping set, as
+ * initialize_aggregate depends on that.
+ */
+static void
+initialize_hash_entry(AggState *aggstate, TupleHashTable hashtable,
+					  TupleHashEntry entry)
+{
+	AggStatePerGroup pergroup;
+	int			transno;
 
-	if (isnew)
-	{
-		AggStatePerGroup pergroup;
-		int			transno;
+	aggstate->hash_ngroups_current++;
 
-		pergroup = (AggStatePerGroup)
-			MemoryContextAlloc(perhash->hashtable->tablecxt,
-							   sizeof(AggStatePerGroupData) * aggstate->numtrans);
-		entry->additional = pergroup;
+	pergroup = (AggStatePerGroup)
+		MemoryContextAlloc(hashtable->tablecxt,
+						   sizeof(AggStatePerGroupData) * aggstate->numtrans);
+	entry->additional = pergroup;
 
-		/*
-		 * Initialize aggregates for new tuple group, lookup_hash_entries()
-		 * already has selected the relevant grouping set.
-		 */
-		for (transno = 0; transno < aggstate->numtrans; transno++)
-		{
-			AggStatePerTrans pertrans = &aggstate->pertrans[transno];
-			AggStatePerGroup pergroupstate = &pergroup[transno];
+	for (transno = 0; transno < aggstate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+		AggStatePerGroup pergroupstate = &pergroup[transno];
 
-			initialize_aggregate(aggstate, pertrans, pergroupstate);
-		}
+		initialize_aggregate(aggstate, pertrans, pergroupstate);
 	}
 
-	return entry;
+	hash_agg_check_limits(aggstate);
 }
 
 /*
- * Look up hash entries for the current tuple in all hashed grouping sets,
- * returning an array of pergroup pointers suitable for advance_aggregates.
+ * Look up hash entries for the current tuple (already set in tmpcontext's
+ * outertuple slot) in all hashed grouping sets, setting up the per-group
+ * pointers in aggstate->hash_pergroup for advance_aggregates.
  *
- * Be aware that lookup_hash_entry can reset the tmpcontext.
+ * If the hash tables have exceeded the memory limit, no new groups are
+ * created: a tuple whose group is not in a grouping set's hash table is
+ * spilled to that set's partitions instead, and its pergroup pointer for
+ * the set is left NULL, so that advance_aggregates skips it.
+ *
+ * Be aware that the hash lookups can reset the tmpcontext.
  */
 static void
 lookup_hash_entries(AggState *aggstate)
 {
 	int			numHashes = aggstate->num_hashes;
 	AggStatePerGroup *pergroup = aggstate->hash_pergroup;
+	TupleTableSlot *inputslot = aggstate->tmpcontext->ecxt_outertuple;
 	int			setno;
 
 	for (setno = 0; setno < numHashes; setno++)
 	{
+		AggStatePerHash perhash = &aggstate->perhash[setno];
+		TupleHashTable hashtable = perhash->hashtable;
+		TupleHashEntry entry;
+		uint32		hash;
+		bool		isnew = false;
+		bool	   *p_isnew;
+
+		/* if hash table already spilled, don't create new entries */
+		p_isnew = aggstate->hash_spill_mode ? NULL : &isnew;
+
 		select_current_set(aggstate, setno, true);
-		pergroup[setno] = lookup_hash_entry(aggstate)->additional;
+		prepare_hash_slot(perhash, inputslot);
+
+		hash = TupleHashTableHash(hashtable, perhash->hashslot);
+		entry = LookupTupleHashEntryHash(hashtable, perhash->hashslot,
+										 p_isnew, hash);
+
+		if (entry != NULL)
+		{
+			if (isnew)
+				initialize_hash_entry(aggstate, hashtable, entry);
+			pergroup[setno] = entry->additional;
+		}
+		else
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+
+			if (spill->partitions == NULL)
+				hashagg_spill_init(spill, 0, perhash->aggnode->numGroups,
+								   aggstate->hashentrysize);
+
+			hashagg_spill_tuple(aggstate, spill, inputslot, hash);
+			pergroup[setno] = NULL;
+		}
 	}
 }
 
@@ -1669,6 +1885,7 @@ agg_retrieve_direct(AggState *aggstate)
 				 * full hashtables, so switch to outputting those.
 				 */
 				initialize_phase(aggstate, 0);
+				hashagg_finish_initial_spills(aggstate);
 				aggstate->table_filled = true;
 				ResetTupleHashIterator(aggstate->perhash[0].hashtable,
 									   &aggstate->perhash[0].hashiter);
@@ -1914,6 +2131,21 @@ agg_fill_hash_table(AggState *aggstate)
 	TupleTableSlot *outerslot;
 	ExprContext *tmpcontext = aggstate->tmpcontext;
 
+	/*
+	 * In a Parallel HashAggregate, the input is only partitioned here; the
+	 * hash table is filled from one partition at a time, by
+	 * agg_refill_hash_table.
+	 */
+	if (aggstate->hash_parallel_state != NULL)
+	{
+		agg_partition_parallel_input(aggstate);
+		aggstate->table_filled = true;
+		select_current_set(aggstate, 0, true);
+		ResetTupleHashIterator(aggstate->perhash[0].hashtable,
+							   &aggstate->perhash[0].hashiter);
+		return;
+	}
+
 	/*
 	 * Process each outer-plan tuple, and then fetch the next one, until we
 	 * exhaust the outer plan.
@@ -1940,6 +2172,9 @@ agg_fill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
+	/* finalize spills, if any */
+	hashagg_finish_initial_spills(aggstate);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the first hash table */
 	select_current_set(aggstate, 0, true);
@@ -1947,11 +2182,197 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * If any data was spilled during the previous pass, process one batch of
+ * it: reset the hash tables and fill them from the batch's spill file.  As
+ * in the first pass, groups that don't fit in memory are spilled again,
+ * into new partitions that use further bits of the hash value.  In a
+ * Parallel HashAggregate, once our own batches are exhausted, we claim the
+ * next unprocessed shared partition and process it as a batch.
+ *
+ * Returns false when there are no more batches to process.
+ */
+static bool
+agg_refill_hash_table(AggState *aggstate)
+{
+	HashAggBatch *batch;
+	HashAggSpill spill;
+	AggStatePerHash perhash;
+	TupleTableSlot *spillslot = aggstate->hash_spill_slot;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	bool		spill_initialized = false;
+	MinimalTuple tuple;
+	uint32		hash;
+	int			setno;
+
+	if (aggstate->hash_batches == NIL &&
+		!hashagg_claim_partition(aggstate))
+		return false;
+
+	batch = linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * Tuples read back from a spill file are in a MinimalTuple slot, while
+	 * the phase's transition expression may have been compiled for the
+	 * outer plan's slot type; so build a separate one for them, the first
+	 * time we need it.
+	 */
+	if (aggstate->hash_spill_evaltrans == NULL)
+	{
+		PlanState  *ps = &aggstate->ss.ps;
+		const TupleTableSlotOps *outerops = ps->outerops;
+		bool		outeropsfixed = ps->outeropsfixed;
+		bool		outeropsset = ps->outeropsset;
+		MemoryContext oldcontext;
+
+		oldcontext = MemoryContextSwitchTo(ps->state->es_query_cxt);
+
+		ps->outerops = &TTSOpsMinimalTuple;
+		ps->outeropsfixed = true;
+		ps->outeropsset = true;
+
+		aggstate->hash_spill_evaltrans =
+			ExecBuildAggTrans(aggstate, &aggstate->phases[0], false, true);
+
+		ps->outerops = outerops;
+		ps->outeropsfixed = outeropsfixed;
+		ps->outeropsset = outeropsset;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	/*
+	 * Each batch only processes one grouping set; set the rest to NULL so
+	 * that the transition expression knows to ignore them.
+	 */
+	MemSet(aggstate->hash_pergroup, 0,
+		   sizeof(AggStatePerGroup) * aggstate->num_hashes);
+
+	/* free memory and reset hash tables */
+	ReScanExprContext(aggstate->hashcontext);
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+		ResetTupleHashTable(aggstate->perhash[setno].hashtable);
+
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_batches_used++;
+
+	select_current_set(aggstate, batch->setno, true);
+	perhash = &aggstate->perhash[batch->setno];
+
+	while ((tuple = hashagg_batch_read(batch, &hash)) != NULL)
+	{
+		TupleHashTable hashtable = perhash->hashtable;
+		TupleHashEntry entry;
+		bool		isnew = false;
+		bool	   *p_isnew;
+		bool		dummynull;
+
+		/* tuples read from a shared tuplestore belong to the accessor */
+		ExecStoreMinimalTuple(tuple, spillslot, batch->input_file != NULL);
+		tmpcontext->ecxt_outertuple = spillslot;
+
+		/* if hash table already spilled, don't create new entries */
+		p_isnew = aggstate->hash_spill_mode ? NULL : &isnew;
+
+		prepare_hash_slot(perhash, spillslot);
+		entry = LookupTupleHashEntryHash(hashtable, perhash->hashslot,
+										 p_isnew, hash);
+
+		if (entry != NULL)
+		{
+			if (isnew)
+				initialize_hash_entry(aggstate, hashtable, entry);
+			aggstate->hash_pergroup[batch->setno] = entry->additional;
+
+			/* Advance the aggregates (or combine functions) */
+			ExecEvalExprSwitchContext(aggstate->hash_spill_evaltrans,
+									  tmpcontext,
+									  &dummynull);
+		}
+		else
+		{
+			if (!spill_initialized)
+			{
+				/*
+				 * Avoid initializing the spill until we actually need it so
+				 * that we don't assign tapes that will never be used.
+				 */
+				spill_initialized = true;
+				hashagg_spill_init(&spill, batch->used_bits,
+								   batch->input_tuples,
+								   aggstate->hashentrysize);
+			}
+			/* no memory for a new group, spill */
+			hashagg_spill_tuple(aggstate, &spill, spillslot, hash);
+		}
+
+		/*
+		 * Reset per-input-tuple context after each tuple, but note that the
+		 * hash lookups do this too
+		 */
+		ResetExprContext(tmpcontext);
+	}
+
+	if (batch->input_file != NULL)
+		BufFileClose(batch->input_file);
+	else
+		sts_end_parallel_scan(batch->input_sts);
+
+	/* change back to phase 0 */
+	aggstate->hash_pergroup[batch->setno] = NULL;
+
+	if (spill_initialized)
+		hashagg_spill_finish(aggstate, &spill, batch->setno,
+							 batch->used_bits);
+
+	aggstate->hash_mem_peak = Max(aggstate->hash_mem_peak,
+								  hash_agg_mem_used(aggstate));
+	aggstate->hash_spill_mode = false;
+
+	pfree(batch);
+
+	/* Initialize to walk the hash table */
+	ResetTupleHashIterator(perhash->hashtable, &perhash->hashiter);
+
+	return true;
+}
+
 /*
  * ExecAgg for hashed case: retrieving groups from hash table
+ *
+ * After exhausting in-memory tuples, also try refilling the hash table using
+ * previously-spilled tuples. Only returns NULL after all in-memory and
+ * spilled tuples are exhausted.
  */
 static TupleTableSlot *
 agg_retrieve_hash_table(AggState *aggstate)
+{
+	TupleTableSlot *result = NULL;
+
+	while (result == NULL)
+	{
+		result = agg_retrieve_hash_table_in_memory(aggstate);
+		if (result == NULL)
+		{
+			if (!agg_refill_hash_table(aggstate))
+			{
+				aggstate->agg_done = true;
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+/*
+ * Retrieve the groups from the in-memory hash tables without considering any
+ * spilled tuples.
+ */
+static TupleTableSlot *
+agg_retrieve_hash_table_in_memory(AggState *aggstate)
 {
 	ExprContext *econtext;
 	AggStatePerAgg peragg;
@@ -2011,8 +2432,7 @@ agg_retrieve_hash_table(AggState *aggstate)
 			}
 			else
 			{
-				/* No more hashtables, so done */
-				aggstate->agg_done = true;
+				/* No more in-memory hashtables */
 				return NULL;
 			}
 		}
@@ -2069,6 +2489,593 @@ agg_retrieve_hash_table(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * Memory currently used by the hash tables: the tables' bucket arrays and
+ * the group representative tuples and transition states.
+ */
+static Size
+hash_agg_mem_used(AggState *aggstate)
+{
+	Size		meta_mem;
+	Size		hash_mem;
+
+	meta_mem = MemoryContextMemAllocated(aggstate->hash_metacxt, true);
+	hash_mem = MemoryContextMemAllocated(
+		aggstate->hashcontext->ecxt_per_tuple_memory, true);
+
+	return meta_mem + hash_mem;
+}
+
+/*
+ * After a new group is created, check whether the hash tables have exceeded
+ * work_mem, and if so, enter spill mode: existing groups keep being
+ * advanced, but tuples belonging to new groups are written out to disk.
+ */
+static void
+hash_agg_check_limits(AggState *aggstate)
+{
+	Size		mem_used = hash_agg_mem_used(aggstate);
+
+	aggstate->hash_mem_peak = Max(aggstate->hash_mem_peak, mem_used);
+
+	/*
+	 * Don't spill unless there's at least one group in the hash table so we
+	 * can be sure to make progress even in edge cases.
+	 */
+	if (aggstate->hash_ngroups_current > 0 &&
+		mem_used > aggstate->hash_mem_limit)
+		hash_agg_enter_spill_mode(aggstate);
+}
+
+/*
+ * Enter "spill mode", meaning that no new groups are added to any of the
+ * hash tables. Tuples that would create a new group are instead spilled, and
+ * processed later.
+ */
+static void
+hash_agg_enter_spill_mode(AggState *aggstate)
+{
+	Size		mem_used = hash_agg_mem_used(aggstate);
+
+	if (aggstate->hash_spill_mode)
+		return;
+
+	aggstate->hash_spill_mode = true;
+
+	/*
+	 * Now that we know how much memory the groups actually take, use that
+	 * for sizing the partitions rather than the planner's estimate.
+	 */
+	if (aggstate->hash_ngroups_current > 0)
+		aggstate->hashentrysize =
+			(double) mem_used / (double) aggstate->hash_ngroups_current;
+
+	/* first time spilling in this pass? set up the spills */
+	if (aggstate->hash_spills == NULL)
+	{
+		aggstate->hash_ever_spilled = true;
+		aggstate->hash_spills =
+			MemoryContextAllocZero(aggstate->ss.ps.state->es_query_cxt,
+								   sizeof(HashAggSpill) * aggstate->num_hashes);
+	}
+}
+
+/*
+ * Choose a reasonable number of buckets for the initial hash table size.
+ *
+ * The planner's group estimate can be far off, so don't trust it to the
+ * point of allocating a bucket array that wouldn't fit in memory anyway.
+ */
+static long
+hash_choose_num_buckets(double hashentrysize, long ngroups, Size memory)
+{
+	long		max_nbuckets;
+	long		nbuckets = ngroups;
+
+	max_nbuckets = memory / hashentrysize;
+
+	/*
+	 * Leave room for slop to avoid a case where the initial hash table size
+	 * exceeds the memory limit (though that may still happen in edge cases).
+	 */
+	max_nbuckets >>= 1;
+
+	if (nbuckets > max_nbuckets)
+		nbuckets = max_nbuckets;
+
+	return Max(nbuckets, 1);
+}
+
+/*
+ * Determine the number of partitions to create when spilling, which will
+ * always be a power of two. If log2_npartitions is non-NULL, set
+ * *log2_npartitions to the log2() of the number of partitions.
+ */
+static int
+hash_choose_num_partitions(double input_groups, double hashentrysize,
+						   int used_bits, int *log2_npartitions)
+{
+	Size		mem_wanted;
+	int			partition_limit;
+	int			npartitions;
+	int			partition_bits;
+
+	/*
+	 * Avoid creating so many partitions that the memory requirements of the
+	 * open partition files are greater than 1/4 of work_mem.
+	 */
+	partition_limit = (work_mem * 1024L * 0.25) / BLCKSZ;
+
+	mem_wanted = HASHAGG_PARTITION_FACTOR * input_groups * hashentrysize;
+
+	/* make enough partitions so that each one is likely to fit in memory */
+	npartitions = 1 + (mem_wanted / (work_mem * 1024L));
+
+	if (npartitions > partition_limit)
+		npartitions = partition_limit;
+
+	if (npartitions < HASHAGG_MIN_PARTITIONS)
+		npartitions = HASHAGG_MIN_PARTITIONS;
+	if (npartitions > HASHAGG_MAX_PARTITIONS)
+		npartitions = HASHAGG_MAX_PARTITIONS;
+
+	/* ceil(log2(npartitions)) */
+	partition_bits = my_log2(npartitions);
+
+	/* make sure that we don't exhaust the hash bits */
+	if (partition_bits + used_bits >= 32)
+		partition_bits = 32 - used_bits;
+
+	if (log2_npartitions != NULL)
+		*log2_npartitions = partition_bits;
+
+	/* number of partitions will be a power of two */
+	npartitions = 1 << partition_bits;
+
+	return npartitions;
+}
+
+/*
+ * hashagg_spill_init
+ *
+ * Called after we determined that spilling is necessary. Chooses the number
+ * of partitions to create, and initializes them.  The partition files
+ * themselves are created lazily, when the first tuple is written to them.
+ */
+static void
+hashagg_spill_init(HashAggSpill *spill, int used_bits, double input_groups,
+				   double hashentrysize)
+{
+	int			npartitions;
+	int			partition_bits;
+
+	npartitions = hash_choose_num_partitions(input_groups, hashentrysize,
+											 used_bits, &partition_bits);
+
+	spill->partitions = palloc0(sizeof(BufFile *) * npartitions);
+	spill->ntuples = palloc0(sizeof(int64) * npartitions);
+	spill->npartitions = npartitions;
+	spill->shift = 32 - used_bits - partition_bits;
+	spill->mask = (npartitions - 1) << spill->shift;
+}
+
+/*
+ * hashagg_spill_tuple
+ *
+ * Write the tuple, preceded by its hash value, to the partition selected by
+ * the next unused bits of the hash.
+ */
+static void
+hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
+					TupleTableSlot *inputslot, uint32 hash)
+{
+	MinimalTuple tuple;
+	bool		shouldFree;
+	int			partition;
+	BufFile    *file;
+	size_t		written;
+
+	Assert(spill->partitions != NULL);
+
+	tuple = ExecFetchSlotMinimalTuple(inputslot, &shouldFree);
+
+	partition = (hash & spill->mask) >> spill->shift;
+	spill->ntuples[partition]++;
+
+	file = spill->partitions[partition];
+	if (file == NULL)
+	{
+		MemoryContext oldcontext;
+
+		/* BufFile must live as long as the spill itself */
+		oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+		file = BufFileCreateCompressTemp(false);
+		MemoryContextSwitchTo(oldcontext);
+		spill->partitions[partition] = file;
+	}
+
+	written = BufFileWrite(file, (void *) &hash, sizeof(uint32));
+	if (written != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to HashAgg temporary file: %m")));
+
+	written = BufFileWrite(file, (void *) tuple, tuple->t_len);
+	if (written != tuple->t_len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to HashAgg temporary file: %m")));
+
+	aggstate->hash_disk_used += sizeof(uint32) + tuple->t_len;
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * hashagg_batch_read
+ *
+ * Read the next tuple, and its hash value, from a batch's spill file.
+ * Returns NULL at the end of the file.  The tuple is palloc'd in the
+ * current memory context, except when reading a shared partition, where it
+ * points into the accessor's buffer and is only valid until the next call.
+ */
+static MinimalTuple
+hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
+{
+	BufFile    *file = batch->input_file;
+	uint32		hash;
+	uint32		t_len;
+	MinimalTuple tuple;
+	size_t		nread;
+
+	if (file == NULL)
+		return sts_parallel_scan_next(batch->input_sts, hashp);
+
+	nread = BufFileRead(file, (void *) &hash, sizeof(uint32));
+	if (nread == 0)
+		return NULL;
+	if (nread != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("unexpected EOF for HashAgg temporary file: read only %zu of %zu bytes",
+						nread, sizeof(uint32))));
+	if (hashp != NULL)
+		*hashp = hash;
+
+	nread = BufFileRead(file, (void *) &t_len, sizeof(t_len));
+	if (nread != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("unexpected EOF for HashAgg temporary file: read only %zu of %zu bytes",
+						nread, sizeof(uint32))));
+
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+
+	nread = BufFileRead(file, (void *) ((char *) tuple + sizeof(uint32)),
+						t_len - sizeof(uint32));
+	if (nread != t_len - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("unexpected EOF for HashAgg temporary file: read only %zu of %zu bytes",
+						nread, t_len - sizeof(uint32))));
+
+	return tuple;
+}
+
+/*
+ * hashagg_finish_initial_spills
+ *
+ * After the input has been exhausted for the first time, turn the tuples
+ * spilled by each grouping set into batches to be processed later.
+ */
+static void
+hashagg_finish_initial_spills(AggState *aggstate)
+{
+	int			setno;
+
+	if (aggstate->hash_spills == NULL)
+		return;
+
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+	{
+		HashAggSpill *spill = &aggstate->hash_spills[setno];
+
+		if (spill->partitions != NULL)
+			hashagg_spill_finish(aggstate, spill, setno, 0);
+	}
+
+	pfree(aggstate->hash_spills);
+	aggstate->hash_spills = NULL;
+}
+
+/*
+ * hashagg_spill_finish
+ *
+ * Turn each non-empty partition of the spill into a new batch, rewound and
+ * ready to be read back, and free the spill's bookkeeping.
+ */
+static void
+hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill, int setno,
+					 int used_bits)
+{
+	int			partition_bits = my_log2(spill->npartitions);
+	int			i;
+
+	for (i = 0; i < spill->npartitions; i++)
+	{
+		BufFile    *file = spill->partitions[i];
+		MemoryContext oldcontext;
+		HashAggBatch *new_batch;
+
+		/* partition is empty */
+		if (file == NULL)
+			continue;
+
+		if (BufFileSeek(file, 0, 0L, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind HashAgg temporary file: %m")));
+
+		oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+		new_batch = palloc0(sizeof(HashAggBatch));
+		new_batch->setno = setno;
+		new_batch->used_bits = used_bits + partition_bits;
+		new_batch->input_file = file;
+		new_batch->input_tuples = spill->ntuples[i];
+		aggstate->hash_batches = lappend(aggstate->hash_batches, new_batch);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	pfree(spill->ntuples);
+	pfree(spill->partitions);
+	spill->partitions = NULL;
+	spill->ntuples = NULL;
+}
+
+/*
+ * Free resources related to a spilled HashAgg.
+ */
+static void
+hashagg_reset_spill_state(AggState *aggstate)
+{
+	ListCell   *lc;
+
+	/* free spills from initial pass */
+	if (aggstate->hash_spills != NULL)
+	{
+		int			setno;
+
+		for (setno = 0; setno < aggstate->num_hashes; setno++)
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+			int			i;
+
+			if (spill->partitions == NULL)
+				continue;
+
+			for (i = 0; i < spill->npartitions; i++)
+			{
+				if (spill->partitions[i] != NULL)
+					BufFileClose(spill->partitions[i]);
+			}
+			pfree(spill->ntuples);
+			pfree(spill->partitions);
+		}
+		pfree(aggstate->hash_spills);
+		aggstate->hash_spills = NULL;
+	}
+
+	/* free batches */
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		if (batch->input_file != NULL)
+			BufFileClose(batch->input_file);
+		else
+			sts_end_parallel_scan(batch->input_sts);
+		pfree(batch);
+	}
+	list_free(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+}
+
+/*
+ * Parallel HashAggregate: route this participant's share of the input to
+ * the shared partitions, then wait for the other participants to do the
+ * same.
+ *
+ * A participant that attaches after partitioning has finished doesn't read
+ * the input at all; since the other participants have all exhausted the
+ * (parallel-aware) input, there can't be anything left for it.
+ */
+static void
+agg_partition_parallel_input(AggState *aggstate)
+{
+	ParallelAggState *pstate = aggstate->hash_parallel_state;
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	int			i;
+
+	Assert(aggstate->num_hashes == 1);
+
+	if (BarrierAttach(&pstate->barrier) == PHA_PARTITIONING)
+	{
+		for (;;)
+		{
+			TupleTableSlot *outerslot;
+			MinimalTuple tuple;
+			bool		shouldFree;
+			uint32		hash;
+			int			partno;
+
+			outerslot = fetch_input_tuple(aggstate);
+			if (TupIsNull(outerslot))
+				break;
+
+			prepare_hash_slot(perhash, outerslot);
+			hash = TupleHashTableHash(perhash->hashtable, perhash->hashslot);
+
+			/* use the high bits, as hashagg_spill_tuple does */
+			partno = 0;
+			if (pstate->partition_bits > 0)
+				partno = hash >> (32 - pstate->partition_bits);
+
+			tuple = ExecFetchSlotMinimalTuple(outerslot, &shouldFree);
+			sts_puttuple(aggstate->hash_parallel_partitions[partno],
+						 &hash, tuple);
+			if (shouldFree)
+				pfree(tuple);
+
+			ResetExprContext(tmpcontext);
+		}
+
+		for (i = 0; i < pstate->npartitions; i++)
+			sts_end_write(aggstate->hash_parallel_partitions[i]);
+
+		BarrierArriveAndWait(&pstate->barrier,
+							 WAIT_EVENT_HASH_AGG_PARTITIONING);
+	}
+
+	Assert(BarrierPhase(&pstate->barrier) == PHA_AGGREGATING);
+	aggstate->hash_parallel_attached = true;
+}
+
+/*
+ * Parallel HashAggregate: claim the next shared partition that no
+ * participant has processed yet, and queue it up as a batch.  Returns false
+ * if there are none left (or this isn't a Parallel HashAggregate).
+ */
+static bool
+hashagg_claim_partition(AggState *aggstate)
+{
+	ParallelAggState *pstate = aggstate->hash_parallel_state;
+	SharedTuplestoreAccessor *accessor;
+	HashAggBatch *batch;
+	MemoryContext oldcontext;
+	uint32		partno;
+
+	if (pstate == NULL || !aggstate->hash_parallel_attached)
+		return false;
+
+	partno = pg_atomic_fetch_add_u32(&pstate->next_partition, 1);
+	if (partno >= pstate->npartitions)
+	{
+		/* all done; the shared files are cleaned up with the DSM segment */
+		BarrierDetach(&pstate->barrier);
+		aggstate->hash_parallel_attached = false;
+		return false;
+	}
+
+	accessor = aggstate->hash_parallel_partitions[partno];
+	sts_begin_parallel_scan(accessor);
+
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+	batch = palloc0(sizeof(HashAggBatch));
+	batch->setno = 0;
+	batch->used_bits = pstate->partition_bits;
+	batch->input_sts = accessor;
+	batch->input_tuples = aggstate->perhash[0].aggnode->numGroups;
+	aggstate->hash_batches = lcons(batch, aggstate->hash_batches);
+	MemoryContextSwitchTo(oldcontext);
+
+	return true;
+}
+
+/*
+ * Choose the number of shared partitions for a Parallel HashAggregate.  We
+ * want each partition to fit in work_mem, as when spilling, but also enough
+ * partitions that the participants can share the work out evenly.  As when
+ * spilling, the write buffers for the partitions are limited to 1/4 of
+ * work_mem, which takes precedence over spreading the work.
+ */
+static int
+hashagg_parallel_num_partitions(AggState *aggstate, int nparticipants,
+								int *partition_bits)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	int			partition_limit;
+	int			npartitions;
+	int			bits;
+
+	partition_limit = (work_mem * 1024L * 0.25) / HASHAGG_PARALLEL_WRITE_BUFFER;
+
+	/* numGroups is the planner's per-participant estimate */
+	npartitions = hash_choose_num_partitions((double) node->numGroups *
+											 nparticipants,
+											 aggstate->hashentrysize,
+											 0, &bits);
+
+	while (npartitions < 2 * nparticipants &&
+		   npartitions < HASHAGG_MAX_PARTITIONS &&
+		   npartitions * 2 <= partition_limit)
+	{
+		npartitions *= 2;
+		bits++;
+	}
+
+	/* hash_choose_num_partitions assumed smaller buffers than ours */
+	while (npartitions > partition_limit &&
+		   npartitions > HASHAGG_MIN_PARTITIONS)
+	{
+		npartitions /= 2;
+		bits--;
+	}
+
+	*partition_bits = bits;
+	return npartitions;
+}
+
+static Size
+hashagg_parallel_state_size(int npartitions, int nparticipants)
+{
+	return add_size(offsetof(ParallelAggState, partitions),
+					mul_size(npartitions,
+							 MAXALIGN(sts_estimate(nparticipants))));
+}
+
+/*
+ * Set up the shared partitions, and our accessors for them.  Used both for
+ * initial setup and before a rescan.
+ */
+static void
+hashagg_parallel_initialize(AggState *aggstate, ParallelAggState *pstate)
+{
+	MemoryContext oldcontext;
+	int			i;
+
+	BarrierInit(&pstate->barrier, 0);
+	pg_atomic_init_u32(&pstate->next_partition, 0);
+
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	if (aggstate->hash_parallel_partitions == NULL)
+		aggstate->hash_parallel_partitions =
+			palloc0(sizeof(SharedTuplestoreAccessor *) * pstate->npartitions);
+
+	for (i = 0; i < pstate->npartitions; i++)
+	{
+		SharedTuplestore *sts = ParallelAggPartition(pstate, i);
+		char		name[MAXPGPATH];
+
+		/* the leader is participant 0 */
+		memset(sts, 0, pstate->sts_size);
+		snprintf(name, sizeof(name), "hashagg%d.%d",
+				 aggstate->ss.ps.plan->plan_node_id, i);
+		aggstate->hash_parallel_partitions[i] =
+			sts_initialize(sts, pstate->nparticipants, 0, sizeof(uint32),
+						   SHARED_TUPLESTORE_SINGLE_PASS, &pstate->fileset,
+						   name);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	aggstate->hash_parallel_state = pstate;
+	aggstate->hash_parallel_attached = false;
+}
+
 /* -----------------
  * ExecInitAgg
  *
@@ -2198,6 +3205,11 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	{
 		ExecAssignExprContext(estate, &aggstate->ss.ps);
 		aggstate->hashcontext = aggstate->ss.ps.ps_ExprContext;
+
+		/* the hash tables' own bookkeeping is accounted separately */
+		aggstate->hash_metacxt = AllocSetContextCreate(estate->es_query_cxt,
+													   "HashAgg meta context",
+													   ALLOCSET_DEFAULT_SIZES);
 	}
 
 	ExecAssignExprContext(estate, &aggstate->ss.ps);
@@ -2449,6 +3461,14 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		/* this is an array of pointers, not structures */
 		aggstate->hash_pergroup = pergroups;
 
+		/* slot for reading back tuples spilled to disk */
+		aggstate->hash_spill_slot = ExecInitExtraTupleSlot(estate, scanDesc,
+														   &TTSOpsMinimalTuple);
+
+		aggstate->hash_mem_limit = work_mem * 1024L;
+		aggstate->hashentrysize = hash_agg_entry_size(numaggs);
+		aggstate->hash_batches_used = 1;
+
 		find_hash_columns(aggstate);
 		build_hash_table(aggstate);
 		aggstate->table_filled = false;
@@ -3353,6 +4373,8 @@ ExecEndAgg(AggState *node)
 	if (node->hashcontext)
 		ReScanExprContext(node->hashcontext);
 
+	hashagg_reset_spill_state(node);
+
 	/*
 	 * We don't actually free any ExprContexts here (see comment in
 	 * ExecFreeExprContext), just unlinking the output one from the plan node
@@ -3394,9 +4416,12 @@ ExecReScanAgg(AggState *node)
 		 * If we do have the hash table, and the subplan does not have any
 		 * parameter changes, and none of our own parameter changes affect
 		 * input expressions of the aggregated functions, then we can just
-		 * rescan the existing hash table; no need to build it again.
+		 * rescan the existing hash table; no need to build it again.  That
+		 * doesn't work if the input was spilled, though, since the spilled
+		 * groups have already been emitted and discarded.
 		 */
-		if (outerPlan->chgParam == NULL &&
+		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
+			node->hash_parallel_state == NULL &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -3453,6 +4478,19 @@ ExecReScanAgg(AggState *node)
 	 */
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
+		hashagg_reset_spill_state(node);
+
+		/* the shared state is reset by ExecAggReInitializeDSM */
+		if (node->hash_parallel_attached)
+		{
+			BarrierDetach(&node->hash_parallel_state->barrier);
+			node->hash_parallel_attached = false;
+		}
+
+		node->hash_ever_spilled = false;
+		node->hash_spill_mode = false;
+		node->hash_ngroups_current = 0;
+
 		ReScanExprContext(node->hashcontext);
 		/* Rebuild an empty hash table */
 		build_hash_table(node);
@@ -3683,3 +4721,125 @@ aggregate_dummy(PG_FUNCTION_ARGS)
 		 fcinfo->flinfo->fn_oid);
 	return (Datum) 0;			/* keep compiler quiet */
 }
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecAggEstimate
+ *
+ *		Estimate space required for the shared partitions of a
+ *		Parallel HashAggregate.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggEstimate(AggState *node, ParallelContext *pcxt)
+{
+	int			nparticipants = pcxt->nworkers + 1;
+	int			npartitions;
+	int			partition_bits;
+
+	Assert(node->aggstrategy == AGG_HASHED && node->num_hashes == 1);
+
+	npartitions = hashagg_parallel_num_partitions(node, nparticipants,
+												  &partition_bits);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   hashagg_parallel_state_size(npartitions,
+													   nparticipants));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggInitializeDSM
+ *
+ *		Set up the shared partitions for a Parallel HashAggregate.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt)
+{
+	ParallelAggState *pstate;
+	int			nparticipants = pcxt->nworkers + 1;
+	int			npartitions;
+	int			partition_bits;
+
+	/*
+	 * Without a real DSM segment there can't be any workers, so just do an
+	 * ordinary hash aggregation.
+	 */
+	if (pcxt->seg == NULL)
+		return;
+
+	npartitions = hashagg_parallel_num_partitions(node, nparticipants,
+												  &partition_bits);
+	pstate = shm_toc_allocate(pcxt->toc,
+							  hashagg_parallel_state_size(npartitions,
+														  nparticipants));
+	pstate->nparticipants = nparticipants;
+	pstate->npartitions = npartitions;
+	pstate->partition_bits = partition_bits;
+	pstate->sts_size = MAXALIGN(sts_estimate(nparticipants));
+	SharedFileSetInit(&pstate->fileset, pcxt->seg);
+
+	hashagg_parallel_initialize(node, pstate);
+
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, pstate);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggReInitializeDSM
+ *
+ *		Reset shared state before beginning a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt)
+{
+	ParallelAggState *pstate;
+
+	if (pcxt->seg == NULL)
+		return;
+
+	pstate = shm_toc_lookup(pcxt->toc, node->ss.ps.plan->plan_node_id, false);
+
+	/* Clear any partition files left over from the previous scan. */
+	SharedFileSetDeleteAll(&pstate->fileset);
+
+	hashagg_parallel_initialize(node, pstate);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggInitializeWorker
+ *
+ *		Attach worker to the shared partitions.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggInitializeWorker(AggState *node, ParallelWorkerContext *pwcxt)
+{
+	ParallelAggState *pstate;
+	MemoryContext oldcontext;
+	int			i;
+
+	pstate = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+
+	/* the leader didn't set up shared state; see ExecAggInitializeDSM */
+	if (pstate == NULL)
+		return;
+
+	SharedFileSetAttach(&pstate->fileset, pwcxt->seg);
+
+	oldcontext = MemoryContextSwitchTo(node->ss.ps.state->es_query_cxt);
+	node->hash_parallel_partitions =
+		palloc(sizeof(SharedTuplestoreAccessor *) * pstate->npartitions);
+	for (i = 0; i < pstate->npartitions; i++)
+		node->hash_parallel_partitions[i] =
+			sts_attach(ParallelAggPartition(pstate, i),
+					   ParallelWorkerNumber + 1, &pstate->fileset);
+	MemoryContextSwitchTo(oldcontext);
+
+	node->hash_parallel_state = pstate;
+	node->hash_parallel_attached = false;
+}
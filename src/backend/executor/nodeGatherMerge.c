@@ -19,6 +19,7 @@
 #include "executor/execdebug.h"
 #include "executor/execParallel.h"
 #include "executor/nodeGatherMerge.h"
+#include "executor/nodeSort.h"
 #include "executor/nodeSubplan.h"
 #include "executor/tqueue.h"
 #include "lib/binaryheap.h"
@@ -54,6 +55,7 @@ typedef struct GMReaderTupleBuffer
 static TupleTableSlot *ExecGatherMerge(PlanState *pstate);
 static int32 heap_compare_slots(Datum a, Datum b, void *arg);
 static TupleTableSlot *gather_merge_getnext(GatherMergeState *gm_state);
+static TupleTableSlot *gather_merge_getnext_by_range(GatherMergeState *gm_state);
 static HeapTuple gm_readnext_tuple(GatherMergeState *gm_state, int nreader,
 				  bool nowait, bool *done);
 static void ExecShutdownGatherMergeWorkers(GatherMergeState *node);
@@ -109,6 +111,12 @@ ExecInitGatherMerge(GatherMerge *node, EState *estate, int eflags)
 	outerNode = outerPlan(node);
 	outerPlanState(gm_state) = ExecInitNode(outerNode, estate, eflags);
 
+	/*
+	 * If the outer plan is a Parallel Sort, each worker returns a separate
+	 * key range of the sorted output, so there's nothing left to merge.
+	 */
+	gm_state->gm_by_range = IsA(outerNode, Sort) && outerNode->parallel_aware;
+
 	/*
 	 * Leader may access ExecProcNode result directly (if
 	 * need_to_scan_locally), or from workers via tuple queue.  So we can't
@@ -247,8 +255,12 @@ ExecGatherMerge(PlanState *pstate)
 			}
 		}
 
-		/* allow leader to participate if enabled or no choice */
-		if (parallel_leader_participation || node->nreaders == 0)
+		/*
+		 * allow leader to participate if enabled or no choice; but the output
+		 * of a Parallel Sort must come entirely from its workers
+		 */
+		if ((parallel_leader_participation && !node->gm_by_range) ||
+			node->nreaders == 0)
 			node->need_to_scan_locally = true;
 		node->initialized = true;
 	}
@@ -264,7 +276,10 @@ ExecGatherMerge(PlanState *pstate)
 	 * Get next tuple, either from one of our workers, or by running the plan
 	 * ourselves.
 	 */
-	slot = gather_merge_getnext(node);
+	if (node->gm_by_range && node->nreaders > 0)
+		slot = gather_merge_getnext_by_range(node);
+	else
+		slot = gather_merge_getnext(node);
 	if (TupIsNull(slot))
 		return NULL;
 
@@ -350,6 +365,11 @@ ExecReScanGatherMerge(GatherMergeState *node)
 	/* Free any unused tuples, so we don't leak memory across rescans */
 	gather_merge_clear_tuples(node);
 
+	/* Forget which workers returned which key ranges */
+	if (node->gm_range_readers)
+		pfree(node->gm_range_readers);
+	node->gm_range_readers = NULL;
+
 	/* Mark node so that shared state will be rebuilt at next call */
 	node->initialized = false;
 	node->gm_initialized = false;
@@ -590,6 +610,51 @@ gather_merge_getnext(GatherMergeState *gm_state)
 	}
 }
 
+/*
+ * Get the next tuple from a Parallel Sort.  Since each worker returns a
+ * separate key range of the sorted output, we just read the workers one
+ * after another, in the order of their ranges.
+ */
+static TupleTableSlot *
+gather_merge_getnext_by_range(GatherMergeState *gm_state)
+{
+	if (gm_state->gm_range_readers == NULL)
+	{
+		/*
+		 * Make sure all the workers we launched have started, so that we
+		 * don't wait forever for runs from workers that failed to start.
+		 */
+		WaitForParallelWorkersToAttach(gm_state->pei->pcxt);
+
+		gm_state->gm_range_readers =
+			(int *) palloc(gm_state->nreaders * sizeof(int));
+		gm_state->gm_nrange_readers =
+			ExecSortGetRangeWorkers(castNode(SortState,
+											 outerPlanState(gm_state)),
+									gm_state->gm_range_readers);
+		gm_state->gm_next_range = 0;
+	}
+
+	while (gm_state->gm_next_range < gm_state->gm_nrange_readers)
+	{
+		/* readers are numbered from 1, as in gm_slots[] */
+		int			reader = gm_state->gm_range_readers[gm_state->gm_next_range] + 1;
+		HeapTuple	tup;
+		bool		done = false;
+
+		Assert(reader <= gm_state->nreaders);
+		tup = gm_readnext_tuple(gm_state, reader, false, &done);
+		if (HeapTupleIsValid(tup))
+			return ExecStoreHeapTuple(tup, gm_state->gm_slots[reader], true);
+
+		/* this worker's range is exhausted, so move on to the next one */
+		Assert(done);
+		gm_state->gm_next_range++;
+	}
+
+	return NULL;
+}
+
 /*
  * Read tuple(s) for given reader in nowait mode, and load into its tuple
  * array, until we have MAX_TUPLE_STORE of them or would have to block.
@@ -65,9 +65,11 @@ static inline HashJoinTuple ExecParallelHashFirstTuple(HashJoinTable table,
 						   int bucketno);
 static inline HashJoinTuple ExecParallelHashNextTuple(HashJoinTable table,
 						  HashJoinTuple tuple);
-static inline void ExecParallelHashPushTuple(dsa_pointer_atomic *head,
+static inline void ExecParallelHashPushTuple(ParallelHashJoinBucket *bucket,
 						  HashJoinTuple tuple,
 						  dsa_pointer tuple_shared);
+static inline void ExecHashPushTuple(HashJoinBucketData *bucket,
+				  HashJoinTuple tuple);
 static void ExecParallelHashJoinSetUpBatches(HashJoinTable hashtable, int nbatch);
 static void ExecParallelHashEnsureBatchAccessors(HashJoinTable hashtable);
 static void ExecParallelHashRepartitionFirst(HashJoinTable hashtable);
@@ -138,7 +140,6 @@ static void
 MultiExecPrivateHash(HashState *node)
 {
 	PlanState  *outerNode;
-	List	   *hashkeys;
 	HashJoinTable hashtable;
 	TupleTableSlot *slot;
 	ExprContext *econtext;
@@ -153,7 +154,6 @@ MultiExecPrivateHash(HashState *node)
 	/*
 	 * set expression context
 	 */
-	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
 	/*
@@ -166,12 +166,15 @@ MultiExecPrivateHash(HashState *node)
 			break;
 		/* We have to compute the hash value */
 		econtext->ecxt_innertuple = slot;
-		if (ExecHashGetHashValue(hashtable, econtext, hashkeys,
-								 false, hashtable->keepNulls,
-								 &hashvalue))
+		if (ExecHashEvalHashValue(node->hash_expr, econtext, &hashvalue))
 		{
 			int			bucketNumber;
 
+			if (hashtable->bloomBuild)
+				bloom_add_element(hashtable->bloomBuild,
+								  (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -194,11 +197,15 @@ MultiExecPrivateHash(HashState *node)
 		ExecHashIncreaseNumBuckets(hashtable);
 
 	/* Account for the buckets in spaceUsed (reported in EXPLAIN ANALYZE) */
-	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
+	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinBucketData);
 	if (hashtable->spaceUsed > hashtable->spacePeak)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
 	hashtable->partialTuples = hashtable->totalTuples;
+
+	/* The bloom filter is complete, so the outer scan may start using it */
+	hashtable->bloomFilter = hashtable->bloomBuild;
+	hashtable->bloomBuild = NULL;
 }
 
 /* ----------------------------------------------------------------
@@ -214,7 +221,6 @@ MultiExecParallelHash(HashState *node)
 {
 	ParallelHashJoinState *pstate;
 	PlanState  *outerNode;
-	List	   *hashkeys;
 	HashJoinTable hashtable;
 	TupleTableSlot *slot;
 	ExprContext *econtext;
@@ -231,7 +237,6 @@ MultiExecParallelHash(HashState *node)
 	/*
 	 * set expression context
 	 */
-	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
 	/*
@@ -282,13 +287,31 @@ MultiExecParallelHash(HashState *node)
 				if (TupIsNull(slot))
 					break;
 				econtext->ecxt_innertuple = slot;
-				if (ExecHashGetHashValue(hashtable, econtext, hashkeys,
-										 false, hashtable->keepNulls,
-										 &hashvalue))
+				if (ExecHashEvalHashValue(node->hash_expr, econtext,
+										  &hashvalue))
+				{
+					if (hashtable->bloomBuild)
+						bloom_add_element(hashtable->bloomBuild,
+										  (unsigned char *) &hashvalue,
+										  sizeof(hashvalue));
 					ExecParallelHashTableInsert(hashtable, slot, hashvalue);
+				}
 				hashtable->partialTuples++;
 			}
 
+			/*
+			 * Fold our share of the bloom filter into the shared one before
+			 * anyone can begin probing it.
+			 */
+			if (hashtable->bloomBuild)
+			{
+				LWLockAcquire(&pstate->lock, LW_EXCLUSIVE);
+				bloom_union(dsa_get_address(hashtable->area,
+											pstate->bloom_filter),
+							hashtable->bloomBuild);
+				LWLockRelease(&pstate->lock);
+			}
+
 			/*
 			 * Make sure that any tuples we wrote to disk are visible to
 			 * others before anyone tries to load them.
@@ -333,6 +356,16 @@ MultiExecParallelHash(HashState *node)
 	hashtable->totalTuples = pstate->total_tuples;
 	ExecParallelHashEnsureBatchAccessors(hashtable);
 
+	/* Everyone has merged their bloom filters, so switch to the shared one */
+	if (hashtable->bloomBuild)
+	{
+		bloom_free(hashtable->bloomBuild);
+		hashtable->bloomBuild = NULL;
+	}
+	if (DsaPointerIsValid(pstate->bloom_filter))
+		hashtable->bloomFilter = dsa_get_address(hashtable->area,
+												 pstate->bloom_filter);
+
 	/*
 	 * The next synchronization point is in ExecHashJoin's HJ_BUILD_HASHTABLE
 	 * case, which will bring the build phase to PHJ_BUILD_DONE (if it isn't
@@ -365,6 +398,8 @@ ExecInitHash(Hash *node, EState *estate, int eflags)
 	hashstate->ps.ExecProcNode = ExecHash;
 	hashstate->hashtable = NULL;
 	hashstate->hashkeys = NIL;	/* will be set by parent HashJoin */
+	hashstate->hash_expr = NULL;	/* likewise */
+	hashstate->build_bloom = false; /* likewise */
 
 	/*
 	 * Miscellaneous initialization
@@ -493,6 +528,11 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 	hashtable->nbatch_original = nbatch;
 	hashtable->nbatch_outstart = nbatch;
 	hashtable->growEnabled = true;
+	hashtable->curstripe = 0;
+	hashtable->stripeFile = NULL;
+	hashtable->outerOrdinal = 0;
+	hashtable->outerMatched = NULL;
+	hashtable->outerMatchedSize = 0;
 	hashtable->totalTuples = 0;
 	hashtable->partialTuples = 0;
 	hashtable->skewTuples = 0;
@@ -509,6 +549,8 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 	hashtable->parallel_state = state->parallel_state;
 	hashtable->area = state->ps.state->es_query_dsa;
 	hashtable->batches = NULL;
+	hashtable->bloomFilter = NULL;
+	hashtable->bloomBuild = NULL;
 
 #ifdef HJDEBUG
 	printf("Hashjoin %p: initial nbatch = %d, nbuckets = %d\n",
@@ -572,6 +614,16 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 		PrepareTempTablespaces();
 	}
 
+	/*
+	 * If the outer scan wants a bloom filter, set up this backend's filter.
+	 * With Parallel Hash each participant fills in a private filter, and
+	 * merges it into the shared one once it's done hashing.  All of them
+	 * must be sized identically for that to work.
+	 */
+	if (state->build_bloom)
+		hashtable->bloomBuild = bloom_create((int64) Max(rows, 1.0),
+											 work_mem, 0);
+
 	MemoryContextSwitchTo(oldcxt);
 
 	if (hashtable->parallel_state)
@@ -613,6 +665,19 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 			 */
 			pstate->nbuckets = nbuckets;
 			ExecParallelHashTableAlloc(hashtable, 0);
+
+			/* Allocate the shared bloom filter, if requested. */
+			if (state->build_bloom)
+			{
+				int64		bloom_rows = (int64) Max(rows, 1.0);
+
+				pstate->bloom_filter =
+					dsa_allocate(hashtable->area,
+								 bloom_estimate(bloom_rows, work_mem));
+				bloom_init(dsa_get_address(hashtable->area,
+										   pstate->bloom_filter),
+						   bloom_rows, work_mem, 0);
+			}
 		}
 
 		/*
@@ -630,8 +695,8 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 		 */
 		MemoryContextSwitchTo(hashtable->batchCxt);
 
-		hashtable->buckets.unshared = (HashJoinTuple *)
-			palloc0(nbuckets * sizeof(HashJoinTuple));
+		hashtable->buckets.unshared = (HashJoinBucketData *)
+			palloc0(nbuckets * sizeof(HashJoinBucketData));
 
 		/*
 		 * Set up for skew optimization, if possible and there's a need for
@@ -752,8 +817,8 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 	 * Note that both nbuckets and nbatch must be powers of 2 to make
 	 * ExecHashGetBucketAndBatch fast.
 	 */
-	max_pointers = *space_allowed / sizeof(HashJoinTuple);
-	max_pointers = Min(max_pointers, MaxAllocSize / sizeof(HashJoinTuple));
+	max_pointers = *space_allowed / sizeof(HashJoinBucketData);
+	max_pointers = Min(max_pointers, MaxAllocSize / sizeof(HashJoinBucketData));
 	/* If max_pointers isn't a power of 2, must round it down to one */
 	mppow2 = 1L << my_log2(max_pointers);
 	if (max_pointers != mppow2)
@@ -775,7 +840,7 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 	 * If there's not enough space to store the projected number of tuples and
 	 * the required bucket headers, we will need multiple batches.
 	 */
-	bucket_bytes = sizeof(HashJoinTuple) * nbuckets;
+	bucket_bytes = sizeof(HashJoinBucketData) * nbuckets;
 	if (inner_rel_bytes + bucket_bytes > hash_table_bytes)
 	{
 		/* We'll need multiple batches */
@@ -805,12 +870,12 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 		 * NTUP_PER_BUCKET tuples, whose projected size already includes
 		 * overhead for the hash code, pointer to the next tuple, etc.
 		 */
-		bucket_size = (tupsize * NTUP_PER_BUCKET + sizeof(HashJoinTuple));
+		bucket_size = (tupsize * NTUP_PER_BUCKET + sizeof(HashJoinBucketData));
 		lbuckets = 1L << my_log2(hash_table_bytes / bucket_size);
 		lbuckets = Min(lbuckets, max_pointers);
 		nbuckets = (int) lbuckets;
 		nbuckets = 1 << my_log2(nbuckets);
-		bucket_bytes = nbuckets * sizeof(HashJoinTuple);
+		bucket_bytes = nbuckets * sizeof(HashJoinBucketData);
 
 		/*
 		 * Buckets are simple pointers to hashjoin tuples, while tupsize
@@ -851,13 +916,12 @@ ExecHashTableDestroy(HashJoinTable hashtable)
 	int			i;
 
 	/*
-	 * Make sure all the temp files are closed.  We skip batch 0, since it
-	 * can't have any temp files (and the arrays might not even exist if
-	 * nbatch is only 1).  Parallel hash joins don't use these files.
+	 * Make sure all the temp files are closed.  The arrays might not even
+	 * exist if nbatch is only 1.  Parallel hash joins don't use these files.
 	 */
 	if (hashtable->innerBatchFile != NULL)
 	{
-		for (i = 1; i < hashtable->nbatch; i++)
+		for (i = 0; i < hashtable->nbatch; i++)
 		{
 			if (hashtable->innerBatchFile[i])
 				BufFileClose(hashtable->innerBatchFile[i]);
@@ -865,6 +929,8 @@ ExecHashTableDestroy(HashJoinTable hashtable)
 				BufFileClose(hashtable->outerBatchFile[i]);
 		}
 	}
+	if (hashtable->stripeFile != NULL)
+		BufFileClose(hashtable->stripeFile);
 
 	/* Release working memory (batchCxt is a child, so it goes away too) */
 	MemoryContextDelete(hashtable->hashCxt);
@@ -895,7 +961,10 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 	/* safety check to avoid overflow */
 	if (oldnbatch > Min(INT_MAX / 2, MaxAllocSize / (sizeof(void *) * 2)))
+	{
+		hashtable->growEnabled = false;
 		return;
+	}
 
 	nbatch = oldnbatch * 2;
 	Assert(nbatch > 1);
@@ -951,7 +1020,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 		hashtable->buckets.unshared =
 			repalloc(hashtable->buckets.unshared,
-					 sizeof(HashJoinTuple) * hashtable->nbuckets);
+					 sizeof(HashJoinBucketData) * hashtable->nbuckets);
 	}
 
 	/*
@@ -960,7 +1029,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 * already been processed. We will free the old chunks as we go.
 	 */
 	memset(hashtable->buckets.unshared, 0,
-		   sizeof(HashJoinTuple) * hashtable->nbuckets);
+		   sizeof(HashJoinBucketData) * hashtable->nbuckets);
 	oldchunks = hashtable->chunks;
 	hashtable->chunks = NULL;
 
@@ -994,8 +1063,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				memcpy(copyTuple, hashTuple, hashTupleSize);
 
 				/* and add it back to the appropriate bucket */
-				copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-				hashtable->buckets.unshared[bucketno] = copyTuple;
+				ExecHashPushTuple(&hashtable->buckets.unshared[bucketno],
+								  copyTuple);
 			}
 			else
 			{
@@ -1031,8 +1100,9 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 * further expansion of nbatch.  This situation implies that we have
 	 * enough tuples of identical hashvalues to overflow spaceAllowed.
 	 * Increasing nbatch will not fix it since there's no way to subdivide the
-	 * group any more finely. We have to just gut it out and hope the server
-	 * has enough RAM.
+	 * group any more finely.  Instead, ExecHashTableInsert will start sending
+	 * the tuples that don't fit to the stripe file, and the batch will be
+	 * joined in several passes.
 	 */
 	if (nfreed == 0 || nfreed == ninmemory)
 	{
@@ -1075,7 +1145,7 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 			if (BarrierArriveAndWait(&pstate->grow_batches_barrier,
 									 WAIT_EVENT_HASH_GROW_BATCHES_ELECTING))
 			{
-				dsa_pointer_atomic *buckets;
+				ParallelHashJoinBucket *buckets;
 				ParallelHashJoinBatch *old_batch0;
 				int			new_nbatch;
 				int			i;
@@ -1142,29 +1212,37 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 					dtuples = (old_batch0->ntuples * 2.0) / new_nbatch;
 					dbuckets = ceil(dtuples / NTUP_PER_BUCKET);
 					dbuckets = Min(dbuckets,
-								   MaxAllocSize / sizeof(dsa_pointer_atomic));
+								   MaxAllocSize / sizeof(ParallelHashJoinBucket));
 					new_nbuckets = (int) dbuckets;
 					new_nbuckets = Max(new_nbuckets, 1024);
 					new_nbuckets = 1 << my_log2(new_nbuckets);
 					dsa_free(hashtable->area, old_batch0->buckets);
 					hashtable->batches[0].shared->buckets =
 						dsa_allocate(hashtable->area,
-									 sizeof(dsa_pointer_atomic) * new_nbuckets);
-					buckets = (dsa_pointer_atomic *)
+									 sizeof(ParallelHashJoinBucket) * new_nbuckets);
+					buckets = (ParallelHashJoinBucket *)
 						dsa_get_address(hashtable->area,
 										hashtable->batches[0].shared->buckets);
 					for (i = 0; i < new_nbuckets; ++i)
-						dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+					{
+						dsa_pointer_atomic_init(&buckets[i].tuples,
+												InvalidDsaPointer);
+						pg_atomic_init_u32(&buckets[i].tags, 0);
+					}
 					pstate->nbuckets = new_nbuckets;
 				}
 				else
 				{
 					/* Recycle the existing bucket array. */
 					hashtable->batches[0].shared->buckets = old_batch0->buckets;
-					buckets = (dsa_pointer_atomic *)
+					buckets = (ParallelHashJoinBucket *)
 						dsa_get_address(hashtable->area, old_batch0->buckets);
 					for (i = 0; i < hashtable->nbuckets; ++i)
-						dsa_pointer_atomic_write(&buckets[i], InvalidDsaPointer);
+					{
+						dsa_pointer_atomic_write(&buckets[i].tuples,
+												 InvalidDsaPointer);
+						pg_atomic_write_u32(&buckets[i].tags, 0);
+					}
 				}
 
 				/* Move all chunks to the work queue for parallel processing. */
@@ -1451,11 +1529,11 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 	 * chunks)
 	 */
 	hashtable->buckets.unshared =
-		(HashJoinTuple *) repalloc(hashtable->buckets.unshared,
-								   hashtable->nbuckets * sizeof(HashJoinTuple));
+		(HashJoinBucketData *) repalloc(hashtable->buckets.unshared,
+								   hashtable->nbuckets * sizeof(HashJoinBucketData));
 
 	memset(hashtable->buckets.unshared, 0,
-		   hashtable->nbuckets * sizeof(HashJoinTuple));
+		   hashtable->nbuckets * sizeof(HashJoinBucketData));
 
 	/* scan through all tuples in all chunks to rebuild the hash table */
 	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
@@ -1473,8 +1551,8 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 									  &bucketno, &batchno);
 
 			/* add the tuple to the proper bucket */
-			hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-			hashtable->buckets.unshared[bucketno] = hashTuple;
+			ExecHashPushTuple(&hashtable->buckets.unshared[bucketno],
+							  hashTuple);
 
 			/* advance index past the tuple */
 			idx += MAXALIGN(HJTUPLE_OVERHEAD +
@@ -1509,20 +1587,24 @@ ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
 									 WAIT_EVENT_HASH_GROW_BUCKETS_ELECTING))
 			{
 				size_t		size;
-				dsa_pointer_atomic *buckets;
+				ParallelHashJoinBucket *buckets;
 
 				/* Double the size of the bucket array. */
 				pstate->nbuckets *= 2;
-				size = pstate->nbuckets * sizeof(dsa_pointer_atomic);
+				size = pstate->nbuckets * sizeof(ParallelHashJoinBucket);
 				hashtable->batches[0].shared->size += size / 2;
 				dsa_free(hashtable->area, hashtable->batches[0].shared->buckets);
 				hashtable->batches[0].shared->buckets =
 					dsa_allocate(hashtable->area, size);
-				buckets = (dsa_pointer_atomic *)
+				buckets = (ParallelHashJoinBucket *)
 					dsa_get_address(hashtable->area,
 									hashtable->batches[0].shared->buckets);
 				for (i = 0; i < pstate->nbuckets; ++i)
-					dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+				{
+					dsa_pointer_atomic_init(&buckets[i].tuples,
+											InvalidDsaPointer);
+					pg_atomic_init_u32(&buckets[i].tags, 0);
+				}
 
 				/* Put the chunk list onto the work queue. */
 				pstate->chunk_work_queue = hashtable->batches[0].shared->chunks;
@@ -1601,7 +1683,24 @@ ExecHashTableInsert(HashJoinTable hashtable,
 	/*
 	 * decide whether to put the tuple in the hash table or a temp file
 	 */
-	if (batchno == hashtable->curbatch)
+	if (batchno == hashtable->curbatch &&
+		!hashtable->growEnabled &&
+		hashtable->chunks != NULL &&
+		hashtable->spaceUsed + HJTUPLE_OVERHEAD + tuple->t_len +
+		hashtable->nbuckets_optimal * sizeof(HashJoinBucketData)
+		> hashtable->spaceAllowed)
+	{
+		/*
+		 * The current batch can't be split any further, and the hash table
+		 * is full.  Keep the tuple for a later stripe of this batch.  We
+		 * never do this to the first tuple of a stripe, so each stripe makes
+		 * progress even if a single tuple exceeds spaceAllowed.
+		 */
+		ExecHashJoinSaveTuple(tuple,
+							  hashvalue,
+							  &hashtable->stripeFile);
+	}
+	else if (batchno == hashtable->curbatch)
 	{
 		/*
 		 * put the tuple in hash table
@@ -1626,8 +1725,8 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
-		hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-		hashtable->buckets.unshared[bucketno] = hashTuple;
+		ExecHashPushTuple(&hashtable->buckets.unshared[bucketno],
+						  hashTuple);
 
 		/*
 		 * Increase the (optimal) number of buckets if we just exceeded the
@@ -1639,7 +1738,7 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		{
 			/* Guard against integer overflow and alloc size overflow */
 			if (hashtable->nbuckets_optimal <= INT_MAX / 2 &&
-				hashtable->nbuckets_optimal * 2 <= MaxAllocSize / sizeof(HashJoinTuple))
+				hashtable->nbuckets_optimal * 2 <= MaxAllocSize / sizeof(HashJoinBucketData))
 			{
 				hashtable->nbuckets_optimal *= 2;
 				hashtable->log2_nbuckets_optimal += 1;
@@ -1651,7 +1750,7 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		if (hashtable->spaceUsed > hashtable->spacePeak)
 			hashtable->spacePeak = hashtable->spaceUsed;
 		if (hashtable->spaceUsed +
-			hashtable->nbuckets_optimal * sizeof(HashJoinTuple)
+			hashtable->nbuckets_optimal * sizeof(HashJoinBucketData)
 			> hashtable->spaceAllowed)
 			ExecHashIncreaseNumBatches(hashtable);
 	}
@@ -1860,6 +1959,38 @@ ExecHashGetHashValue(HashJoinTable hashtable,
 	return true;
 }
 
+/*
+ * ExecHashEvalHashValue
+ *		Compute the hash value for a tuple, using an expression built by
+ *		ExecBuildHash32Expr()
+ *
+ * This is equivalent to ExecHashGetHashValue(), with the keep_nulls and
+ * hash function choices baked into the expression when it was built.  The
+ * expression returns NULL if the tuple has a NULL key that makes it unable
+ * to match, in which case we return false.
+ */
+bool
+ExecHashEvalHashValue(ExprState *hash_expr,
+					  ExprContext *econtext,
+					  uint32 *hashvalue)
+{
+	Datum		value;
+	bool		isnull;
+
+	/*
+	 * We reset the eval context each time to reclaim any memory leaked in the
+	 * hashkey expressions.
+	 */
+	ResetExprContext(econtext);
+
+	value = ExecEvalExprSwitchContext(hash_expr, econtext, &isnull);
+	if (isnull)
+		return false;			/* cannot match */
+
+	*hashvalue = DatumGetUInt32(value);
+	return true;
+}
+
 /*
  * ExecHashGetBucketAndBatch
  *		Determine the bucket number and batch number for a hash value
@@ -1905,6 +2036,61 @@ ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 	}
 }
 
+/*
+ * ExecHashPrefetchBucket
+ *		issue a prefetch for the bucket header a hash value maps to
+ *
+ * Probing a large hash table is dominated by cache misses on the bucket
+ * array and on the chain it points to.  Callers that know several hash
+ * values in advance can use this, and then ExecHashPrefetchChain, to
+ * overlap those misses with useful work.  Both functions are only hints;
+ * they neither change the table nor require the bucket to be non-empty.
+ */
+void
+ExecHashPrefetchBucket(HashJoinTable hashtable, uint32 hashvalue)
+{
+	int			bucketno = hashvalue & (hashtable->nbuckets - 1);
+
+	if (hashtable->parallel_state)
+		pg_prefetch_mem(&hashtable->buckets.shared[bucketno]);
+	else
+		pg_prefetch_mem(&hashtable->buckets.unshared[bucketno]);
+}
+
+/*
+ * ExecHashPrefetchChain
+ *		issue a prefetch for the first tuple in a hash value's bucket
+ *
+ * This dereferences the bucket header, so it should be called some time
+ * after ExecHashPrefetchBucket for the same hash value.  Nothing is fetched
+ * if the bucket's tags show that the hash value cannot be present.
+ */
+void
+ExecHashPrefetchChain(HashJoinTable hashtable, uint32 hashvalue)
+{
+	int			bucketno = hashvalue & (hashtable->nbuckets - 1);
+
+	if (hashtable->parallel_state)
+	{
+		ParallelHashJoinBucket *bucket = &hashtable->buckets.shared[bucketno];
+		dsa_pointer p;
+
+		if ((pg_atomic_read_u32(&bucket->tags) & HJ_BUCKET_TAG(hashvalue)) == 0)
+			return;
+		p = dsa_pointer_atomic_read(&bucket->tuples);
+		if (DsaPointerIsValid(p))
+			pg_prefetch_mem(dsa_get_address(hashtable->area, p));
+	}
+	else
+	{
+		HashJoinBucketData *bucket = &hashtable->buckets.unshared[bucketno];
+
+		if ((bucket->tags & HJ_BUCKET_TAG(hashvalue)) != 0 &&
+			bucket->tuples != NULL)
+			pg_prefetch_mem(bucket->tuples);
+	}
+}
+
 /*
  * ExecScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -1936,7 +2122,15 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	else if (hjstate->hj_CurSkewBucketNo != INVALID_SKEW_BUCKET_NO)
 		hashTuple = hashtable->skewBucket[hjstate->hj_CurSkewBucketNo]->tuples;
 	else
-		hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
+	{
+		HashJoinBucketData *bucket;
+
+		/* Don't walk the chain if its tags show that it can't match */
+		bucket = &hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
+		if ((bucket->tags & HJ_BUCKET_TAG(hashvalue)) == 0)
+			return false;
+		hashTuple = bucket->tuples;
+	}
 
 	while (hashTuple != NULL)
 	{
@@ -1992,8 +2186,16 @@ ExecParallelScanHashBucket(HashJoinState *hjstate,
 	if (hashTuple != NULL)
 		hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
 	else
+	{
+		ParallelHashJoinBucket *bucket;
+
+		/* Don't walk the chain if its tags show that it can't match */
+		bucket = &hashtable->buckets.shared[hjstate->hj_CurBucketNo];
+		if ((pg_atomic_read_u32(&bucket->tags) & HJ_BUCKET_TAG(hashvalue)) == 0)
+			return false;
 		hashTuple = ExecParallelHashFirstTuple(hashtable,
 											   hjstate->hj_CurBucketNo);
+	}
 
 	while (hashTuple != NULL)
 	{
@@ -2068,7 +2270,7 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 			hashTuple = hashTuple->next.unshared;
 		else if (hjstate->hj_CurBucketNo < hashtable->nbuckets)
 		{
-			hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
+			hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo].tuples;
 			hjstate->hj_CurBucketNo++;
 		}
 		else if (hjstate->hj_CurSkewBucketNo < hashtable->nSkewBuckets)
@@ -2117,6 +2319,133 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 	return false;
 }
 
+/*
+ * ExecParallelPrepHashTableForUnmatched
+ *		set up for a series of ExecParallelScanHashTableForUnmatched calls
+ *
+ * Returns true if this process should scan the current batch for unmatched
+ * inner tuples, in which case it is the only one left attached to the batch.
+ * Otherwise this process has detached from the batch and should move on.
+ */
+bool
+ExecParallelPrepHashTableForUnmatched(HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			curbatch = hashtable->curbatch;
+	ParallelHashJoinBatch *batch = hashtable->batches[curbatch].shared;
+
+	Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING);
+
+	/*
+	 * We can't wait on the batch barrier here, because it is in
+	 * PHJ_BATCH_PROBING phase and the processes attached to it may already
+	 * have emitted tuples.  Instead, hold a wait-free election: the last
+	 * process to finish probing goes on to scan for unmatched tuples, and all
+	 * others detach.  They can still help with other batches, if there are
+	 * any.
+	 */
+	if (!BarrierArriveAndDetachExceptLast(&batch->batch_barrier))
+	{
+		/* This process considers the batch to be done. */
+		hashtable->batches[curbatch].done = true;
+
+		/* Make sure any temporary files are closed. */
+		sts_end_parallel_scan(hashtable->batches[curbatch].inner_tuples);
+		sts_end_parallel_scan(hashtable->batches[curbatch].outer_tuples);
+
+		/*
+		 * Track the largest batch we've seen, which would normally happen in
+		 * ExecHashTableDetachBatch().
+		 */
+		hashtable->spacePeak =
+			Max(hashtable->spacePeak,
+				batch->size + sizeof(ParallelHashJoinBucket) * hashtable->nbuckets);
+		hashtable->curbatch = -1;
+		return false;
+	}
+
+	/* Now we are alone with this batch. */
+	Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_SCANNING);
+
+	/* Did some process give up early, leaving the match flags incomplete? */
+	if (batch->skip_unmatched)
+	{
+		hashtable->batches[curbatch].done = true;
+		ExecHashTableDetachBatch(hashtable);
+		return false;
+	}
+
+	/* Now prepare the process local state, just as for non-parallel join. */
+	ExecPrepHashTableForUnmatched(hjstate);
+
+	return true;
+}
+
+/*
+ * ExecParallelScanHashTableForUnmatched
+ *		scan a shared hash table for unmatched inner tuples
+ *
+ * Like ExecScanHashTableForUnmatched, for the process that won the election
+ * in ExecParallelPrepHashTableForUnmatched.
+ */
+bool
+ExecParallelScanHashTableForUnmatched(HashJoinState *hjstate,
+									  ExprContext *econtext)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
+
+	for (;;)
+	{
+		/*
+		 * hj_CurTuple is the address of the tuple last returned from the
+		 * current bucket, or NULL if it's time to start scanning a new
+		 * bucket.
+		 */
+		if (hashTuple != NULL)
+			hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		else if (hjstate->hj_CurBucketNo < hashtable->nbuckets)
+			hashTuple = ExecParallelHashFirstTuple(hashtable,
+												   hjstate->hj_CurBucketNo++);
+		else
+			break;				/* finished all buckets */
+
+		while (hashTuple != NULL)
+		{
+			if (!HeapTupleHeaderHasMatch(HJTUPLE_MINTUPLE(hashTuple)))
+			{
+				TupleTableSlot *inntuple;
+
+				/* insert hashtable's tuple into exec slot */
+				inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+												 hjstate->hj_HashTupleSlot,
+												 false);	/* do not pfree */
+				econtext->ecxt_innertuple = inntuple;
+
+				/*
+				 * Reset temp memory each time; although this function doesn't
+				 * do any qual eval, the caller will, so let's keep it
+				 * parallel to ExecScanHashBucket.
+				 */
+				ResetExprContext(econtext);
+
+				hjstate->hj_CurTuple = hashTuple;
+				return true;
+			}
+
+			hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		}
+
+		/* allow this loop to be cancellable */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/*
+	 * no more unmatched tuples
+	 */
+	return false;
+}
+
 /*
  * ExecHashTableReset
  *
@@ -2136,8 +2465,8 @@ ExecHashTableReset(HashJoinTable hashtable)
 	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
 
 	/* Reallocate and reinitialize the hash bucket headers. */
-	hashtable->buckets.unshared = (HashJoinTuple *)
-		palloc0(nbuckets * sizeof(HashJoinTuple));
+	hashtable->buckets.unshared = (HashJoinBucketData *)
+		palloc0(nbuckets * sizeof(HashJoinBucketData));
 
 	hashtable->spaceUsed = 0;
 
@@ -2160,7 +2489,7 @@ ExecHashTableResetMatchFlags(HashJoinTable hashtable)
 	/* Reset all flags in the main table ... */
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
-		for (tuple = hashtable->buckets.unshared[i]; tuple != NULL;
+		for (tuple = hashtable->buckets.unshared[i].tuples; tuple != NULL;
 			 tuple = tuple->next.unshared)
 			HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(tuple));
 	}
@@ -2496,8 +2825,8 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 			memcpy(copyTuple, hashTuple, tupleSize);
 			pfree(hashTuple);
 
-			copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-			hashtable->buckets.unshared[bucketno] = copyTuple;
+			ExecHashPushTuple(&hashtable->buckets.unshared[bucketno],
+							  copyTuple);
 
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
@@ -2839,7 +3168,7 @@ ExecParallelHashTupleAlloc(HashJoinTable hashtable, size_t size,
 				hashtable->nbuckets * NTUP_PER_BUCKET &&
 				hashtable->nbuckets < (INT_MAX / 2) &&
 				hashtable->nbuckets * 2 <=
-				MaxAllocSize / sizeof(dsa_pointer_atomic))
+				MaxAllocSize / sizeof(ParallelHashJoinBucket))
 			{
 				pstate->growth = PHJ_GROWTH_NEED_MORE_BUCKETS;
 				LWLockRelease(&pstate->lock);
@@ -3033,6 +3362,7 @@ ExecParallelHashEnsureBatchAccessors(HashJoinTable hashtable)
 
 		accessor->shared = shared;
 		accessor->preallocated = 0;
+		accessor->outer_eof = false;
 		accessor->done = false;
 		accessor->inner_tuples =
 			sts_attach(ParallelHashJoinBatchInner(shared),
@@ -3055,16 +3385,19 @@ void
 ExecParallelHashTableAlloc(HashJoinTable hashtable, int batchno)
 {
 	ParallelHashJoinBatch *batch = hashtable->batches[batchno].shared;
-	dsa_pointer_atomic *buckets;
+	ParallelHashJoinBucket *buckets;
 	int			nbuckets = hashtable->parallel_state->nbuckets;
 	int			i;
 
 	batch->buckets =
-		dsa_allocate(hashtable->area, sizeof(dsa_pointer_atomic) * nbuckets);
-	buckets = (dsa_pointer_atomic *)
+		dsa_allocate(hashtable->area, sizeof(ParallelHashJoinBucket) * nbuckets);
+	buckets = (ParallelHashJoinBucket *)
 		dsa_get_address(hashtable->area, batch->buckets);
 	for (i = 0; i < nbuckets; ++i)
-		dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+	{
+		dsa_pointer_atomic_init(&buckets[i].tuples, InvalidDsaPointer);
+		pg_atomic_init_u32(&buckets[i].tags, 0);
+	}
 }
 
 /*
@@ -3079,13 +3412,36 @@ ExecHashTableDetachBatch(HashJoinTable hashtable)
 	{
 		int			curbatch = hashtable->curbatch;
 		ParallelHashJoinBatch *batch = hashtable->batches[curbatch].shared;
+		bool		attached = true;
 
 		/* Make sure any temporary files are closed. */
 		sts_end_parallel_scan(hashtable->batches[curbatch].inner_tuples);
 		sts_end_parallel_scan(hashtable->batches[curbatch].outer_tuples);
 
-		/* Detach from the batch we were last working on. */
-		if (BarrierArriveAndDetach(&batch->batch_barrier))
+		/* After attaching we always get at least to PHJ_BATCH_PROBING. */
+		Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING ||
+			   BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_SCANNING);
+
+		/*
+		 * If we're leaving PHJ_BATCH_PROBING before reaching the end of our
+		 * share of the outer batch, the plan doesn't want any more tuples.
+		 * The match flags will never be complete, so nobody may scan for
+		 * unmatched inner tuples; it's as if this process had abandoned
+		 * those tuples along with the rest.  The flag is only read in
+		 * PHJ_BATCH_SCANNING, so it needs no locking.
+		 */
+		if (BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING &&
+			!hashtable->batches[curbatch].outer_eof)
+			batch->skip_unmatched = true;
+
+		/*
+		 * Detach from the batch we were last working on.  Even if we aren't
+		 * doing a right or full join, we step through PHJ_BATCH_SCANNING so
+		 * that memory is always freed in PHJ_BATCH_DONE, but without waiting.
+		 */
+		if (BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING)
+			attached = BarrierArriveAndDetachExceptLast(&batch->batch_barrier);
+		if (attached && BarrierArriveAndDetach(&batch->batch_barrier))
 		{
 			/*
 			 * Technically we shouldn't access the barrier because we're no
@@ -3118,7 +3474,7 @@ ExecHashTableDetachBatch(HashJoinTable hashtable)
 		 */
 		hashtable->spacePeak =
 			Max(hashtable->spacePeak,
-				batch->size + sizeof(dsa_pointer_atomic) * hashtable->nbuckets);
+				batch->size + sizeof(ParallelHashJoinBucket) * hashtable->nbuckets);
 
 		/* Remember that we are not attached to a batch. */
 		hashtable->curbatch = -1;
@@ -3148,6 +3504,9 @@ ExecHashTableDetach(HashJoinTable hashtable)
 			}
 		}
 
+		/* The shared bloom filter may be freed below. */
+		hashtable->bloomFilter = NULL;
+
 		/* If we're last to detach, clean up shared memory. */
 		if (BarrierDetach(&pstate->build_barrier))
 		{
@@ -3156,6 +3515,11 @@ ExecHashTableDetach(HashJoinTable hashtable)
 				dsa_free(hashtable->area, pstate->batches);
 				pstate->batches = InvalidDsaPointer;
 			}
+			if (DsaPointerIsValid(pstate->bloom_filter))
+			{
+				dsa_free(hashtable->area, pstate->bloom_filter);
+				pstate->bloom_filter = InvalidDsaPointer;
+			}
 		}
 
 		hashtable->parallel_state = NULL;
@@ -3172,7 +3536,7 @@ ExecParallelHashFirstTuple(HashJoinTable hashtable, int bucketno)
 	dsa_pointer p;
 
 	Assert(hashtable->parallel_state);
-	p = dsa_pointer_atomic_read(&hashtable->buckets.shared[bucketno]);
+	p = dsa_pointer_atomic_read(&hashtable->buckets.shared[bucketno].tuples);
 	tuple = (HashJoinTuple) dsa_get_address(hashtable->area, p);
 
 	return tuple;
@@ -3193,23 +3557,38 @@ ExecParallelHashNextTuple(HashJoinTable hashtable, HashJoinTuple tuple)
 }
 
 /*
- * Insert a tuple at the front of a chain of tuples in DSA memory atomically.
+ * Insert a tuple at the front of a chain of tuples in DSA memory atomically,
+ * and add its tag to the bucket.
  */
 static inline void
-ExecParallelHashPushTuple(dsa_pointer_atomic *head,
+ExecParallelHashPushTuple(ParallelHashJoinBucket *bucket,
 						  HashJoinTuple tuple,
 						  dsa_pointer tuple_shared)
 {
+	pg_atomic_fetch_or_u32(&bucket->tags, HJ_BUCKET_TAG(tuple->hashvalue));
+
 	for (;;)
 	{
-		tuple->next.shared = dsa_pointer_atomic_read(head);
-		if (dsa_pointer_atomic_compare_exchange(head,
+		tuple->next.shared = dsa_pointer_atomic_read(&bucket->tuples);
+		if (dsa_pointer_atomic_compare_exchange(&bucket->tuples,
 												&tuple->next.shared,
 												tuple_shared))
 			break;
 	}
 }
 
+/*
+ * Insert a tuple at the front of a bucket's chain in a private hash table,
+ * and add its tag to the bucket.
+ */
+static inline void
+ExecHashPushTuple(HashJoinBucketData *bucket, HashJoinTuple tuple)
+{
+	tuple->next.unshared = bucket->tuples;
+	bucket->tuples = tuple;
+	bucket->tags |= HJ_BUCKET_TAG(tuple->hashvalue);
+}
+
 /*
  * Prepare to work on a given batch.
  */
@@ -3219,7 +3598,7 @@ ExecParallelHashTableSetCurrentBatch(HashJoinTable hashtable, int batchno)
 	Assert(hashtable->batches[batchno].shared->buckets != InvalidDsaPointer);
 
 	hashtable->curbatch = batchno;
-	hashtable->buckets.shared = (dsa_pointer_atomic *)
+	hashtable->buckets.shared = (ParallelHashJoinBucket *)
 		dsa_get_address(hashtable->area,
 						hashtable->batches[batchno].shared->buckets);
 	hashtable->nbuckets = hashtable->parallel_state->nbuckets;
@@ -82,6 +82,7 @@
  *  PHJ_BATCH_ALLOCATING     -- one allocates buckets
  *  PHJ_BATCH_LOADING        -- all load the hash table from disk
  *  PHJ_BATCH_PROBING        -- all probe
+ *  PHJ_BATCH_SCANNING       -- one scans for unmatched inner tuples
  *  PHJ_BATCH_DONE           -- end
  *
  * Batch 0 is a special case, because it starts out in phase
@@ -101,6 +102,12 @@
  * tuples while in PHJ_BATCH_PROBING phase, but that's OK because we use
  * BarrierArriveAndDetach() to advance it to PHJ_BATCH_DONE without waiting.
  *
+ * For the same reason, right and full joins can't have every participant
+ * wait for probing to finish and then share out the unmatched inner scan.
+ * Instead, BarrierArriveAndDetachExceptLast() elects the last participant
+ * to finish probing, which alone enters PHJ_BATCH_SCANNING and emits the
+ * unmatched tuples, while the others go on to other batches, if any.
+ *
  *-------------------------------------------------------------------------
  */
 
@@ -114,6 +121,7 @@
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/sharedtuplestore.h"
 
@@ -133,6 +141,18 @@
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * Outer tuples are fetched in groups of HJ_PREFETCH_DEPTH, so that the cache
+ * misses of their hash table probes can overlap, but only once the bucket
+ * array is too big to be expected to stay in cache anyway.
+ */
+#define HJ_PREFETCH_DEPTH		16
+#define HJ_PREFETCH_MIN_BUCKETS	(1 << 16)
+
+static TupleTableSlot *ExecHashJoinNextOuterTuple(PlanState *outerNode,
+						   HashJoinState *hjstate,
+						   uint32 *hashvalue,
+						   bool parallel);
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 						  HashJoinState *hjstate,
 						  uint32 *hashvalue);
@@ -144,6 +164,10 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 						  uint32 *hashvalue,
 						  TupleTableSlot *tupleSlot);
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
+static void ExecHashJoinNewStripe(HashJoinState *hjstate);
+static void ExecHashJoinForgetSkew(HashJoinTable hashtable);
+static bool ExecHashJoinOuterIsMatched(HashJoinState *hjstate, int64 ordinal);
+static void ExecHashJoinSetOuterMatched(HashJoinState *hjstate, int64 ordinal);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *node);
 
@@ -346,22 +370,35 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				/*
 				 * We don't have an outer tuple, try to get the next one
 				 */
-				if (parallel)
-					outerTupleSlot =
-						ExecParallelHashJoinOuterGetTuple(outerNode, node,
-														  &hashvalue);
-				else
-					outerTupleSlot =
-						ExecHashJoinOuterGetTuple(outerNode, node, &hashvalue);
+				outerTupleSlot = ExecHashJoinNextOuterTuple(outerNode, node,
+															&hashvalue,
+															parallel);
 
 				if (TupIsNull(outerTupleSlot))
 				{
 					/* end of batch, or maybe whole join */
+					if (parallel)
+						hashtable->batches[hashtable->curbatch].outer_eof = true;
+
 					if (HJ_FILL_INNER(node))
 					{
 						/* set up to scan for unmatched inner tuples */
-						ExecPrepHashTableForUnmatched(node);
-						node->hj_JoinState = HJ_FILL_INNER_TUPLES;
+						if (parallel)
+						{
+							/*
+							 * Only one process handles each batch's unmatched
+							 * tuples in a parallel join; the others move on.
+							 */
+							if (ExecParallelPrepHashTableForUnmatched(node))
+								node->hj_JoinState = HJ_FILL_INNER_TUPLES;
+							else
+								node->hj_JoinState = HJ_NEED_NEW_BATCH;
+						}
+						else
+						{
+							ExecPrepHashTableForUnmatched(node);
+							node->hj_JoinState = HJ_FILL_INNER_TUPLES;
+						}
 					}
 					else
 						node->hj_JoinState = HJ_NEED_NEW_BATCH;
@@ -382,6 +419,17 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 																 hashvalue);
 				node->hj_CurTuple = NULL;
 
+				/*
+				 * If the batch is being processed in stripes and we are
+				 * reading the outer batch file, remember the tuple's position
+				 * in it.  This must count every tuple in the file, since the
+				 * file is read again for each stripe.
+				 */
+				node->hj_CurOuterOrdinal = -1;
+				if (hashtable->curstripe > 0 ||
+					(hashtable->curbatch > 0 && hashtable->stripeFile != NULL))
+					node->hj_CurOuterOrdinal = hashtable->outerOrdinal++;
+
 				/*
 				 * The tuple might not belong to the current batch (where
 				 * "current batch" includes the skew buckets if any).
@@ -390,8 +438,14 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					node->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
 				{
 					bool		shouldFree;
-					MinimalTuple mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
-																	  &shouldFree);
+					MinimalTuple mintuple;
+
+					/*
+					 * If this isn't the first stripe, the tuple has already
+					 * been moved to its batch file.
+					 */
+					if (hashtable->curstripe > 0)
+						continue;
 
 					/*
 					 * Need to postpone this outer tuple to a later batch.
@@ -399,6 +453,8 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					 */
 					Assert(parallel_state == NULL);
 					Assert(batchno > hashtable->curbatch);
+					mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
+														 &shouldFree);
 					ExecHashJoinSaveTuple(mintuple, hashvalue,
 										  &hashtable->outerBatchFile[batchno]);
 
@@ -409,6 +465,45 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					continue;
 				}
 
+				/*
+				 * If batch 0 didn't fit in memory, its outer tuples must be
+				 * kept for the later stripes, except those that match the
+				 * skew hash table, which is complete in the first pass.
+				 */
+				if (hashtable->curbatch == 0 &&
+					hashtable->curstripe == 0 &&
+					hashtable->stripeFile != NULL &&
+					node->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
+				{
+					bool		shouldFree;
+					MinimalTuple mintuple;
+
+					Assert(parallel_state == NULL);
+					mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
+														 &shouldFree);
+					ExecHashJoinSaveTuple(mintuple, hashvalue,
+										  &hashtable->outerBatchFile[0]);
+
+					if (shouldFree)
+						heap_free_minimal_tuple(mintuple);
+
+					node->hj_CurOuterOrdinal = hashtable->outerOrdinal++;
+				}
+
+				/*
+				 * If the tuple already found a match in an earlier stripe,
+				 * semi and anti joins are done with it, while other joins
+				 * must still look for more matches but not null-extend it.
+				 */
+				if (node->hj_CurOuterOrdinal >= 0 &&
+					ExecHashJoinOuterIsMatched(node, node->hj_CurOuterOrdinal))
+				{
+					if (node->js.jointype == JOIN_SEMI ||
+						node->js.jointype == JOIN_ANTI)
+						continue;
+					node->hj_MatchedOuter = true;
+				}
+
 				/* OK, let's scan the bucket for matches */
 				node->hj_JoinState = HJ_SCAN_BUCKET;
 
@@ -454,6 +549,9 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				{
 					node->hj_MatchedOuter = true;
 					HeapTupleHeaderSetMatch(HJTUPLE_MINTUPLE(node->hj_CurTuple));
+					if (node->hj_CurOuterOrdinal >= 0)
+						ExecHashJoinSetOuterMatched(node,
+													node->hj_CurOuterOrdinal);
 
 					/* In an antijoin, we never return a matched tuple */
 					if (node->js.jointype == JOIN_ANTI)
@@ -488,6 +586,14 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				 */
 				node->hj_JoinState = HJ_NEED_NEW_OUTER;
 
+				/*
+				 * In a batch processed in stripes, a later stripe might still
+				 * match, so wait until the last one.
+				 */
+				if (node->hj_CurOuterOrdinal >= 0 &&
+					hashtable->stripeFile != NULL)
+					break;
+
 				if (!node->hj_MatchedOuter &&
 					HJ_FILL_OUTER(node))
 				{
@@ -511,7 +617,9 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				 * so any unmatched inner tuples in the hashtable have to be
 				 * emitted before we continue to the next batch.
 				 */
-				if (!ExecScanHashTableForUnmatched(node, econtext))
+				if (parallel ?
+					!ExecParallelScanHashTableForUnmatched(node, econtext) :
+					!ExecScanHashTableForUnmatched(node, econtext))
 				{
 					/* no more unmatched tuples */
 					node->hj_JoinState = HJ_NEED_NEW_BATCH;
@@ -603,10 +711,17 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	List	   *rclauses;
 	List	   *rhclauses;
 	List	   *hoperators;
+	List	   *outer_exprs;
+	List	   *inner_exprs;
+	Oid		   *outer_hashfuncs;
+	Oid		   *inner_hashfuncs;
+	bool	   *outer_reject_nulls;
+	bool	   *inner_reject_nulls;
 	TupleDesc	outerDesc,
 				innerDesc;
 	ListCell   *l;
 	const TupleTableSlotOps *ops;
+	int			i;
 
 	/* check for unsupported flags */
 	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
@@ -661,6 +776,23 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_OuterTupleSlot = ExecInitExtraTupleSlot(estate, outerDesc,
 														ops);
 
+	/*
+	 * Outer tuples read ahead for prefetching have to be copied out of the
+	 * outer plan's slot, so give them slots of their own.  The join quals
+	 * and projection are compiled for the outer plan's slot type, so these
+	 * must be of that type too.
+	 */
+	hjstate->hj_PrefetchSlots = (TupleTableSlot **)
+		palloc(HJ_PREFETCH_DEPTH * sizeof(TupleTableSlot *));
+	for (i = 0; i < HJ_PREFETCH_DEPTH; i++)
+		hjstate->hj_PrefetchSlots[i] =
+			ExecInitExtraTupleSlot(estate, outerDesc, ops);
+	hjstate->hj_PrefetchHashValues = (uint32 *)
+		palloc(HJ_PREFETCH_DEPTH * sizeof(uint32));
+	hjstate->hj_PrefetchCount = 0;
+	hjstate->hj_PrefetchNext = 0;
+	hjstate->hj_PrefetchDone = false;
+
 	/*
 	 * detect whether we need only consider the first matching inner tuple
 	 */
@@ -727,6 +859,7 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_CurBucketNo = 0;
 	hjstate->hj_CurSkewBucketNo = INVALID_SKEW_BUCKET_NO;
 	hjstate->hj_CurTuple = NULL;
+	hjstate->hj_CurOuterOrdinal = -1;
 
 	/*
 	 * Deconstruct the hash clauses into outer and inner argument values, so
@@ -756,6 +889,55 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rhclauses;
 
+	/*
+	 * Build expressions computing the hash values of outer and inner tuples
+	 * in one go.  A NULL key makes a tuple unable to match if the operator is
+	 * strict, unless we need to emit unmatched tuples from that side; see
+	 * ExecHashGetHashValue().
+	 */
+	outer_hashfuncs = palloc(list_length(hoperators) * sizeof(Oid));
+	inner_hashfuncs = palloc(list_length(hoperators) * sizeof(Oid));
+	outer_reject_nulls = palloc(list_length(hoperators) * sizeof(bool));
+	inner_reject_nulls = palloc(list_length(hoperators) * sizeof(bool));
+	outer_exprs = NIL;
+	inner_exprs = NIL;
+	i = 0;
+	foreach(l, node->hashclauses)
+	{
+		OpExpr	   *hclause = lfirst_node(OpExpr, l);
+		bool		strict = op_strict(hclause->opno);
+
+		if (!get_op_hash_functions(hclause->opno,
+								   &outer_hashfuncs[i], &inner_hashfuncs[i]))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 hclause->opno);
+		outer_reject_nulls[i] = strict && !HJ_FILL_OUTER(hjstate);
+		inner_reject_nulls[i] = strict && !HJ_FILL_INNER(hjstate);
+		outer_exprs = lappend(outer_exprs, linitial(hclause->args));
+		inner_exprs = lappend(inner_exprs, lsecond(hclause->args));
+		i++;
+	}
+	hjstate->hj_OuterHash =
+		ExecBuildHash32Expr(outer_exprs, outer_hashfuncs, outer_reject_nulls,
+							0, (PlanState *) hjstate);
+	((HashState *) innerPlanState(hjstate))->hash_expr =
+		ExecBuildHash32Expr(inner_exprs, inner_hashfuncs, inner_reject_nulls,
+							0, innerPlanState(hjstate));
+
+	/*
+	 * If the planner pushed our outer hash keys down into the outer scan, ask
+	 * the Hash node for a bloom filter and tell the scan where to find it.
+	 */
+	if (IsA(outerPlanState(hjstate), SeqScanState) &&
+		((SeqScan *) outerNode)->bloomkeys != NIL)
+	{
+		SeqScanState *scanstate = (SeqScanState *) outerPlanState(hjstate);
+
+		Assert(list_length(scanstate->bloomkeys) == list_length(lclauses));
+		scanstate->bloomsource = hjstate;
+		((HashState *) innerPlanState(hjstate))->build_bloom = true;
+	}
+
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
@@ -800,6 +982,93 @@ ExecEndHashJoin(HashJoinState *node)
 	ExecEndNode(innerPlanState(node));
 }
 
+/*
+ * ExecHashJoinNextOuterTuple
+ *
+ *		get the next outer tuple to probe the hash table with
+ *
+ * This wraps ExecHashJoinOuterGetTuple and ExecParallelHashJoinOuterGetTuple.
+ * When the hash table is large, it reads a group of outer tuples ahead,
+ * prefetching first the bucket headers and then the first tuple of each
+ * candidate chain, before handing the tuples back one at a time.  By the
+ * time a tuple is probed, the memory it needs is hopefully in cache.
+ *
+ * Like the functions it wraps, returns a null slot at the end of the current
+ * batch; the group is always drained before that happens, so nothing is
+ * carried over into the next batch.
+ */
+static TupleTableSlot *
+ExecHashJoinNextOuterTuple(PlanState *outerNode,
+						   HashJoinState *hjstate,
+						   uint32 *hashvalue,
+						   bool parallel)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			i;
+
+	if (hjstate->hj_PrefetchNext >= hjstate->hj_PrefetchCount)
+	{
+		TupleTableSlot *slot;
+		int			count = 0;
+
+		hjstate->hj_PrefetchCount = 0;
+		hjstate->hj_PrefetchNext = 0;
+
+		/* Did the last group already run into the end of the batch? */
+		if (hjstate->hj_PrefetchDone)
+		{
+			hjstate->hj_PrefetchDone = false;
+			return NULL;
+		}
+
+		/* Not worth copying tuples around for a small table */
+		if (hashtable->nbuckets < HJ_PREFETCH_MIN_BUCKETS)
+		{
+			if (parallel)
+				return ExecParallelHashJoinOuterGetTuple(outerNode, hjstate,
+														 hashvalue);
+			return ExecHashJoinOuterGetTuple(outerNode, hjstate, hashvalue);
+		}
+
+		while (count < HJ_PREFETCH_DEPTH)
+		{
+			uint32		hv;
+
+			if (parallel)
+				slot = ExecParallelHashJoinOuterGetTuple(outerNode, hjstate,
+														 &hv);
+			else
+				slot = ExecHashJoinOuterGetTuple(outerNode, hjstate, &hv);
+			if (TupIsNull(slot))
+			{
+				hjstate->hj_PrefetchDone = true;
+				break;
+			}
+
+			ExecCopySlot(hjstate->hj_PrefetchSlots[count], slot);
+			hjstate->hj_PrefetchHashValues[count] = hv;
+			ExecHashPrefetchBucket(hashtable, hv);
+			count++;
+		}
+
+		if (count == 0)
+		{
+			hjstate->hj_PrefetchDone = false;
+			return NULL;
+		}
+
+		/* By now the bucket headers should have arrived */
+		for (i = 0; i < count; i++)
+			ExecHashPrefetchChain(hashtable, hjstate->hj_PrefetchHashValues[i]);
+
+		hjstate->hj_PrefetchCount = count;
+	}
+
+	i = hjstate->hj_PrefetchNext++;
+	*hashvalue = hjstate->hj_PrefetchHashValues[i];
+	return hjstate->hj_PrefetchSlots[i];
+}
+
 /*
  * ExecHashJoinOuterGetTuple
  *
@@ -821,7 +1090,8 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	int			curbatch = hashtable->curbatch;
 	TupleTableSlot *slot;
 
-	if (curbatch == 0)			/* if it is the first pass */
+	/* if it is the first pass */
+	if (curbatch == 0 && hashtable->curstripe == 0)
 	{
 		/*
 		 * Check to see if first outer tuple was already fetched by
@@ -841,11 +1111,8 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 			ExprContext *econtext = hjstate->js.ps.ps_ExprContext;
 
 			econtext->ecxt_outertuple = slot;
-			if (ExecHashGetHashValue(hashtable, econtext,
-									 hjstate->hj_OuterHashKeys,
-									 true,	/* outer tuple */
-									 HJ_FILL_OUTER(hjstate),
-									 hashvalue))
+			if (ExecHashEvalHashValue(hjstate->hj_OuterHash, econtext,
+									  hashvalue))
 			{
 				/* remember outer relation is not empty for possible rescan */
 				hjstate->hj_OuterNotEmpty = true;
@@ -909,11 +1176,8 @@ ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 			ExprContext *econtext = hjstate->js.ps.ps_ExprContext;
 
 			econtext->ecxt_outertuple = slot;
-			if (ExecHashGetHashValue(hashtable, econtext,
-									 hjstate->hj_OuterHashKeys,
-									 true,	/* outer tuple */
-									 HJ_FILL_OUTER(hjstate),
-									 hashvalue))
+			if (ExecHashEvalHashValue(hjstate->hj_OuterHash, econtext,
+									  hashvalue))
 				return slot;
 
 			/*
@@ -964,30 +1228,40 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	nbatch = hashtable->nbatch;
 	curbatch = hashtable->curbatch;
 
-	if (curbatch > 0)
+	/*
+	 * If the current batch has more stripes, move on to the next one.  That
+	 * isn't needed if there are no outer tuples to join them to, unless we
+	 * have to emit unmatched inner tuples.
+	 */
+	if (hashtable->stripeFile != NULL)
+	{
+		if (hashtable->outerBatchFile[curbatch] != NULL ||
+			HJ_FILL_INNER(hjstate))
+		{
+			ExecHashJoinNewStripe(hjstate);
+			return true;
+		}
+		BufFileClose(hashtable->stripeFile);
+		hashtable->stripeFile = NULL;
+	}
+	hashtable->curstripe = 0;
+	hashtable->outerOrdinal = 0;
+	if (hashtable->outerMatched != NULL)
+		memset(hashtable->outerMatched, 0, hashtable->outerMatchedSize);
+
+	if (hashtable->outerBatchFile != NULL)
 	{
 		/*
 		 * We no longer need the previous outer batch file; close it right
-		 * away to free disk space.
+		 * away to free disk space.  (Batch 0 has one only if it was processed
+		 * in stripes.)
 		 */
 		if (hashtable->outerBatchFile[curbatch])
 			BufFileClose(hashtable->outerBatchFile[curbatch]);
 		hashtable->outerBatchFile[curbatch] = NULL;
 	}
-	else						/* we just finished the first batch */
-	{
-		/*
-		 * Reset some of the skew optimization state variables, since we no
-		 * longer need to consider skew tuples after the first batch. The
-		 * memory context reset we are about to do will release the skew
-		 * hashtable itself.
-		 */
-		hashtable->skewEnabled = false;
-		hashtable->skewBucket = NULL;
-		hashtable->skewBucketNums = NULL;
-		hashtable->nSkewBuckets = 0;
-		hashtable->spaceUsedSkew = 0;
-	}
+	if (curbatch == 0)			/* we just finished the first batch */
+		ExecHashJoinForgetSkew(hashtable);
 
 	/*
 	 * We can always skip over any batches that are completely empty on both
@@ -1087,6 +1361,132 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	return true;
 }
 
+/*
+ * ExecHashJoinNewStripe
+ *		load the next stripe of the current batch
+ *
+ * The inner tuples that didn't fit into the previous stripe are loaded into
+ * the hash table, again sending any that don't fit to a new stripe file, and
+ * the outer batch file is rewound so that it can be joined to them.
+ */
+static void
+ExecHashJoinNewStripe(HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	BufFile    *innerFile = hashtable->stripeFile;
+	BufFile    *outerFile = hashtable->outerBatchFile[hashtable->curbatch];
+	TupleTableSlot *slot;
+	uint32		hashvalue;
+
+	Assert(innerFile != NULL);
+
+	/* The skew hash table is only needed in the first pass */
+	if (hashtable->curbatch == 0 && hashtable->curstripe == 0)
+		ExecHashJoinForgetSkew(hashtable);
+
+	hashtable->stripeFile = NULL;
+	hashtable->curstripe++;
+	hashtable->outerOrdinal = 0;
+
+	ExecHashTableReset(hashtable);
+
+	if (BufFileSeek(innerFile, 0, 0L, SEEK_SET))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind hash-join temporary file: %m")));
+
+	while ((slot = ExecHashJoinGetSavedTuple(hjstate,
+											 innerFile,
+											 &hashvalue,
+											 hjstate->hj_HashTupleSlot)))
+	{
+		/* all of these belong to the current batch, since nbatch is fixed */
+		ExecHashTableInsert(hashtable, slot, hashvalue);
+	}
+
+	BufFileClose(innerFile);
+
+	if (outerFile != NULL)
+	{
+		if (BufFileSeek(outerFile, 0, 0L, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-join temporary file: %m")));
+	}
+}
+
+/*
+ * ExecHashJoinForgetSkew
+ *		reset the skew optimization state at the end of the first pass
+ *
+ * We no longer need to consider skew tuples after that.  The memory context
+ * reset that the caller is about to do will release the skew hashtable
+ * itself.
+ */
+static void
+ExecHashJoinForgetSkew(HashJoinTable hashtable)
+{
+	hashtable->skewEnabled = false;
+	hashtable->skewBucket = NULL;
+	hashtable->skewBucketNums = NULL;
+	hashtable->nSkewBuckets = 0;
+	hashtable->spaceUsedSkew = 0;
+}
+
+/*
+ * ExecHashJoinOuterIsMatched
+ *		has the outer tuple at this position matched in an earlier stripe?
+ */
+static bool
+ExecHashJoinOuterIsMatched(HashJoinState *hjstate, int64 ordinal)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	Size		byteno = ordinal / BITS_PER_BYTE;
+
+	if (byteno >= hashtable->outerMatchedSize)
+		return false;
+	return (hashtable->outerMatched[byteno] & (1 << (ordinal % BITS_PER_BYTE))) != 0;
+}
+
+/*
+ * ExecHashJoinSetOuterMatched
+ *		remember that the outer tuple at this position has found a match
+ *
+ * This only matters for join types that treat matched and unmatched outer
+ * tuples differently.  The bitmap lives as long as the hash table, and
+ * is enlarged as needed.
+ */
+static void
+ExecHashJoinSetOuterMatched(HashJoinState *hjstate, int64 ordinal)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	Size		byteno = ordinal / BITS_PER_BYTE;
+
+	if (!HJ_FILL_OUTER(hjstate) && hjstate->js.jointype != JOIN_SEMI)
+		return;
+
+	if (byteno >= hashtable->outerMatchedSize)
+	{
+		Size		newsize = Max(hashtable->outerMatchedSize * 2, 1024);
+
+		while (byteno >= newsize)
+			newsize *= 2;
+		if (hashtable->outerMatched == NULL)
+			hashtable->outerMatched =
+				MemoryContextAllocZero(hashtable->hashCxt, newsize);
+		else
+		{
+			hashtable->outerMatched = repalloc(hashtable->outerMatched,
+											   newsize);
+			memset(hashtable->outerMatched + hashtable->outerMatchedSize, 0,
+				   newsize - hashtable->outerMatchedSize);
+		}
+		hashtable->outerMatchedSize = newsize;
+	}
+
+	hashtable->outerMatched[byteno] |= 1 << (ordinal % BITS_PER_BYTE);
+}
+
 /*
  * Choose a batch to work on, and attach to it.  Returns true if successful,
  * false if there are no more batches.
@@ -1186,9 +1586,25 @@ ExecParallelHashJoinNewBatch(HashJoinState *hjstate)
 					 * PHJ_BATCH_DONE can be reached.
 					 */
 					ExecParallelHashTableSetCurrentBatch(hashtable, batchno);
+					hashtable->batches[batchno].outer_eof = false;
 					sts_begin_parallel_scan(hashtable->batches[batchno].outer_tuples);
 					return true;
 
+				case PHJ_BATCH_SCANNING:
+
+					/*
+					 * Another process is already scanning this batch for
+					 * unmatched inner tuples.  We can't help with that, so
+					 * detach and go around again.  We have to use
+					 * ExecHashTableDetachBatch() because there's a small
+					 * chance we'll be the last to detach, and then we're
+					 * responsible for freeing memory.
+					 */
+					ExecParallelHashTableSetCurrentBatch(hashtable, batchno);
+					hashtable->batches[batchno].done = true;
+					ExecHashTableDetachBatch(hashtable);
+					break;
+
 				case PHJ_BATCH_DONE:
 
 					/*
@@ -1232,7 +1648,7 @@ ExecHashJoinSaveTuple(MinimalTuple tuple, uint32 hashvalue,
 	if (file == NULL)
 	{
 		/* First write to this batch file, so open it. */
-		file = BufFileCreateTemp(false);
+		file = BufFileCreateCompressTemp(false);
 		*fileptr = file;
 	}
 
@@ -1362,10 +1778,16 @@ ExecReScanHashJoin(HashJoinState *node)
 	node->hj_CurBucketNo = 0;
 	node->hj_CurSkewBucketNo = INVALID_SKEW_BUCKET_NO;
 	node->hj_CurTuple = NULL;
+	node->hj_CurOuterOrdinal = -1;
 
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
 
+	/* Forget any outer tuples read ahead for prefetching */
+	node->hj_PrefetchCount = 0;
+	node->hj_PrefetchNext = 0;
+	node->hj_PrefetchDone = false;
+
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
 	 * first ExecProcNode.
@@ -1408,11 +1830,8 @@ ExecParallelHashJoinPartitionOuter(HashJoinState *hjstate)
 		if (TupIsNull(slot))
 			break;
 		econtext->ecxt_outertuple = slot;
-		if (ExecHashGetHashValue(hashtable, econtext,
-								 hjstate->hj_OuterHashKeys,
-								 true,	/* outer tuple */
-								 HJ_FILL_OUTER(hjstate),
-								 &hashvalue))
+		if (ExecHashEvalHashValue(hjstate->hj_OuterHash, econtext,
+								  &hashvalue))
 		{
 			int			batchno;
 			int			bucketno;
@@ -1477,6 +1896,7 @@ ExecHashJoinInitializeDSM(HashJoinState *state, ParallelContext *pcxt)
 	pstate->nbuckets = 0;
 	pstate->growth = PHJ_GROWTH_OK;
 	pstate->chunk_work_queue = InvalidDsaPointer;
+	pstate->bloom_filter = InvalidDsaPointer;
 	pg_atomic_init_u32(&pstate->distributor, 0);
 	pstate->nparticipants = pcxt->nworkers + 1;
 	pstate->total_tuples = 0;
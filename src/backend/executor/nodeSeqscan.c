@@ -29,11 +29,20 @@
 
 #include "access/heapam.h"
 #include "access/relscan.h"
+#include "executor/execBatch.h"
+#include "executor/execScan.h"
 #include "executor/execdebug.h"
+#include "executor/hashjoin.h"
+#include "executor/nodeHash.h"
 #include "executor/nodeSeqscan.h"
+#include "optimizer/cost.h"
+#include "storage/bufmgr.h"
 #include "utils/rel.h"
 
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static bool SeqBatchQualPasses(SeqScanState *node, HeapScanDesc scandesc,
+				   HeapTuple tuple);
+static bool SeqBloomLacksTuple(SeqScanState *node, TupleTableSlot *slot);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -75,30 +84,147 @@ SeqNext(SeqScanState *node)
 		node->ss.ss_currentScanDesc = scandesc;
 	}
 
-	/*
-	 * get the next tuple from the table
-	 */
-	tuple = heap_getnext(scandesc, direction);
+	for (;;)
+	{
+		/*
+		 * get the next tuple from the table
+		 */
+		tuple = heap_getnext(scandesc, direction);
 
-	/*
-	 * save the tuple and the buffer returned to us by the access methods in
-	 * our scan tuple slot and return the slot.  Note: we pass 'false' because
-	 * tuples returned by heap_getnext() are pointers onto disk pages and were
-	 * not created with palloc() and so should not be pfree()'d.  Note also
-	 * that ExecStoreHeapTuple will increment the refcount of the buffer; the
-	 * refcount will not be dropped until the tuple table slot is cleared.
-	 */
-	if (tuple)
-		ExecStoreBufferHeapTuple(tuple, /* tuple to store */
-								 slot,	/* slot to store in */
-								 scandesc->rs_cbuf);	/* buffer associated
-														 * with this tuple */
-	else
-		ExecClearTuple(slot);
+		/*
+		 * Tuples failing the batch quals are discarded before we even store
+		 * them in the slot.
+		 */
+		if (tuple && node->batchqual != NULL &&
+			!SeqBatchQualPasses(node, scandesc, tuple))
+		{
+			InstrCountFiltered1(node, 1);
+			continue;
+		}
+
+		/*
+		 * save the tuple and the buffer returned to us by the access methods
+		 * in our scan tuple slot and return the slot.  Note: we pass 'false'
+		 * because tuples returned by heap_getnext() are pointers onto disk
+		 * pages and were not created with palloc() and so should not be
+		 * pfree()'d.  Note also that ExecStoreHeapTuple will increment the
+		 * refcount of the buffer; the refcount will not be dropped until the
+		 * tuple table slot is cleared.
+		 */
+		if (tuple)
+			ExecStoreBufferHeapTuple(tuple, /* tuple to store */
+									 slot,	/* slot to store in */
+									 scandesc->rs_cbuf);	/* buffer associated
+															 * with this tuple */
+		else
+		{
+			ExecClearTuple(slot);
+			break;
+		}
+
+		/*
+		 * If the parent hash join gave us a bloom filter, skip tuples that
+		 * certainly have no join partner without bothering the quals.
+		 */
+		if (node->bloomsource == NULL || !SeqBloomLacksTuple(node, slot))
+			break;
+
+		InstrCountFiltered2(node, 1);
+
+		/* Free anything hashing the rejected tuple left behind */
+		ResetExprContext(node->ss.ps.ps_ExprContext);
+	}
 
 	return slot;
 }
 
+/*
+ * SeqBatchQualPasses -- does the current tuple pass the batch quals?
+ *
+ * In page-at-a-time mode, the first time we see a tuple of a new page we
+ * evaluate the batch quals for all the visible tuples on it at once, and
+ * then just look up the result for each tuple as heap_getnext returns it.
+ * Since the page's visibility information doesn't change for a given
+ * snapshot, the results remain valid if we come back to the same page in
+ * the other direction.  Otherwise, the batch consists of just the one tuple.
+ */
+static bool
+SeqBatchQualPasses(SeqScanState *node, HeapScanDesc scandesc,
+				   HeapTuple tuple)
+{
+	BatchQual  *bq = node->batchqual;
+	uint16		sel[MaxHeapTuplesPerPage];
+	int			nsel;
+	int			i;
+
+	if (!scandesc->rs_pageatatime)
+	{
+		ExecBatchQualReset(bq);
+		ExecBatchQualAddTuple(bq, tuple);
+		return ExecBatchQualEval(bq, sel) == 1;
+	}
+
+	if (scandesc->rs_cblock != node->batchblock)
+	{
+		Page		page = BufferGetPage(scandesc->rs_cbuf);
+		HeapTupleData loctup;
+
+		loctup.t_tableOid = RelationGetRelid(scandesc->rs_rd);
+
+		ExecBatchQualReset(bq);
+		for (i = 0; i < scandesc->rs_ntuples; i++)
+		{
+			OffsetNumber lineoff = scandesc->rs_vistuples[i];
+			ItemId		lpp = PageGetItemId(page, lineoff);
+
+			loctup.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+			loctup.t_len = ItemIdGetLength(lpp);
+			ItemPointerSet(&loctup.t_self, scandesc->rs_cblock, lineoff);
+			ExecBatchQualAddTuple(bq, &loctup);
+		}
+
+		nsel = ExecBatchQualEval(bq, sel);
+		memset(node->batchpass, 0, scandesc->rs_ntuples * sizeof(bool));
+		for (i = 0; i < nsel; i++)
+			node->batchpass[sel[i]] = true;
+
+		node->batchblock = scandesc->rs_cblock;
+	}
+
+	Assert(scandesc->rs_cindex >= 0 && scandesc->rs_cindex < bq->ntuples);
+
+	return node->batchpass[scandesc->rs_cindex];
+}
+
+/*
+ * SeqBloomLacksTuple -- is the scan tuple certainly absent from the bloom
+ * filter built by the parent hash join?
+ *
+ * We hash the tuple exactly as ExecHashJoin would hash it as an outer tuple.
+ * A tuple with a NULL key can't match either, since the join types we're used
+ * for never emit unmatched outer tuples.
+ */
+static bool
+SeqBloomLacksTuple(SeqScanState *node, TupleTableSlot *slot)
+{
+	HashJoinTable hashtable = node->bloomsource->hj_HashTable;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	uint32		hashvalue;
+
+	/* Filter isn't available until the hash table has been built */
+	if (hashtable == NULL || hashtable->bloomFilter == NULL)
+		return false;
+
+	econtext->ecxt_scantuple = slot;
+	if (!ExecHashGetHashValue(hashtable, econtext, node->bloomkeys,
+							  true, false, &hashvalue))
+		return true;
+
+	return bloom_lacks_element(hashtable->bloomFilter,
+							   (unsigned char *) &hashvalue,
+							   sizeof(hashvalue));
+}
+
 /*
  * SeqRecheck -- access method routine to recheck a tuple in EvalPlanQual
  */
@@ -116,8 +242,9 @@ SeqRecheck(SeqScanState *node, TupleTableSlot *slot)
  *		ExecSeqScan(node)
  *
  *		Scans the relation sequentially and returns the next qualifying
- *		tuple.
- *		We call the ExecScan() routine and pass it the appropriate
+ *		tuple.  This variant is used when there is neither a qual nor a
+ *		projection to apply.
+ *		We call the ExecScanExtended() routine and pass it the appropriate
  *		access method functions.
  * ----------------------------------------------------------------
  */
@@ -126,9 +253,68 @@ ExecSeqScan(PlanState *pstate)
 {
 	SeqScanState *node = castNode(SeqScanState, pstate);
 
-	return ExecScan(&node->ss,
-					(ExecScanAccessMtd) SeqNext,
-					(ExecScanRecheckMtd) SeqRecheck);
+	Assert(pstate->qual == NULL);
+	Assert(pstate->ps_ProjInfo == NULL);
+
+	return ExecScanExtended(&node->ss,
+							(ExecScanAccessMtd) SeqNext,
+							(ExecScanRecheckMtd) SeqRecheck,
+							NULL,
+							NULL);
+}
+
+/*
+ * Variant of ExecSeqScan() for when there's a qual, but no projection.
+ */
+static TupleTableSlot *
+ExecSeqScanWithQual(PlanState *pstate)
+{
+	SeqScanState *node = castNode(SeqScanState, pstate);
+
+	Assert(pstate->qual != NULL);
+	Assert(pstate->ps_ProjInfo == NULL);
+
+	return ExecScanExtended(&node->ss,
+							(ExecScanAccessMtd) SeqNext,
+							(ExecScanRecheckMtd) SeqRecheck,
+							pstate->qual,
+							NULL);
+}
+
+/*
+ * Variant of ExecSeqScan() for when there's a projection, but no qual.
+ */
+static TupleTableSlot *
+ExecSeqScanWithProject(PlanState *pstate)
+{
+	SeqScanState *node = castNode(SeqScanState, pstate);
+
+	Assert(pstate->qual == NULL);
+	Assert(pstate->ps_ProjInfo != NULL);
+
+	return ExecScanExtended(&node->ss,
+							(ExecScanAccessMtd) SeqNext,
+							(ExecScanRecheckMtd) SeqRecheck,
+							NULL,
+							pstate->ps_ProjInfo);
+}
+
+/*
+ * Variant of ExecSeqScan() for when there's both a qual and a projection.
+ */
+static TupleTableSlot *
+ExecSeqScanWithQualProject(PlanState *pstate)
+{
+	SeqScanState *node = castNode(SeqScanState, pstate);
+
+	Assert(pstate->qual != NULL);
+	Assert(pstate->ps_ProjInfo != NULL);
+
+	return ExecScanExtended(&node->ss,
+							(ExecScanAccessMtd) SeqNext,
+							(ExecScanRecheckMtd) SeqRecheck,
+							pstate->qual,
+							pstate->ps_ProjInfo);
 }
 
 
@@ -140,6 +326,7 @@ SeqScanState *
 ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 {
 	SeqScanState *scanstate;
+	List	   *qual;
 
 	/*
 	 * Once upon a time it was possible to have an outerPlan of a SeqScan, but
@@ -168,7 +355,7 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	 */
 	scanstate->ss.ss_currentRelation =
 		ExecOpenScanRelation(estate,
-							 node->scanrelid,
+							 node->scan.scanrelid,
 							 eflags);
 
 	/* and create slot with the appropriate rowtype */
@@ -184,9 +371,48 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 
 	/*
 	 * initialize child expressions
+	 *
+	 * If enabled, simple quals are evaluated in batches by SeqNext, and only
+	 * the rest are left for ExecScan.  Not in EvalPlanQual rechecks though,
+	 * since those don't go through SeqNext.
 	 */
-	scanstate->ss.ps.qual =
-		ExecInitQual(node->plan.qual, (PlanState *) scanstate);
+	qual = node->scan.plan.qual;
+	scanstate->batchqual = NULL;
+	if (enable_batch_qual && estate->es_epqTuple == NULL)
+		scanstate->batchqual = ExecInitBatchQual(node->scan.plan.qual,
+												 &scanstate->ss,
+												 MaxHeapTuplesPerPage,
+												 &qual);
+	if (scanstate->batchqual != NULL)
+		scanstate->batchpass = (bool *)
+			palloc(MaxHeapTuplesPerPage * sizeof(bool));
+	scanstate->batchblock = InvalidBlockNumber;
+
+	scanstate->ss.ps.qual = ExecInitQual(qual, (PlanState *) scanstate);
+	scanstate->bloomkeys =
+		ExecInitExprList(node->bloomkeys, (PlanState *) scanstate);
+
+	/* parent HashJoin sets bloomsource, if it wants us to use its filter */
+	scanstate->bloomsource = NULL;
+
+	/*
+	 * When there's no qual and/or no projection, use an ExecProcNode
+	 * variant that doesn't check for them for every tuple.
+	 */
+	if (scanstate->ss.ps.qual == NULL)
+	{
+		if (scanstate->ss.ps.ps_ProjInfo == NULL)
+			scanstate->ss.ps.ExecProcNode = ExecSeqScan;
+		else
+			scanstate->ss.ps.ExecProcNode = ExecSeqScanWithProject;
+	}
+	else
+	{
+		if (scanstate->ss.ps.ps_ProjInfo == NULL)
+			scanstate->ss.ps.ExecProcNode = ExecSeqScanWithQual;
+		else
+			scanstate->ss.ps.ExecProcNode = ExecSeqScanWithQualProject;
+	}
 
 	return scanstate;
 }
@@ -248,6 +474,8 @@ ExecReScanSeqScan(SeqScanState *node)
 		heap_rescan(scan,		/* scan desc */
 					NULL);		/* new scan keys */
 
+	node->batchblock = InvalidBlockNumber;
+
 	ExecScanReScan((ScanState *) node);
 }
 
@@ -18,10 +18,83 @@
 #include "access/parallel.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSort.h"
+#include "lib/binaryheap.h"
 #include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/barrier.h"
+#include "storage/buffile.h"
+#include "storage/condition_variable.h"
+#include "storage/sharedfileset.h"
+#include "storage/spin.h"
+#include "utils/sortsupport.h"
 #include "utils/tuplesort.h"
 
 
+/*
+ * Shared state of a Parallel Sort.
+ *
+ * Each worker sorts its share of the input as usual, and then writes the
+ * result as a run to a shared temporary file, noting where each range of the
+ * leading sort key starts in it.  The range bounds were chosen by the planner
+ * from the column statistics.  Once all the runs are written, each worker
+ * merges a slice of consecutive ranges from all of the runs, so that every
+ * worker returns a contiguous part of the final output.  Gather Merge then
+ * only has to return the workers' outputs one after another; see
+ * ExecSortGetRangeWorkers.
+ *
+ * Runs are numbered in the order the workers finish sorting, and whoever
+ * wrote run i also merges slice i.  A worker that shows up only after all
+ * runs are written has no input left to sort, and returns nothing.
+ */
+typedef struct ParallelSortRange
+{
+	int			fileno;			/* position of the range's first tuple */
+	off_t		offset;
+	int64		ntuples;		/* number of tuples in the range */
+} ParallelSortRange;
+
+typedef struct ParallelSortState
+{
+	Barrier		barrier;		/* for waiting until all runs are written */
+	ConditionVariable cv;		/* signaled when runs_done is set */
+	slock_t		mutex;			/* protects runs_done */
+	bool		runs_done;		/* have all runs been written? */
+	pg_atomic_uint32 nruns;		/* number of runs started so far */
+	int			maxruns;		/* number of workers planned */
+	int			nranges;		/* number of key ranges */
+	Size		instrument_offset;	/* offset of SharedSortInfo, or 0 */
+	SharedFileSet fileset;		/* space for the runs' files */
+	int			run_worker[FLEXIBLE_ARRAY_MEMBER];	/* who wrote each run */
+	/* followed by ParallelSortRange[maxruns][nranges] */
+} ParallelSortState;
+
+#define ParallelSortRangesOffset(maxruns) \
+	MAXALIGN(offsetof(ParallelSortState, run_worker) + (maxruns) * sizeof(int))
+#define ParallelSortRunRanges(pstate, run) \
+	((ParallelSortRange *) ((char *) (pstate) + \
+							ParallelSortRangesOffset((pstate)->maxruns)) + \
+	 (run) * (pstate)->nranges)
+
+/* A run being merged by this worker, in private memory */
+typedef struct SortMergeRun
+{
+	BufFile    *file;			/* the run, positioned after current tuple */
+	int64		remaining;		/* tuples left in our slice of the run */
+	TupleTableSlot *slot;		/* current tuple from the run */
+} SortMergeRun;
+
+static Size sort_shared_size(SortState *node, int nworkers,
+				 bool parallel_aware, Size *instrument_offset);
+static void parallel_sort_initialize(ParallelSortState *pstate);
+static void parallel_sort_write_run(SortState *node);
+static void parallel_sort_begin_merge(SortState *node, int run);
+static bool parallel_sort_read_tuple(SortMergeRun *mrun);
+static TupleTableSlot *parallel_sort_merge_next(SortState *node);
+static int32 parallel_sort_heap_compare(Datum a, Datum b, void *arg);
+static int	parallel_sort_bound_compare(const void *a, const void *b,
+							void *arg);
+
+
 /* ----------------------------------------------------------------
  *		ExecSort
  *
@@ -71,6 +144,20 @@ ExecSort(PlanState *pstate)
 		SO1_printf("ExecSort: %s\n",
 				   "sorting subplan");
 
+		/*
+		 * A Parallel Sort worker attaches to the barrier before reading any
+		 * input, so that the runs can't be considered complete while it
+		 * might still have tuples to contribute.  If they already are, the
+		 * other workers have consumed all of the input.
+		 */
+		if (node->am_worker && node->pstate != NULL &&
+			BarrierAttach(&node->pstate->barrier) > 0)
+		{
+			BarrierDetach(&node->pstate->barrier);
+			node->sort_Done = true;
+			return ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+		}
+
 		/*
 		 * Want to scan subplan in the forward direction while creating the
 		 * sorted data.
@@ -137,9 +224,16 @@ ExecSort(PlanState *pstate)
 			si = &node->shared_info->sinstrument[ParallelWorkerNumber];
 			tuplesort_get_stats(tuplesortstate, si);
 		}
+
+		/* In a Parallel Sort, write out our run and start merging */
+		if (node->am_worker && node->pstate != NULL)
+			parallel_sort_write_run(node);
 		SO1_printf("ExecSort: %s\n", "sorting done");
 	}
 
+	if (node->am_worker && node->pstate != NULL)
+		return parallel_sort_merge_next(node);
+
 	SO1_printf("ExecSort: %s\n",
 			   "retrieving tuple from tuplesort");
 
@@ -220,6 +314,42 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	ExecInitResultTupleSlotTL(&sortstate->ss.ps, &TTSOpsMinimalTuple);
 	sortstate->ss.ps.ps_ProjInfo = NULL;
 
+	/*
+	 * A Parallel Sort needs to compare tuples by all the sort keys to merge
+	 * the workers' runs, and by the leading key to divide them into ranges.
+	 * The range bounds are sorted here, rather than trusting the order the
+	 * planner found them in.
+	 */
+	if (node->plan.parallel_aware)
+	{
+		ListCell   *lc;
+		int			i;
+
+		sortstate->sortkeys = palloc0(sizeof(SortSupportData) * node->numCols);
+		for (i = 0; i < node->numCols; i++)
+		{
+			SortSupport sortKey = sortstate->sortkeys + i;
+
+			sortKey->ssup_cxt = CurrentMemoryContext;
+			sortKey->ssup_collation = node->collations[i];
+			sortKey->ssup_nulls_first = node->nullsFirst[i];
+			sortKey->ssup_attno = node->sortColIdx[i];
+			sortKey->abbreviate = false;
+
+			PrepareSortSupportFromOrderingOp(node->sortOperators[i], sortKey);
+		}
+
+		sortstate->nrange_bounds = list_length(node->rangeBounds);
+		sortstate->range_bounds =
+			palloc(sizeof(Datum) * Max(sortstate->nrange_bounds, 1));
+		i = 0;
+		foreach(lc, node->rangeBounds)
+			sortstate->range_bounds[i++] = castNode(Const, lfirst(lc))->constvalue;
+		qsort_arg(sortstate->range_bounds, sortstate->nrange_bounds,
+				  sizeof(Datum), parallel_sort_bound_compare,
+				  sortstate->sortkeys);
+	}
+
 	SO1_printf("ExecInitSort: %s\n",
 			   "sort node initialized");
 
@@ -233,6 +363,8 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 void
 ExecEndSort(SortState *node)
 {
+	int			i;
+
 	SO1_printf("ExecEndSort: %s\n",
 			   "shutting down sort node");
 
@@ -250,6 +382,14 @@ ExecEndSort(SortState *node)
 		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
 	node->tuplesortstate = NULL;
 
+	/* likewise the runs a Parallel Sort worker was merging */
+	for (i = 0; i < node->nmerge_runs; i++)
+	{
+		BufFileClose(node->merge_runs[i].file);
+		ExecDropSingleTupleTableSlot(node->merge_runs[i].slot);
+	}
+	node->nmerge_runs = 0;
+
 	/*
 	 * shut down the subplan
 	 */
@@ -341,28 +481,372 @@ ExecReScanSort(SortState *node)
 		tuplesort_rescan((Tuplesortstate *) node->tuplesortstate);
 }
 
+/* ----------------------------------------------------------------
+ *						Parallel Sort
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Set up the parts of a Parallel Sort's shared state that are reset for
+ * each scan.
+ */
+static void
+parallel_sort_initialize(ParallelSortState *pstate)
+{
+	BarrierInit(&pstate->barrier, 0);
+	pg_atomic_init_u32(&pstate->nruns, 0);
+	pstate->runs_done = false;
+}
+
+/*
+ * Write the sorted tuples of a Parallel Sort worker as a run to a shared
+ * file, wait for the other workers to do the same, and then set up to merge
+ * our slice of the key ranges from all of the runs.
+ */
+static void
+parallel_sort_write_run(SortState *node)
+{
+	ParallelSortState *pstate = node->pstate;
+	Tuplesortstate *tuplesortstate = (Tuplesortstate *) node->tuplesortstate;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	AttrNumber	keycol = node->sortkeys[0].ssup_attno;
+	ParallelSortRange *ranges;
+	BufFile    *file;
+	char		name[MAXPGPATH];
+	int			run;
+	int			range = 0;
+
+	run = pg_atomic_fetch_add_u32(&pstate->nruns, 1);
+	Assert(run < pstate->maxruns);
+	pstate->run_worker[run] = ParallelWorkerNumber;
+	ranges = ParallelSortRunRanges(pstate, run);
+	memset(ranges, 0, sizeof(ParallelSortRange) * pstate->nranges);
+
+	snprintf(name, sizeof(name), "sortrun%d", run);
+	file = BufFileCreateShared(&pstate->fileset, name);
+
+	while (tuplesort_gettupleslot(tuplesortstate, true, false, slot, NULL))
+	{
+		MinimalTuple tuple;
+		bool		shouldFree;
+
+		/* Start the next range(s) once the leading key reaches their bounds */
+		if (range < node->nrange_bounds)
+		{
+			Datum		key;
+			bool		isnull;
+
+			key = slot_getattr(slot, keycol, &isnull);
+			while (range < node->nrange_bounds &&
+				   ApplySortComparator(key, isnull,
+									   node->range_bounds[range], false,
+									   &node->sortkeys[0]) >= 0)
+			{
+				range++;
+				BufFileTell(file, &ranges[range].fileno,
+							&ranges[range].offset);
+			}
+		}
+
+		tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+		if (BufFileWrite(file, tuple, tuple->t_len) != tuple->t_len)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to sort temporary file: %m")));
+		ranges[range].ntuples++;
+		if (shouldFree)
+			pfree(tuple);
+	}
+
+	/* Any remaining ranges are empty, and start at the end of the run */
+	while (++range < pstate->nranges)
+		BufFileTell(file, &ranges[range].fileno, &ranges[range].offset);
+
+	BufFileClose(file);
+	ExecClearTuple(slot);
+	tuplesort_end(tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	/* Wait for the other runs; one of us then lets the leader know */
+	if (BarrierArriveAndWait(&pstate->barrier, WAIT_EVENT_PARALLEL_SORT_RUNS))
+	{
+		SpinLockAcquire(&pstate->mutex);
+		pstate->runs_done = true;
+		SpinLockRelease(&pstate->mutex);
+		ConditionVariableBroadcast(&pstate->cv);
+	}
+	BarrierDetach(&pstate->barrier);
+
+	parallel_sort_begin_merge(node, run);
+}
+
+/*
+ * Open the part of each run that falls into our slice of the key ranges, and
+ * build a heap to merge them.
+ */
+static void
+parallel_sort_begin_merge(SortState *node, int run)
+{
+	ParallelSortState *pstate = node->pstate;
+	TupleDesc	tupDesc = ExecGetResultType(&node->ss.ps);
+	int			nruns = pg_atomic_read_u32(&pstate->nruns);
+	int			first = run * pstate->nranges / nruns;
+	int			last = (run + 1) * pstate->nranges / nruns;
+	int			i;
+
+	node->merge_runs = palloc(sizeof(SortMergeRun) * nruns);
+	node->nmerge_runs = 0;
+	node->merge_heap = binaryheap_allocate(nruns, parallel_sort_heap_compare,
+										   node);
+	node->merge_started = false;
+
+	for (i = 0; i < nruns; i++)
+	{
+		ParallelSortRange *ranges = ParallelSortRunRanges(pstate, i);
+		SortMergeRun *mrun = &node->merge_runs[node->nmerge_runs];
+		char		name[MAXPGPATH];
+		int64		ntuples = 0;
+		int			r;
+
+		for (r = first; r < last; r++)
+			ntuples += ranges[r].ntuples;
+		if (ntuples == 0)
+			continue;
+
+		snprintf(name, sizeof(name), "sortrun%d", i);
+		mrun->file = BufFileOpenShared(&pstate->fileset, name);
+		if (BufFileSeek(mrun->file, ranges[first].fileno,
+						ranges[first].offset, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in sort temporary file: %m")));
+		mrun->remaining = ntuples;
+		mrun->slot = MakeSingleTupleTableSlot(tupDesc, &TTSOpsMinimalTuple);
+		node->nmerge_runs++;
+
+		(void) parallel_sort_read_tuple(mrun);
+		binaryheap_add_unordered(node->merge_heap,
+								 Int32GetDatum(node->nmerge_runs - 1));
+	}
+
+	binaryheap_build(node->merge_heap);
+}
+
+/*
+ * Read the next tuple of our slice of a run into its slot.  Returns false,
+ * leaving the slot empty, if there are no more.
+ */
+static bool
+parallel_sort_read_tuple(SortMergeRun *mrun)
+{
+	MinimalTuple tuple;
+	uint32		t_len;
+	size_t		nread;
+
+	if (mrun->remaining == 0)
+	{
+		ExecClearTuple(mrun->slot);
+		return false;
+	}
+
+	nread = BufFileRead(mrun->file, &t_len, sizeof(t_len));
+	if (nread != sizeof(t_len))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from sort temporary file: %m")));
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+	nread = BufFileRead(mrun->file, (char *) tuple + sizeof(uint32),
+						t_len - sizeof(uint32));
+	if (nread != t_len - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from sort temporary file: %m")));
+
+	ExecStoreMinimalTuple(tuple, mrun->slot, true);
+	mrun->remaining--;
+
+	return true;
+}
+
+/*
+ * Return the next tuple of a Parallel Sort worker's merged slice.
+ */
+static TupleTableSlot *
+parallel_sort_merge_next(SortState *node)
+{
+	binaryheap *heap = node->merge_heap;
+	int			i;
+
+	/* a worker that arrived too late to take part has nothing to return */
+	if (heap == NULL)
+		return ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+
+	/* advance the run that supplied the previous tuple */
+	if (node->merge_started && !binaryheap_empty(heap))
+	{
+		i = DatumGetInt32(binaryheap_first(heap));
+		if (parallel_sort_read_tuple(&node->merge_runs[i]))
+			binaryheap_replace_first(heap, Int32GetDatum(i));
+		else
+			(void) binaryheap_remove_first(heap);
+	}
+	node->merge_started = true;
+
+	if (binaryheap_empty(heap))
+		return ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+
+	i = DatumGetInt32(binaryheap_first(heap));
+	return node->merge_runs[i].slot;
+}
+
+/*
+ * Compare the current tuples of two runs, for the merge heap.  The result
+ * is inverted, since binaryheap keeps the largest element on top.
+ */
+static int32
+parallel_sort_heap_compare(Datum a, Datum b, void *arg)
+{
+	SortState  *node = (SortState *) arg;
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	TupleTableSlot *s1 = node->merge_runs[DatumGetInt32(a)].slot;
+	TupleTableSlot *s2 = node->merge_runs[DatumGetInt32(b)].slot;
+	int			nkey;
+
+	for (nkey = 0; nkey < plannode->numCols; nkey++)
+	{
+		SortSupport sortKey = node->sortkeys + nkey;
+		AttrNumber	attno = sortKey->ssup_attno;
+		Datum		datum1,
+					datum2;
+		bool		isNull1,
+					isNull2;
+		int			compare;
+
+		datum1 = slot_getattr(s1, attno, &isNull1);
+		datum2 = slot_getattr(s2, attno, &isNull2);
+
+		compare = ApplySortComparator(datum1, isNull1,
+									  datum2, isNull2,
+									  sortKey);
+		if (compare != 0)
+		{
+			INVERT_COMPARE_RESULT(compare);
+			return compare;
+		}
+	}
+	return 0;
+}
+
+/*
+ * qsort_arg comparator for range bounds, by the leading sort key.
+ */
+static int
+parallel_sort_bound_compare(const void *a, const void *b, void *arg)
+{
+	return ApplySortComparator(*(const Datum *) a, false,
+							   *(const Datum *) b, false,
+							   (SortSupport) arg);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSortGetRangeWorkers
+ *
+ *		For the leader of a Parallel Sort: wait until the workers have
+ *		written their runs, then fill in "workers" with the
+ *		ParallelWorkerNumber of each worker that returns part of the
+ *		output, in the order of their key ranges.  Returns the number of
+ *		such workers.
+ * ----------------------------------------------------------------
+ */
+int
+ExecSortGetRangeWorkers(SortState *node, int *workers)
+{
+	ParallelSortState *pstate = node->pstate;
+	int			nruns;
+	int			i;
+
+	Assert(pstate != NULL && !node->am_worker);
+
+	ConditionVariablePrepareToSleep(&pstate->cv);
+	for (;;)
+	{
+		bool		runs_done;
+
+		SpinLockAcquire(&pstate->mutex);
+		runs_done = pstate->runs_done;
+		SpinLockRelease(&pstate->mutex);
+
+		if (runs_done)
+			break;
+		ConditionVariableSleep(&pstate->cv, WAIT_EVENT_PARALLEL_SORT_RUNS);
+	}
+	ConditionVariableCancelSleep();
+
+	nruns = pg_atomic_read_u32(&pstate->nruns);
+	for (i = 0; i < nruns; i++)
+		workers[i] = pstate->run_worker[i];
+
+	return nruns;
+}
+
 /* ----------------------------------------------------------------
  *						Parallel Query Support
  * ----------------------------------------------------------------
  */
 
+/*
+ * Compute the size of a Sort node's shared state: the ParallelSortState of a
+ * Parallel Sort, if wanted, followed by the SharedSortInfo when
+ * instrumenting.  The offset of the latter is returned in *instrument_offset.
+ */
+static Size
+sort_shared_size(SortState *node, int nworkers, bool parallel_aware,
+				 Size *instrument_offset)
+{
+	Size		size = 0;
+
+	if (parallel_aware)
+	{
+		size = mul_size(mul_size(nworkers, node->nrange_bounds + 1),
+						sizeof(ParallelSortRange));
+		size = MAXALIGN(add_size(size, ParallelSortRangesOffset(nworkers)));
+	}
+	*instrument_offset = size;
+
+	if (node->ss.ps.instrument)
+	{
+		size = add_size(size, offsetof(SharedSortInfo, sinstrument));
+		size = add_size(size, mul_size(nworkers,
+									   sizeof(TuplesortInstrumentation)));
+	}
+
+	return size;
+}
+
 /* ----------------------------------------------------------------
  *		ExecSortEstimate
  *
- *		Estimate space required to propagate sort statistics.
+ *		Estimate space required for a Parallel Sort's shared state and to
+ *		propagate sort statistics.
  * ----------------------------------------------------------------
  */
 void
 ExecSortEstimate(SortState *node, ParallelContext *pcxt)
 {
 	Size		size;
+	Size		instrument_offset;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	/* don't need this if no workers */
+	if (pcxt->nworkers == 0)
+		return;
+
+	size = sort_shared_size(node, pcxt->nworkers,
+							node->ss.ps.plan->parallel_aware,
+							&instrument_offset);
+	if (size == 0)
 		return;
 
-	size = mul_size(pcxt->nworkers, sizeof(TuplesortInstrumentation));
-	size = add_size(size, offsetof(SharedSortInfo, sinstrument));
 	shm_toc_estimate_chunk(&pcxt->estimator, size);
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 }
@@ -370,40 +854,102 @@ ExecSortEstimate(SortState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecSortInitializeDSM
  *
- *		Initialize DSM space for sort statistics.
+ *		Initialize DSM space for a Parallel Sort and for sort statistics.
  * ----------------------------------------------------------------
  */
 void
 ExecSortInitializeDSM(SortState *node, ParallelContext *pcxt)
 {
+	bool		parallel_aware;
 	Size		size;
+	Size		instrument_offset;
+	char	   *shared;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	/* don't need this if no workers */
+	if (pcxt->nworkers == 0)
 		return;
 
-	size = offsetof(SharedSortInfo, sinstrument)
-		+ pcxt->nworkers * sizeof(TuplesortInstrumentation);
-	node->shared_info = shm_toc_allocate(pcxt->toc, size);
-	/* ensure any unfilled slots will contain zeroes */
-	memset(node->shared_info, 0, size);
-	node->shared_info->num_workers = pcxt->nworkers;
-	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id,
-				   node->shared_info);
+	/* a Parallel Sort's shared files need a DSM segment */
+	parallel_aware = node->ss.ps.plan->parallel_aware && pcxt->seg != NULL;
+	size = sort_shared_size(node, pcxt->nworkers, parallel_aware,
+							&instrument_offset);
+	if (size == 0)
+		return;
+
+	shared = shm_toc_allocate(pcxt->toc, size);
+
+	if (parallel_aware)
+	{
+		ParallelSortState *pstate = (ParallelSortState *) shared;
+
+		pstate->maxruns = pcxt->nworkers;
+		pstate->nranges = node->nrange_bounds + 1;
+		pstate->instrument_offset =
+			node->ss.ps.instrument ? instrument_offset : 0;
+		SpinLockInit(&pstate->mutex);
+		ConditionVariableInit(&pstate->cv);
+		SharedFileSetInit(&pstate->fileset, pcxt->seg);
+		parallel_sort_initialize(pstate);
+		node->pstate = pstate;
+	}
+
+	if (node->ss.ps.instrument)
+	{
+		node->shared_info = (SharedSortInfo *) (shared + instrument_offset);
+		/* ensure any unfilled slots will contain zeroes */
+		memset(node->shared_info, 0, size - instrument_offset);
+		node->shared_info->num_workers = pcxt->nworkers;
+	}
+
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, shared);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSortReInitializeDSM
+ *
+ *		Reset a Parallel Sort's shared state for a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSortReInitializeDSM(SortState *node, ParallelContext *pcxt)
+{
+	if (node->pstate == NULL)
+		return;
+
+	SharedFileSetDeleteAll(&node->pstate->fileset);
+	parallel_sort_initialize(node->pstate);
 }
 
 /* ----------------------------------------------------------------
  *		ExecSortInitializeWorker
  *
- *		Attach worker to DSM space for sort statistics.
+ *		Attach worker to DSM space for a Parallel Sort and for sort
+ *		statistics.
  * ----------------------------------------------------------------
  */
 void
 ExecSortInitializeWorker(SortState *node, ParallelWorkerContext *pwcxt)
 {
-	node->shared_info =
-		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+	char	   *shared;
+
+	shared = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
 	node->am_worker = true;
+
+	if (shared == NULL)
+		return;
+
+	if (node->ss.ps.plan->parallel_aware)
+	{
+		ParallelSortState *pstate = (ParallelSortState *) shared;
+
+		SharedFileSetAttach(&pstate->fileset, pwcxt->seg);
+		node->pstate = pstate;
+		if (pstate->instrument_offset != 0)
+			node->shared_info =
+				(SharedSortInfo *) (shared + pstate->instrument_offset);
+	}
+	else
+		node->shared_info = (SharedSortInfo *) shared;
 }
 
 /* ----------------------------------------------------------------
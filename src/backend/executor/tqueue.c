@@ -8,6 +8,12 @@
  *
  * A TupleQueueReader reads tuples from a shm_mq and returns the tuples.
  *
+ * To keep the per-message synchronization between the two sides from
+ * limiting throughput, tuples are sent in batches: each shm_mq message
+ * holds one or more tuples, each preceded by its length.  The sender
+ * accumulates tuples until it has about TQUEUE_BATCH_SIZE bytes, or until
+ * the executor run ends, and the reader hands them out one at a time.
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -21,6 +27,17 @@
 
 #include "access/htup_details.h"
 #include "executor/tqueue.h"
+#include "lib/stringinfo.h"
+
+/*
+ * Target size of a batch of tuples sent as one message.  This is a fraction
+ * of the size of the tuple queues set up by execParallel.c, so that the
+ * worker can keep filling the next batch while the leader reads the last.
+ */
+#define TQUEUE_BATCH_SIZE		8192
+
+/* Space for a tuple's length word, which keeps the tuple itself aligned */
+#define TQUEUE_TUPLE_HEADER		MAXALIGN(sizeof(uint32))
 
 /*
  * DestReceiver object's private contents
@@ -31,6 +48,7 @@ typedef struct TQueueDestReceiver
 {
 	DestReceiver pub;			/* public fields */
 	shm_mq_handle *queue;		/* shm_mq to send to */
+	StringInfoData batch;		/* tuples not sent yet */
 } TQueueDestReceiver;
 
 /*
@@ -43,10 +61,52 @@ typedef struct TQueueDestReceiver
 struct TupleQueueReader
 {
 	shm_mq_handle *queue;		/* shm_mq to receive from */
+	char	   *batch;			/* last message received, if any */
+	Size		batch_len;		/* length of that message */
+	Size		batch_pos;		/* offset of its next tuple */
 };
 
 /*
- * Receive a tuple from a query, and send it to the designated shm_mq.
+ * Check the result of sending a message to the shm_mq.
+ *
+ * Returns true if successful, false if shm_mq has been detached.
+ */
+static bool
+tqueueCheckSend(shm_mq_result result)
+{
+	if (result == SHM_MQ_DETACHED)
+		return false;
+	else if (result != SHM_MQ_SUCCESS)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not send tuple to shared-memory queue")));
+
+	return true;
+}
+
+/*
+ * Send the batch of tuples accumulated so far, if any.
+ *
+ * Returns true if successful, false if shm_mq has been detached.
+ */
+static bool
+tqueueFlushBatch(TQueueDestReceiver *tqueue)
+{
+	shm_mq_result result;
+
+	if (tqueue->batch.len == 0)
+		return true;
+
+	result = shm_mq_send(tqueue->queue, tqueue->batch.len,
+						 tqueue->batch.data, false);
+	resetStringInfo(&tqueue->batch);
+
+	return tqueueCheckSend(result);
+}
+
+/*
+ * Receive a tuple from a query, and add it to the batch for the designated
+ * shm_mq, sending the batch once it's full.
  *
  * Returns true if successful, false if shm_mq has been detached.
  */
@@ -54,26 +114,57 @@ static bool
 tqueueReceiveSlot(TupleTableSlot *slot, DestReceiver *self)
 {
 	TQueueDestReceiver *tqueue = (TQueueDestReceiver *) self;
+	StringInfo	batch = &tqueue->batch;
 	HeapTuple	tuple;
-	shm_mq_result result;
+	uint32		t_len;
+	Size		reclen;
 	bool		should_free;
+	bool		result = true;
 
-	/* Send the tuple itself. */
 	tuple = ExecFetchSlotHeapTuple(slot, true, &should_free);
-	result = shm_mq_send(tqueue->queue, tuple->t_len, tuple->t_data, false);
+	t_len = tuple->t_len;
+	reclen = TQUEUE_TUPLE_HEADER + MAXALIGN(t_len);
+
+	if (reclen > TQUEUE_BATCH_SIZE)
+	{
+		char		header[TQUEUE_TUPLE_HEADER];
+		shm_mq_iovec iov[2];
+
+		/*
+		 * A tuple this large would just be copied around for nothing, so
+		 * send it by itself, after whatever precedes it.
+		 */
+		memset(header, 0, TQUEUE_TUPLE_HEADER);
+		memcpy(header, &t_len, sizeof(uint32));
+		iov[0].data = header;
+		iov[0].len = TQUEUE_TUPLE_HEADER;
+		iov[1].data = (char *) tuple->t_data;
+		iov[1].len = t_len;
+
+		result = tqueueFlushBatch(tqueue) &&
+			tqueueCheckSend(shm_mq_sendv(tqueue->queue, iov, 2, false));
+	}
+	else
+	{
+		char	   *rec;
+
+		enlargeStringInfo(batch, reclen);
+		rec = batch->data + batch->len;
+		memset(rec, 0, TQUEUE_TUPLE_HEADER);
+		memcpy(rec, &t_len, sizeof(uint32));
+		memcpy(rec + TQUEUE_TUPLE_HEADER, tuple->t_data, t_len);
+		/* zero the alignment padding, so we don't send uninitialized bytes */
+		memset(rec + TQUEUE_TUPLE_HEADER + t_len, 0, MAXALIGN(t_len) - t_len);
+		batch->len += reclen;
+
+		if (batch->len >= TQUEUE_BATCH_SIZE)
+			result = tqueueFlushBatch(tqueue);
+	}
 
 	if (should_free)
 		heap_freetuple(tuple);
 
-	/* Check for failure. */
-	if (result == SHM_MQ_DETACHED)
-		return false;
-	else if (result != SHM_MQ_SUCCESS)
-		ereport(ERROR,
-				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
-				 errmsg("could not send tuple to shared-memory queue")));
-
-	return true;
+	return result;
 }
 
 /*
@@ -94,7 +185,11 @@ tqueueShutdownReceiver(DestReceiver *self)
 	TQueueDestReceiver *tqueue = (TQueueDestReceiver *) self;
 
 	if (tqueue->queue != NULL)
+	{
+		/* Send any remaining tuples; the reader may have gone already */
+		(void) tqueueFlushBatch(tqueue);
 		shm_mq_detach(tqueue->queue);
+	}
 	tqueue->queue = NULL;
 }
 
@@ -109,6 +204,7 @@ tqueueDestroyReceiver(DestReceiver *self)
 	/* We probably already detached from queue, but let's be sure */
 	if (tqueue->queue != NULL)
 		shm_mq_detach(tqueue->queue);
+	pfree(tqueue->batch.data);
 	pfree(self);
 }
 
@@ -128,6 +224,7 @@ CreateTupleQueueDestReceiver(shm_mq_handle *handle)
 	self->pub.rDestroy = tqueueDestroyReceiver;
 	self->pub.mydest = DestTupleQueue;
 	self->queue = handle;
+	initStringInfo(&self->batch);
 
 	return (DestReceiver *) self;
 }
@@ -176,28 +273,44 @@ HeapTuple
 TupleQueueReaderNext(TupleQueueReader *reader, bool nowait, bool *done)
 {
 	HeapTupleData htup;
-	shm_mq_result result;
-	Size		nbytes;
-	void	   *data;
+	uint32		t_len;
 
 	if (done != NULL)
 		*done = false;
 
-	/* Attempt to read a message. */
-	result = shm_mq_receive(reader->queue, &nbytes, &data, nowait);
-
-	/* If queue is detached, set *done and return NULL. */
-	if (result == SHM_MQ_DETACHED)
+	/*
+	 * If we've returned all the tuples of the last batch, read another one.
+	 * The previous message stays valid until then.
+	 */
+	while (reader->batch_pos >= reader->batch_len)
 	{
-		if (done != NULL)
-			*done = true;
-		return NULL;
+		shm_mq_result result;
+		Size		nbytes;
+		void	   *data;
+
+		/* Attempt to read a message. */
+		result = shm_mq_receive(reader->queue, &nbytes, &data, nowait);
+
+		/* If queue is detached, set *done and return NULL. */
+		if (result == SHM_MQ_DETACHED)
+		{
+			if (done != NULL)
+				*done = true;
+			return NULL;
+		}
+
+		/* In non-blocking mode, bail out if no message ready yet. */
+		if (result == SHM_MQ_WOULD_BLOCK)
+			return NULL;
+		Assert(result == SHM_MQ_SUCCESS);
+
+		reader->batch = data;
+		reader->batch_len = nbytes;
+		reader->batch_pos = 0;
 	}
 
-	/* In non-blocking mode, bail out if no message ready yet. */
-	if (result == SHM_MQ_WOULD_BLOCK)
-		return NULL;
-	Assert(result == SHM_MQ_SUCCESS);
+	memcpy(&t_len, reader->batch + reader->batch_pos, sizeof(uint32));
+	Assert(reader->batch_pos + TQUEUE_TUPLE_HEADER + t_len <= reader->batch_len);
 
 	/*
 	 * Set up a dummy HeapTupleData pointing to the data from the shm_mq
@@ -205,8 +318,11 @@ TupleQueueReaderNext(TupleQueueReader *reader, bool nowait, bool *done)
 	 */
 	ItemPointerSetInvalid(&htup.t_self);
 	htup.t_tableOid = InvalidOid;
-	htup.t_len = nbytes;
-	htup.t_data = data;
+	htup.t_len = t_len;
+	htup.t_data = (HeapTupleHeader) (reader->batch + reader->batch_pos +
+									 TQUEUE_TUPLE_HEADER);
+
+	reader->batch_pos += TQUEUE_TUPLE_HEADER + MAXALIGN(t_len);
 
 	return heap_copytuple(&htup);
 }
@@ -158,6 +158,30 @@ llvm_create_context(int jitFlags)
 	return context;
 }
 
+/*
+ * Create a context for JITed code that is to live as long as the backend.
+ *
+ * Unlike contexts created by llvm_create_context(), this one isn't associated
+ * with a resource owner, and is never released.  It is used for code that
+ * doesn't reference any per-query state, so it can be reused by later
+ * queries.
+ */
+LLVMJitContext *
+llvm_create_persistent_context(int jitFlags)
+{
+	LLVMJitContext *context;
+
+	llvm_assert_in_fatal_section();
+
+	llvm_session_initialize();
+
+	context = MemoryContextAllocZero(TopMemoryContext,
+									 sizeof(LLVMJitContext));
+	context->base.flags = jitFlags;
+
+	return context;
+}
+
 /*
  * Release resources required by one llvm context.
  */
@@ -20,11 +20,53 @@
 
 #include <llvm-c/Core.h>
 
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/tupdesc_details.h"
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "nodes/pg_list.h"
+#include "utils/hashutils.h"
+#include "utils/memutils.h"
+
+
+/*
+ * The parts of an attribute's definition the generated deform code depends
+ * on.  Kept free of padding, so it can be hashed and compared bytewise.
+ */
+typedef struct DeformAttLayout
+{
+	int16		attlen;
+	char		attalign;
+	bool		attbyval;
+	bool		attnotnull;
+	bool		atthasmissing;
+} DeformAttLayout;
+
+/*
+ * An entry in the backend-lifetime cache of deform functions.
+ */
+typedef struct DeformCacheEntry
+{
+	const TupleTableSlotOps *ops;	/* slot type the function handles */
+	int			natts;			/* number of columns deformed */
+	int			desc_natts;		/* number of columns in the descriptor */
+	uint32		hash;			/* hash of layout, for quick rejection */
+	DeformAttLayout *layout;	/* desc_natts entries */
+	void	   *fn;				/* address of the emitted function */
+} DeformCacheEntry;
+
+/*
+ * Upper bound on the number of cached deform functions.  Emitted code is
+ * never freed, so without a limit a backend touching many differently shaped
+ * tables would grow without bound.  Once full, deform functions are again
+ * emitted as part of the individual query.
+ */
+#define MAX_CACHED_DEFORM_FUNCS 256
+
+static LLVMJitContext *deform_cache_context = NULL;
+static List *deform_cache = NIL;
 
 
 /*
@@ -751,3 +793,120 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+/*
+ * Return the address of a deform function for tuples of type desc, up to
+ * natts columns, emitting one if no earlier query has done so yet.
+ *
+ * Contrary to expression code, which embeds pointers to per-execution state,
+ * deform functions depend only on the physical layout of the tuple, so a
+ * function emitted once can be used by any later query in this backend that
+ * deforms tuples of the same layout - e.g. each execution of a prepared
+ * statement.  Returns NULL if no function can be provided, in which case the
+ * caller should fall back to slot_compile_deform().
+ */
+void *
+slot_get_cached_deform(TupleDesc desc, const TupleTableSlotOps *ops, int natts)
+{
+	DeformAttLayout *layout;
+	Size		layoutsz;
+	uint32		hash;
+	ListCell   *lc;
+	DeformCacheEntry *entry;
+	LLVMValueRef v_deform_fn;
+	char	   *funcname;
+	void	   *fn;
+	MemoryContext oldcontext;
+	int			attnum;
+
+	/* same restrictions as slot_compile_deform() */
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	if (desc->natts == 0)
+		return NULL;
+
+	layoutsz = sizeof(DeformAttLayout) * desc->natts;
+	layout = palloc0(layoutsz);
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+
+		layout[attnum].attlen = att->attlen;
+		layout[attnum].attalign = att->attalign;
+		layout[attnum].attbyval = att->attbyval;
+		layout[attnum].attnotnull = att->attnotnull;
+		layout[attnum].atthasmissing = att->atthasmissing;
+	}
+	hash = hash_combine(DatumGetUInt32(hash_any((unsigned char *) layout,
+												 (int) layoutsz)),
+						DatumGetUInt32(hash_uint32((uint32) natts)));
+
+	foreach(lc, deform_cache)
+	{
+		entry = (DeformCacheEntry *) lfirst(lc);
+
+		if (entry->hash == hash &&
+			entry->ops == ops &&
+			entry->natts == natts &&
+			entry->desc_natts == desc->natts &&
+			memcmp(entry->layout, layout, layoutsz) == 0)
+		{
+			pfree(layout);
+			return entry->fn;
+		}
+	}
+
+	if (list_length(deform_cache) >= MAX_CACHED_DEFORM_FUNCS)
+	{
+		pfree(layout);
+		return NULL;
+	}
+
+	if (deform_cache_context == NULL)
+		deform_cache_context =
+			llvm_create_persistent_context(PGJIT_OPT3 | PGJIT_DEFORM);
+
+	/*
+	 * If emitting a function errored out earlier, the half-built module is
+	 * still around.  Don't let it get compiled together with the new one.
+	 */
+	if (deform_cache_context->module != NULL)
+	{
+		LLVMDisposeModule(deform_cache_context->module);
+		deform_cache_context->module = NULL;
+	}
+
+	v_deform_fn = slot_compile_deform(deform_cache_context, desc, ops, natts);
+	if (v_deform_fn == NULL)
+	{
+		pfree(layout);
+		return NULL;
+	}
+
+	/* needs to be visible to be looked up once emitted */
+	LLVMSetLinkage(v_deform_fn, LLVMExternalLinkage);
+	funcname = pstrdup(LLVMGetValueName(v_deform_fn));
+
+	fn = llvm_get_function(deform_cache_context, funcname);
+	pfree(funcname);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	entry = palloc(sizeof(DeformCacheEntry));
+	entry->ops = ops;
+	entry->natts = natts;
+	entry->desc_natts = desc->natts;
+	entry->hash = hash;
+	entry->layout = palloc(layoutsz);
+	memcpy(entry->layout, layout, layoutsz);
+	entry->fn = fn;
+	deform_cache = lappend(deform_cache, entry);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	pfree(layout);
+
+	return fn;
+}
@@ -317,14 +317,34 @@ llvm_compile_expr(ExprState *state)
 					 * If the tupledesc of the to-be-deformed tuple is known,
 					 * and JITing of deforming is enabled, build deform
 					 * function specific to tupledesc and the exact number of
-					 * to-be-extracted attributes.
+					 * to-be-extracted attributes.  As such a function only
+					 * depends on the tuple layout, reuse one emitted by an
+					 * earlier query if possible.
 					 */
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
-						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+						void	   *cached_deform;
+
+						cached_deform = slot_get_cached_deform(desc, tts_ops,
+															   op->d.fetch.last_var);
+
+						if (cached_deform)
+						{
+							LLVMTypeRef param_types[1];
+							LLVMTypeRef deform_sig;
+
+							param_types[0] = l_ptr(StructTupleTableSlot);
+							deform_sig = LLVMFunctionType(LLVMVoidType(),
+														  param_types,
+														  lengthof(param_types), 0);
+							l_jit_deform = l_ptr_const(cached_deform,
+													   l_ptr(deform_sig));
+						}
+						else
+							l_jit_deform =
+								slot_compile_deform(context, desc,
+													tts_ops,
+													op->d.fetch.last_var);
 					}
 
 					if (l_jit_deform)
@@ -1566,6 +1586,12 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_SCAN_VAR_CMP_CONST:
+				build_EvalXFunc(b, mod, "ExecEvalScanVarCmpConst",
+								v_state, v_econtext, op);
+				LLVMBuildBr(b, opblocks[i + 1]);
+				break;
+
 			case EEOP_SQLVALUEFUNCTION:
 				build_EvalXFunc(b, mod, "ExecEvalSQLValueFunction",
 								v_state, v_econtext, op);
@@ -1959,6 +1985,137 @@ llvm_compile_expr(ExprState *state)
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
+			case EEOP_CSE_RESET:
+				build_EvalXFunc(b, mod, "ExecEvalCSEReset",
+								v_state, v_econtext, op);
+				LLVMBuildBr(b, opblocks[i + 1]);
+				break;
+
+			case EEOP_CSE_LOAD:
+				{
+					LLVMBasicBlockRef b_valid;
+					LLVMValueRef v_validp,
+								v_valid;
+					LLVMValueRef v_valuep,
+								v_value;
+					LLVMValueRef v_isnullp,
+								v_isnull;
+
+					b_valid = l_bb_before_v(opblocks[i + 1],
+											"op.%d.valid", i);
+
+					v_validp = l_ptr_const(op->d.cse.valid,
+										   l_ptr(TypeStorageBool));
+					v_valid = LLVMBuildLoad(b, v_validp, "");
+					LLVMBuildCondBr(b,
+									LLVMBuildICmp(b, LLVMIntEQ, v_valid,
+												  l_sbool_const(1), ""),
+									b_valid,
+									opblocks[i + 1]);
+
+					/* already computed, fetch value and skip evaluation */
+					LLVMPositionBuilderAtEnd(b, b_valid);
+					v_valuep = l_ptr_const(op->d.cse.value,
+										   l_ptr(TypeSizeT));
+					v_isnullp = l_ptr_const(op->d.cse.isnull,
+											l_ptr(TypeStorageBool));
+					v_value = LLVMBuildLoad(b, v_valuep, "");
+					v_isnull = LLVMBuildLoad(b, v_isnullp, "");
+					LLVMBuildStore(b, v_value, v_resvaluep);
+					LLVMBuildStore(b, v_isnull, v_resnullp);
+					LLVMBuildBr(b, opblocks[op->d.cse.jumpdone]);
+					break;
+				}
+
+			case EEOP_CSE_STORE:
+				build_EvalXFunc(b, mod, "ExecEvalCSEStore",
+								v_state, v_econtext, op);
+				LLVMBuildBr(b, opblocks[i + 1]);
+				break;
+
+			case EEOP_HASHDATUM_SET_INITVAL:
+				{
+					LLVMValueRef v_initvalue;
+
+					v_initvalue =
+						l_sizet_const(op->d.hashdatum_initvalue.init_value);
+
+					LLVMBuildStore(b, v_initvalue, v_resvaluep);
+					LLVMBuildStore(b, l_sbool_const(0), v_resnullp);
+					LLVMBuildBr(b, opblocks[i + 1]);
+					break;
+				}
+
+			case EEOP_HASHDATUM_NEXT32:
+			case EEOP_HASHDATUM_NEXT32_STRICT:
+				{
+					FunctionCallInfo fcinfo = op->d.hashdatum.fcinfo_data;
+					LLVMValueRef v_fcinfo;
+					LLVMValueRef v_prevhash;
+					LLVMValueRef v_tmp1,
+								v_tmp2;
+					LLVMValueRef v_rotated;
+					LLVMValueRef v_argisnull;
+					LLVMValueRef v_retval;
+					LLVMValueRef v_fcinfo_isnull;
+					LLVMValueRef v_hashvalue;
+					LLVMBasicBlockRef b_ifnotnull;
+					LLVMBasicBlockRef b_ifnull;
+
+					b_ifnotnull = l_bb_before_v(opblocks[i + 1],
+												"b.%d.ifnotnull", i);
+					b_ifnull = l_bb_before_v(opblocks[i + 1],
+											 "b.%d.ifnull", i);
+
+					v_fcinfo = l_ptr_const(fcinfo,
+										   l_ptr(StructFunctionCallInfoData));
+
+					/* rotate hash value left 1 bit */
+					v_prevhash = LLVMBuildTrunc(b,
+												LLVMBuildLoad(b, v_resvaluep, ""),
+												LLVMInt32Type(), "");
+					v_tmp1 = LLVMBuildShl(b, v_prevhash, l_int32_const(1), "");
+					v_tmp2 = LLVMBuildLShr(b, v_prevhash, l_int32_const(31), "");
+					v_rotated = LLVMBuildOr(b, v_tmp1, v_tmp2, "rotatedhash");
+
+					v_argisnull = l_funcnull(b, v_fcinfo, 0);
+					LLVMBuildCondBr(b,
+									LLVMBuildICmp(b, LLVMIntEQ, v_argisnull,
+												  l_sbool_const(1), ""),
+									b_ifnull,
+									b_ifnotnull);
+
+					LLVMPositionBuilderAtEnd(b, b_ifnull);
+					if (opcode == EEOP_HASHDATUM_NEXT32_STRICT)
+					{
+						/* tuple can't match, return NULL */
+						LLVMBuildStore(b, l_sizet_const(0), v_resvaluep);
+						LLVMBuildStore(b, l_sbool_const(1), v_resnullp);
+						LLVMBuildBr(b, opblocks[op->d.hashdatum.jumpdone]);
+					}
+					else
+					{
+						/* NULL hashes to zero, just store the rotated value */
+						LLVMBuildStore(b,
+									   LLVMBuildZExt(b, v_rotated, TypeSizeT, ""),
+									   v_resvaluep);
+						LLVMBuildBr(b, opblocks[i + 1]);
+					}
+
+					LLVMPositionBuilderAtEnd(b, b_ifnotnull);
+					v_retval = BuildV1Call(context, b, mod, fcinfo,
+										   &v_fcinfo_isnull);
+					v_hashvalue = LLVMBuildXor(b, v_rotated,
+											   LLVMBuildTrunc(b, v_retval,
+															  LLVMInt32Type(), ""),
+											   "");
+					LLVMBuildStore(b,
+								   LLVMBuildZExt(b, v_hashvalue, TypeSizeT, ""),
+								   v_resvaluep);
+					LLVMBuildBr(b, opblocks[i + 1]);
+					break;
+				}
+
 			case EEOP_AGG_STRICT_DESERIALIZE:
 				{
 					FunctionCallInfo fcinfo = op->d.agg_deserialize.fcinfo_data;
@@ -2083,6 +2240,40 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_AGG_PLAIN_PERGROUP_NULLCHECK:
+				{
+					int			jumpnull;
+					LLVMValueRef v_aggstatep;
+					LLVMValueRef v_allpergroupsp;
+					LLVMValueRef v_pergroup_allaggs;
+					LLVMValueRef v_setoff;
+
+					jumpnull = op->d.agg_plain_pergroup_nullcheck.jumpnull;
+
+					/*
+					 * pergroup_allaggs = aggstate->all_pergroups
+					 * [op->d.agg_plain_pergroup_nullcheck.setoff];
+					 */
+					v_aggstatep = l_ptr_const(castNode(AggState, parent),
+											  l_ptr(StructAggState));
+
+					v_allpergroupsp =
+						l_load_struct_gep(b, v_aggstatep,
+										  FIELDNO_AGGSTATE_ALL_PERGROUPS,
+										  "aggstate.all_pergroups");
+
+					v_setoff =
+						l_int32_const(op->d.agg_plain_pergroup_nullcheck.setoff);
+
+					v_pergroup_allaggs = l_load_gep1(b, v_allpergroupsp, v_setoff, "");
+
+					LLVMBuildCondBr(b,
+									LLVMBuildIsNull(b, v_pergroup_allaggs, ""),
+									opblocks[jumpnull],
+									opblocks[i + 1]);
+					break;
+				}
+
 			case EEOP_AGG_INIT_TRANS:
 				{
 					AggState   *aggstate;
@@ -1538,6 +1538,7 @@ ReadCommonPlan(Plan *local_node)
 	READ_INT_FIELD(plan_width);
 	READ_BOOL_FIELD(parallel_aware);
 	READ_BOOL_FIELD(parallel_safe);
+	READ_BOOL_FIELD(async_capable);
 	READ_INT_FIELD(plan_node_id);
 	READ_NODE_FIELD(targetlist);
 	READ_NODE_FIELD(qual);
@@ -1745,9 +1746,11 @@ _readScan(void)
 static SeqScan *
 _readSeqScan(void)
 {
-	READ_LOCALS_NO_FIELDS(SeqScan);
+	READ_LOCALS(SeqScan);
 
-	ReadCommonScan(local_node);
+	ReadCommonScan(&local_node->scan);
+
+	READ_NODE_FIELD(bloomkeys);
 
 	READ_DONE();
 }
@@ -2110,6 +2113,46 @@ _readMaterial(void)
 	READ_DONE();
 }
 
+/*
+ * _readIncrementalSort
+ */
+static IncrementalSort *
+_readIncrementalSort(void)
+{
+	READ_LOCALS(IncrementalSort);
+
+	ReadCommonPlan(&local_node->sort.plan);
+
+	READ_INT_FIELD(sort.numCols);
+	READ_ATTRNUMBER_ARRAY(sort.sortColIdx, local_node->sort.numCols);
+	READ_OID_ARRAY(sort.sortOperators, local_node->sort.numCols);
+	READ_OID_ARRAY(sort.collations, local_node->sort.numCols);
+	READ_BOOL_ARRAY(sort.nullsFirst, local_node->sort.numCols);
+	READ_INT_FIELD(nPresortedCols);
+
+	READ_DONE();
+}
+
+/*
+ * _readResultCache
+ */
+static ResultCache *
+_readResultCache(void)
+{
+	READ_LOCALS(ResultCache);
+
+	ReadCommonPlan(&local_node->plan);
+
+	READ_INT_FIELD(numKeys);
+	READ_OID_ARRAY(hashOperators, local_node->numKeys);
+	READ_NODE_FIELD(param_exprs);
+	READ_BOOL_FIELD(singlerow);
+	READ_UINT_FIELD(est_entries);
+	READ_BITMAPSET_FIELD(keyparamids);
+
+	READ_DONE();
+}
+
 /*
  * _readSort
  */
@@ -2125,6 +2168,7 @@ _readSort(void)
 	READ_OID_ARRAY(sortOperators, local_node->numCols);
 	READ_OID_ARRAY(collations, local_node->numCols);
 	READ_BOOL_ARRAY(nullsFirst, local_node->numCols);
+	READ_NODE_FIELD(rangeBounds);
 
 	READ_DONE();
 }
@@ -2752,6 +2796,10 @@ parseNodeString(void)
 		return_value = _readHashJoin();
 	else if (MATCH("MATERIAL", 8))
 		return_value = _readMaterial();
+	else if (MATCH("INCREMENTALSORT", 15))
+		return_value = _readIncrementalSort();
+	else if (MATCH("RESULTCACHE", 11))
+		return_value = _readResultCache();
 	else if (MATCH("SORT", 4))
 		return_value = _readSort();
 	else if (MATCH("GROUP", 5))
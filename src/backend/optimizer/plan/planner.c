@@ -199,6 +199,7 @@ static RelOptInfo *create_ordered_paths(PlannerInfo *root,
 					 PathTarget *target,
 					 bool target_parallel_safe,
 					 double limit_tuples);
+static bool can_range_partition_sort(PlannerInfo *root, PathKey *pathkey);
 static PathTarget *make_group_input_target(PlannerInfo *root,
 						PathTarget *final_target);
 static PathTarget *make_partial_grouping_target(PlannerInfo *root,
@@ -318,9 +319,9 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	/*
 	 * Assess whether it's feasible to use parallel mode for this query. We
 	 * can't do this in a standalone backend, or if the command will try to
-	 * modify any data, or if this is a cursor operation, or if GUCs are set
-	 * to values that don't permit parallelism, or if parallel-unsafe
-	 * functions are present in the query tree.
+	 * modify any data other than by a plain INSERT, or if this is a cursor
+	 * operation, or if GUCs are set to values that don't permit parallelism,
+	 * or if parallel-unsafe functions are present in the query tree.
 	 *
 	 * (Note that we do allow CREATE TABLE AS, SELECT INTO, and CREATE
 	 * MATERIALIZED VIEW to use parallel plans, but this is safe only because
@@ -328,9 +329,13 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	 * be able to see.  If the workers could see the table, the fact that
 	 * group locking would cause them to ignore the leader's heavyweight
 	 * relation extension lock and GIN page locks would make this unsafe.
-	 * We'll have to fix that somehow if we want to allow parallel inserts in
-	 * general; updates and deletes have additional problems especially around
-	 * combo CIDs.)
+	 *
+	 * INSERT is allowed on the same terms: the workers only ever execute the
+	 * part of the plan below the Gather, so all the tuples are still inserted
+	 * by the leader, and max_parallel_hazard checks that nothing fired on the
+	 * target relation -- triggers, index expressions, check constraints --
+	 * would be unsafe to run in parallel mode.  Updates and deletes have
+	 * additional problems, especially around combo CIDs.)
 	 *
 	 * For now, we don't try to use parallel mode if we're running inside a
 	 * parallel worker.  We might eventually be able to relax this
@@ -347,7 +352,8 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	 */
 	if ((cursorOptions & CURSOR_OPT_PARALLEL_OK) != 0 &&
 		IsUnderPostmaster &&
-		parse->commandType == CMD_SELECT &&
+		(parse->commandType == CMD_SELECT ||
+		 parse->commandType == CMD_INSERT) &&
 		!parse->hasModifyingCTE &&
 		max_parallel_workers_per_gather > 0 &&
 		!IsParallelWorker() &&
@@ -380,8 +386,12 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	 * either some function the user included in the query is incorrectly
 	 * labelled as parallel-safe or parallel-restricted when in reality it's
 	 * parallel-unsafe, or else the query planner itself has a bug.
+	 *
+	 * We don't do this for INSERT, since a plan that doesn't actually use
+	 * parallelism gains nothing from it there.
 	 */
 	glob->parallelModeNeeded = glob->parallelModeOK &&
+		parse->commandType == CMD_SELECT &&
 		(force_parallel_mode != FORCE_PARALLEL_OFF);
 
 	/* Determine what fraction of the plan is likely to be scanned */
@@ -4871,19 +4881,22 @@ create_ordered_paths(PlannerInfo *root,
 
 	foreach(lc, input_rel->pathlist)
 	{
-		Path	   *path = (Path *) lfirst(lc);
+		Path	   *input_path = (Path *) lfirst(lc);
+		Path	   *path = input_path;
 		bool		is_sorted;
+		int			presorted_keys;
 
-		is_sorted = pathkeys_contained_in(root->sort_pathkeys,
-										  path->pathkeys);
-		if (path == cheapest_input_path || is_sorted)
+		is_sorted = pathkeys_count_contained_in(root->sort_pathkeys,
+												input_path->pathkeys,
+												&presorted_keys);
+		if (input_path == cheapest_input_path || is_sorted)
 		{
 			if (!is_sorted)
 			{
 				/* An explicit sort here can take advantage of LIMIT */
 				path = (Path *) create_sort_path(root,
 												 ordered_rel,
-												 path,
+												 input_path,
 												 root->sort_pathkeys,
 												 limit_tuples);
 			}
@@ -4895,6 +4908,29 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, path);
 		}
+
+		/*
+		 * If the input is already sorted on a prefix of the required
+		 * ordering, also consider sorting only the rest of the keys
+		 * incrementally.  That is worthwhile even for a path that isn't the
+		 * cheapest one, since it can return the first rows much sooner.
+		 */
+		if (enable_incremental_sort && !is_sorted && presorted_keys > 0)
+		{
+			path = (Path *) create_incremental_sort_path(root,
+														 ordered_rel,
+														 input_path,
+														 root->sort_pathkeys,
+														 presorted_keys,
+														 limit_tuples);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
 	}
 
 	/*
@@ -4945,6 +4981,42 @@ create_ordered_paths(PlannerInfo *root,
 												path, target);
 
 			add_path(ordered_rel, path);
+
+			/*
+			 * Also consider a Parallel Sort, in which the workers split the
+			 * final merge among themselves by ranges of the leading sort key
+			 * and Gather Merge only has to return their outputs in turn.
+			 * That needs statistics to choose the ranges, and isn't useful
+			 * when only the first few rows are wanted, since every range is
+			 * merged before the first row is returned.
+			 */
+			if (enable_parallel_sort && limit_tuples < 0 &&
+				can_range_partition_sort(root,
+										 linitial_node(PathKey,
+													   root->sort_pathkeys)))
+			{
+				path = (Path *) create_sort_path(root,
+												 ordered_rel,
+												 cheapest_partial_path,
+												 root->sort_pathkeys,
+												 limit_tuples);
+				path->parallel_aware = true;
+				cost_parallel_sort(path, path->parallel_workers);
+
+				path = (Path *)
+					create_gather_merge_path(root, ordered_rel,
+											 path,
+											 path->pathtarget,
+											 root->sort_pathkeys, NULL,
+											 &total_groups);
+
+				/* Add projection step if needed */
+				if (path->pathtarget != target)
+					path = apply_projection_to_path(root, ordered_rel,
+													path, target);
+
+				add_path(ordered_rel, path);
+			}
 		}
 	}
 
@@ -4972,6 +5044,43 @@ create_ordered_paths(PlannerInfo *root,
 	return ordered_rel;
 }
 
+/*
+ * can_range_partition_sort
+ *	  Check whether a Parallel Sort could choose range bounds for the given
+ *	  leading pathkey, that is, whether there are statistics for one of its
+ *	  expressions.
+ *
+ * create_sort_plan() computes the actual bounds for whichever expression
+ * ends up as the sort column.
+ */
+static bool
+can_range_partition_sort(PlannerInfo *root, PathKey *pathkey)
+{
+	ListCell   *lc;
+
+	if (pathkey->pk_eclass->ec_has_volatile)
+		return false;
+
+	foreach(lc, pathkey->pk_eclass->ec_members)
+	{
+		EquivalenceMember *em = (EquivalenceMember *) lfirst(lc);
+		Oid			sortop;
+
+		if (em->em_is_const || em->em_is_child)
+			continue;
+
+		sortop = get_opfamily_member(pathkey->pk_opfamily,
+									 em->em_datatype,
+									 em->em_datatype,
+									 pathkey->pk_strategy);
+		if (OidIsValid(sortop) &&
+			get_sort_range_bounds(root, (Node *) em->em_expr, sortop, 1) != NIL)
+			return true;
+	}
+
+	return false;
+}
+
 
 /*
  * make_group_input_target
@@ -6452,6 +6561,45 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 										 agg_costs,
 										 dNumGroups));
 			}
+
+			/*
+			 * Consider a Parallel HashAgg over the cheapest partial input
+			 * path, in which each participant fully aggregates a subset of
+			 * the groups.  gather_grouping_paths will put a Gather on top.
+			 */
+			if (enable_parallel_hashagg && grouped_rel->consider_parallel &&
+				input_rel->partial_pathlist != NIL)
+			{
+				Path	   *partial_path = linitial(input_rel->partial_pathlist);
+				double		parallel_divisor;
+				double		dNumPartialGroups;
+				AggPath    *aggpath;
+
+				/* the input is split up among participants, and so are groups */
+				parallel_divisor = Max(cheapest_path->rows /
+									   clamp_row_est(partial_path->rows), 1.0);
+				dNumPartialGroups = clamp_row_est(dNumGroups / parallel_divisor);
+
+				hashaggtablesize = estimate_hashagg_tablesize(partial_path,
+															  agg_costs,
+															  dNumPartialGroups);
+
+				if (hashaggtablesize < work_mem * 1024L)
+				{
+					aggpath = create_agg_path(root, grouped_rel,
+											  partial_path,
+											  grouped_rel->reltarget,
+											  AGG_HASHED,
+											  AGGSPLIT_SIMPLE,
+											  parse->groupClause,
+											  havingQual,
+											  agg_costs,
+											  dNumPartialGroups);
+					aggpath->path.parallel_aware = true;
+					cost_parallel_hashagg(&aggpath->path, partial_path);
+					add_partial_path(grouped_rel, (Path *) aggpath);
+				}
+			}
 		}
 
 		/*
@@ -19,7 +19,9 @@
 
 #include "postgres.h"
 
+#include "access/genam.h"
 #include "access/htup_details.h"
+#include "access/table.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_class.h"
 #include "catalog/pg_language.h"
@@ -42,6 +44,7 @@
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
 #include "parser/parse_func.h"
+#include "parser/parsetree.h"
 #include "rewrite/rewriteManip.h"
 #include "tcop/tcopprot.h"
 #include "utils/acl.h"
@@ -50,6 +53,7 @@
 #include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
 #include "utils/syscache.h"
 #include "utils/typcache.h"
 
@@ -105,12 +109,19 @@ static bool contain_subplans_walker(Node *node, void *context);
 static bool contain_mutable_functions_walker(Node *node, void *context);
 static bool contain_volatile_functions_walker(Node *node, void *context);
 static bool contain_volatile_functions_not_nextval_walker(Node *node, void *context);
+static bool max_parallel_hazard_test(char proparallel,
+						 max_parallel_hazard_context *context);
 static bool max_parallel_hazard_walker(Node *node,
 						   max_parallel_hazard_context *context);
+static bool target_rel_max_parallel_hazard(Query *parse,
+							   max_parallel_hazard_context *context);
+static bool rel_max_parallel_hazard(Relation rel, LOCKMODE lockmode,
+						max_parallel_hazard_context *context);
 static bool contain_nonstrict_functions_walker(Node *node, void *context);
 static bool contain_context_dependent_node(Node *clause);
 static bool contain_context_dependent_node_walker(Node *node, int *flags);
 static bool contain_leaked_vars_walker(Node *node, void *context);
+static bool pull_paramids_walker(Node *node, Bitmapset **context);
 static Relids find_nonnullable_rels_walker(Node *node, bool top_level);
 static List *find_nonnullable_vars_walker(Node *node, bool top_level);
 static bool is_strict_saop(ScalarArrayOpExpr *expr, bool falseOK);
@@ -830,6 +841,9 @@ contain_volatile_functions_not_nextval_walker(Node *node, void *context)
  * can be parallelized at all.  The caller will also save the result in
  * PlannerGlobal so as to short-circuit checks of portions of the querytree
  * later, in the common case where everything is SAFE.
+ *
+ * For an INSERT, the target table is checked too, since the leader will be
+ * inserting rows into it while in parallel mode.
  */
 char
 max_parallel_hazard(Query *parse)
@@ -839,10 +853,111 @@ max_parallel_hazard(Query *parse)
 	context.max_hazard = PROPARALLEL_SAFE;
 	context.max_interesting = PROPARALLEL_UNSAFE;
 	context.safe_param_ids = NIL;
-	(void) max_parallel_hazard_walker((Node *) parse, &context);
+	if (!max_parallel_hazard_walker((Node *) parse, &context) &&
+		parse->commandType == CMD_INSERT)
+		(void) target_rel_max_parallel_hazard(parse, &context);
+	return context.max_hazard;
+}
+
+/*
+ * target_rel_max_parallel_hazard
+ *		Check the target table of an INSERT for anything the leader can't
+ *		do in parallel mode
+ *
+ * The rows to insert may be computed by parallel workers, but the inserts
+ * themselves are done by the leader, which then also evaluates the table's
+ * CHECK constraints and index expressions and predicates.  Triggers
+ * (including foreign key checks), ON CONFLICT, tuple routing and foreign
+ * tables are not analyzed here, and just make the INSERT unsafe.
+ */
+static bool
+target_rel_max_parallel_hazard(Query *parse,
+							   max_parallel_hazard_context *context)
+{
+	RangeTblEntry *rte = rt_fetch(parse->resultRelation, parse->rtable);
+	Relation	rel;
+	bool		result;
+
+	if (parse->onConflict != NULL || rte->relkind != RELKIND_RELATION)
+		return max_parallel_hazard_test(PROPARALLEL_UNSAFE, context);
+
+	/* the parser already locked the table */
+	rel = table_open(rte->relid, NoLock);
+	result = rel_max_parallel_hazard(rel, rte->rellockmode, context);
+	table_close(rel, NoLock);
+
+	return result;
+}
+
+/*
+ * max_parallel_hazard_for_insert
+ *		Find the worst parallel-hazard level of inserting rows into a plain
+ *		table, evaluating the given expressions for each of them
+ *
+ * This is for callers outside the planner, such as COPY FROM, that insert
+ * into rel from parallel workers.  The caller must hold a lock on rel.
+ */
+char
+max_parallel_hazard_for_insert(Relation rel, Node *exprs)
+{
+	max_parallel_hazard_context context;
+
+	context.max_hazard = PROPARALLEL_SAFE;
+	context.max_interesting = PROPARALLEL_UNSAFE;
+	context.safe_param_ids = NIL;
+	if (!max_parallel_hazard_walker(exprs, &context))
+		(void) rel_max_parallel_hazard(rel, RowExclusiveLock, &context);
 	return context.max_hazard;
 }
 
+/*
+ * Workhorse for target_rel_max_parallel_hazard and
+ * max_parallel_hazard_for_insert: check the triggers, CHECK constraints and
+ * index expressions and predicates of rel.  Indexes are opened with lockmode.
+ */
+static bool
+rel_max_parallel_hazard(Relation rel, LOCKMODE lockmode,
+						max_parallel_hazard_context *context)
+{
+	TupleConstr *constr;
+	bool		result;
+
+	result = (rel->trigdesc != NULL &&
+			  max_parallel_hazard_test(PROPARALLEL_UNSAFE, context));
+
+	constr = RelationGetDescr(rel)->constr;
+	if (!result && constr != NULL)
+	{
+		int			i;
+
+		for (i = 0; i < constr->num_check && !result; i++)
+			result = max_parallel_hazard_walker(stringToNode(constr->check[i].ccbin),
+												context);
+	}
+
+	if (!result && rel->rd_rel->relhasindex)
+	{
+		List	   *indexoidlist = RelationGetIndexList(rel);
+		ListCell   *lc;
+
+		foreach(lc, indexoidlist)
+		{
+			Relation	indexRel = index_open(lfirst_oid(lc), lockmode);
+
+			result = max_parallel_hazard_walker((Node *) RelationGetIndexExpressions(indexRel),
+												context) ||
+				max_parallel_hazard_walker((Node *) RelationGetIndexPredicate(indexRel),
+										   context);
+			index_close(indexRel, NoLock);
+			if (result)
+				break;
+		}
+		list_free(indexoidlist);
+	}
+
+	return result;
+}
+
 /*
  * is_parallel_safe
  *		Detect whether the given expr contains only parallel-safe functions
@@ -2172,6 +2287,36 @@ CommuteOpExpr(OpExpr *clause)
 	lsecond(clause->args) = temp;
 }
 
+/*
+ * pull_paramids
+ *		Returns a Bitmapset containing the paramids of all Params in 'expr'.
+ */
+Bitmapset *
+pull_paramids(Expr *expr)
+{
+	Bitmapset  *result = NULL;
+
+	(void) pull_paramids_walker((Node *) expr, &result);
+
+	return result;
+}
+
+static bool
+pull_paramids_walker(Node *node, Bitmapset **context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+	{
+		Param	   *param = (Param *) node;
+
+		*context = bms_add_member(*context, param->paramid);
+		return false;
+	}
+	return expression_tree_walker(node, pull_paramids_walker,
+								  (void *) context);
+}
+
 /*
  * Helper for eval_const_expressions: check that datatype of an attribute
  * is still what it was when the expression was parsed.  This is needed to
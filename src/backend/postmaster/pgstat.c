@@ -221,6 +221,8 @@ static int	pgStatXactCommit = 0;
 static int	pgStatXactRollback = 0;
 PgStat_Counter pgStatBlockReadTime = 0;
 PgStat_Counter pgStatBlockWriteTime = 0;
+PgStat_Counter pgStatTempUncompressedBytes = 0;
+PgStat_Counter pgStatTempCompressedBytes = 0;
 
 /* Record that's written to 2PC state file when pgstat state is persisted */
 typedef struct TwoPhasePgStatRecord
@@ -303,6 +305,7 @@ static bool pgstat_db_requested(Oid databaseid);
 
 static void pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg);
 static void pgstat_send_funcstats(void);
+static void pgstat_send_tempcompression(void);
 static HTAB *pgstat_collect_oids(Oid catalogid, AttrNumber anum_oid);
 
 static PgStat_TableStatus *get_tabstat_entry(Oid rel_id, bool isshared);
@@ -335,6 +338,7 @@ static void pgstat_recv_funcpurge(PgStat_MsgFuncpurge *msg, int len);
 static void pgstat_recv_recoveryconflict(PgStat_MsgRecoveryConflict *msg, int len);
 static void pgstat_recv_deadlock(PgStat_MsgDeadlock *msg, int len);
 static void pgstat_recv_tempfile(PgStat_MsgTempFile *msg, int len);
+static void pgstat_recv_tempcompression(PgStat_MsgTempCompression *msg, int len);
 
 /* ------------------------------------------------------------
  * Public functions called from postmaster follow
@@ -823,7 +827,7 @@ pgstat_report_stat(bool force)
 	/* Don't expend a clock check if nothing to do */
 	if ((pgStatTabList == NULL || pgStatTabList->tsa_used == 0) &&
 		pgStatXactCommit == 0 && pgStatXactRollback == 0 &&
-		!have_function_stats)
+		!have_function_stats && pgStatTempUncompressedBytes == 0)
 		return;
 
 	/*
@@ -909,6 +913,9 @@ pgstat_report_stat(bool force)
 
 	/* Now, send function statistics */
 	pgstat_send_funcstats();
+
+	/* And the temp file compression counts */
+	pgstat_send_tempcompression();
 }
 
 /*
@@ -1010,6 +1017,31 @@ pgstat_send_funcstats(void)
 	have_function_stats = false;
 }
 
+/*
+ * Subroutine for pgstat_report_stat: send the temp file compression counts
+ * accumulated since the last report, if any
+ */
+static void
+pgstat_send_tempcompression(void)
+{
+	PgStat_MsgTempCompression msg;
+
+	if (pgStatTempUncompressedBytes == 0)
+		return;
+
+	if (pgStatSock != PGINVALID_SOCKET && pgstat_track_counts)
+	{
+		pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TEMPCOMPRESSION);
+		msg.m_databaseid = MyDatabaseId;
+		msg.m_uncompressed = pgStatTempUncompressedBytes;
+		msg.m_compressed = pgStatTempCompressedBytes;
+		pgstat_send(&msg, sizeof(msg));
+	}
+
+	pgStatTempUncompressedBytes = 0;
+	pgStatTempCompressedBytes = 0;
+}
+
 
 /* ----------
  * pgstat_vacuum_stat() -
@@ -3578,6 +3610,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 
 	switch (w)
 	{
+		case WAIT_EVENT_APPEND_READY:
+			event_name = "AppendReady";
+			break;
 		case WAIT_EVENT_BGWORKER_SHUTDOWN:
 			event_name = "BgWorkerShutdown";
 			break;
@@ -3593,6 +3628,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_EXECUTE_GATHER:
 			event_name = "ExecuteGather";
 			break;
+		case WAIT_EVENT_HASH_AGG_PARTITIONING:
+			event_name = "HashAgg/Partitioning";
+			break;
 		case WAIT_EVENT_HASH_BATCH_ALLOCATING:
 			event_name = "Hash/Batch/Allocating";
 			break;
@@ -3665,6 +3703,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PARALLEL_FINISH:
 			event_name = "ParallelFinish";
 			break;
+		case WAIT_EVENT_PARALLEL_SORT_RUNS:
+			event_name = "ParallelSortRuns";
+			break;
 		case WAIT_EVENT_PROCARRAY_GROUP_UPDATE:
 			event_name = "ProcArrayGroupUpdate";
 			break;
@@ -4455,6 +4496,11 @@ PgstatCollectorMain(int argc, char *argv[])
 					pgstat_recv_tempfile((PgStat_MsgTempFile *) &msg, len);
 					break;
 
+				case PGSTAT_MTYPE_TEMPCOMPRESSION:
+					pgstat_recv_tempcompression((PgStat_MsgTempCompression *) &msg,
+												len);
+					break;
+
 				default:
 					break;
 			}
@@ -4553,6 +4599,8 @@ reset_dbentry_counters(PgStat_StatDBEntry *dbentry)
 	dbentry->n_conflict_startup_deadlock = 0;
 	dbentry->n_temp_files = 0;
 	dbentry->n_temp_bytes = 0;
+	dbentry->n_temp_uncompressed_bytes = 0;
+	dbentry->n_temp_compressed_bytes = 0;
 	dbentry->n_deadlocks = 0;
 	dbentry->n_block_read_time = 0;
 	dbentry->n_block_write_time = 0;
@@ -6213,6 +6261,23 @@ pgstat_recv_tempfile(PgStat_MsgTempFile *msg, int len)
 	dbentry->n_temp_files += 1;
 }
 
+/* ----------
+ * pgstat_recv_tempcompression() -
+ *
+ *	Process a TEMPCOMPRESSION message.
+ * ----------
+ */
+static void
+pgstat_recv_tempcompression(PgStat_MsgTempCompression *msg, int len)
+{
+	PgStat_StatDBEntry *dbentry;
+
+	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
+
+	dbentry->n_temp_uncompressed_bytes += msg->m_uncompressed;
+	dbentry->n_temp_compressed_bytes += msg->m_compressed;
+}
+
 /* ----------
  * pgstat_recv_funcstat() -
  *
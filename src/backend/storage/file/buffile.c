@@ -36,17 +36,25 @@
  * other backends, as infrastructure for parallel execution.  Such files need
  * to be created as a member of a SharedFileSet that all participants are
  * attached to.
+ *
+ * Private BufFiles can optionally be compressed, to trade CPU time for
+ * temporary file I/O and space.  Each buffer load is compressed separately
+ * and appended to the underlying files, so compressed files can be read and
+ * positioned freely, but their contents can only be rewritten a whole block
+ * at a time.  See BufFileCreateCompressTemp().
  *-------------------------------------------------------------------------
  */
 
 #include "postgres.h"
 
+#include "common/pg_lzcompress.h"
 #include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/fd.h"
 #include "storage/buffile.h"
 #include "storage/buf_internals.h"
+#include "utils/guc.h"
 #include "utils/resowner.h"
 
 /*
@@ -57,6 +65,17 @@
 #define MAX_PHYSICAL_FILESIZE	0x40000000
 #define BUFFILE_SEG_SIZE		(MAX_PHYSICAL_FILESIZE / BLCKSZ)
 
+/*
+ * In a compressed BufFile, each block is stored as a header followed by the
+ * compressed data, or the raw data if it didn't compress well.  Records never
+ * cross segment boundaries.
+ */
+typedef struct BufFileCompressedHeader
+{
+	int32		rawlen;			/* # of bytes of logical data in the block */
+	int32		len;			/* # of bytes stored; rawlen if uncompressed */
+} BufFileCompressedHeader;
+
 /*
  * This data structure represents a buffered file that consists of one or
  * more physical files (each accessed through a virtual file descriptor
@@ -90,6 +109,24 @@ struct BufFile
 	off_t		curOffset;		/* offset part of current pos */
 	int			pos;			/* next read/write position in buffer */
 	int			nbytes;			/* total # of valid bytes in buffer */
+
+	/*
+	 * In a compressed file, the buffer always starts at a block boundary of
+	 * the logical file, and blockMap gives the physical position of each
+	 * logical block's record, as segment number * MAX_PHYSICAL_FILESIZE +
+	 * offset.  Only the last block can be partially filled.  Records are
+	 * appended at (physFile, physOffset); a rewritten block simply gets a new
+	 * record.
+	 */
+	bool		compressed;		/* is this a compressed file? */
+	int			physFile;		/* segment to append the next record to */
+	off_t		physOffset;		/* offset to append the next record at */
+	int64	   *blockMap;		/* palloc'd array with mapSize entries */
+	long		mapSize;		/* allocated length of blockMap */
+	long		numBlocks;		/* # of logical blocks written */
+	int			lastBlockBytes; /* # of bytes in the last logical block */
+	char	   *cbuffer;		/* palloc'd scratch space for a record */
+
 	PGAlignedBlock buffer;
 };
 
@@ -97,7 +134,10 @@ static BufFile *makeBufFileCommon(int nfiles);
 static BufFile *makeBufFile(File firstfile);
 static void extendBufFile(BufFile *file);
 static void BufFileLoadBuffer(BufFile *file);
+static void BufFileLoadBufferCompressed(BufFile *file);
 static void BufFileDumpBuffer(BufFile *file);
+static void BufFileDumpBufferCompressed(BufFile *file);
+static int64 BufFileCompressedSize(BufFile *file);
 static int	BufFileFlush(BufFile *file);
 static File MakeNewSharedSegment(BufFile *file, int segment);
 
@@ -117,6 +157,9 @@ makeBufFileCommon(int nfiles)
 	file->curOffset = 0L;
 	file->pos = 0;
 	file->nbytes = 0;
+	file->compressed = false;
+	file->blockMap = NULL;
+	file->cbuffer = NULL;
 
 	return file;
 }
@@ -194,6 +237,38 @@ BufFileCreateTemp(bool interXact)
 	return file;
 }
 
+/*
+ * Create a BufFile for a new temporary file, like BufFileCreateTemp(), whose
+ * contents are compressed if temp_file_compression is enabled.
+ *
+ * Compressed files support the same operations as plain ones, but any write
+ * that doesn't go past the end of the file must replace whole blocks, or be
+ * preceded by a seek or a read that loads the block to be modified.  Each
+ * rewritten block also takes more disk space, so this is best suited for
+ * files that are written sequentially and then read back, like hash join
+ * batches and hash aggregation spill files.
+ */
+BufFile *
+BufFileCreateCompressTemp(bool interXact)
+{
+	BufFile    *file = BufFileCreateTemp(interXact);
+
+	if (temp_file_compression)
+	{
+		file->compressed = true;
+		file->physFile = 0;
+		file->physOffset = 0L;
+		file->mapSize = 16;
+		file->blockMap = (int64 *) palloc(file->mapSize * sizeof(int64));
+		file->numBlocks = 0;
+		file->lastBlockBytes = 0;
+		file->cbuffer = palloc(sizeof(BufFileCompressedHeader) +
+							   PGLZ_MAX_OUTPUT(BLCKSZ));
+	}
+
+	return file;
+}
+
 /*
  * Build the name for a given segment of a given BufFile.
  */
@@ -385,6 +460,11 @@ BufFileClose(BufFile *file)
 	/* close and delete the underlying file(s) */
 	for (i = 0; i < file->numFiles; i++)
 		FileClose(file->files[i]);
+	if (file->compressed)
+	{
+		pfree(file->blockMap);
+		pfree(file->cbuffer);
+	}
 	/* release the buffer space */
 	pfree(file->files);
 	pfree(file);
@@ -402,6 +482,12 @@ BufFileLoadBuffer(BufFile *file)
 {
 	File		thisfile;
 
+	if (file->compressed)
+	{
+		BufFileLoadBufferCompressed(file);
+		return;
+	}
+
 	/*
 	 * Advance to next component file if necessary and possible.
 	 */
@@ -429,6 +515,78 @@ BufFileLoadBuffer(BufFile *file)
 		pgBufferUsage.temp_blks_read++;
 }
 
+/*
+ * BufFileLoadBufferCompressed
+ *
+ * BufFileLoadBuffer for compressed files.  The buffer is loaded with the
+ * whole block containing curOffset, which is moved back to the start of the
+ * block, and pos is set to keep the logical position unchanged.
+ */
+static void
+BufFileLoadBufferCompressed(BufFile *file)
+{
+	BufFileCompressedHeader hdr;
+	long		blknum;
+	int			skip;
+	int64		physpos;
+	File		thisfile;
+	off_t		offset;
+
+	if (file->curOffset >= MAX_PHYSICAL_FILESIZE)
+	{
+		file->curFile++;
+		file->curOffset -= MAX_PHYSICAL_FILESIZE;
+	}
+
+	blknum = (long) file->curFile * BUFFILE_SEG_SIZE +
+		(long) (file->curOffset / BLCKSZ);
+	if (blknum >= file->numBlocks)
+		return;					/* at EOF */
+
+	skip = (int) (file->curOffset % BLCKSZ);
+
+	physpos = file->blockMap[blknum];
+	thisfile = file->files[physpos / MAX_PHYSICAL_FILESIZE];
+	offset = (off_t) (physpos % MAX_PHYSICAL_FILESIZE);
+
+	if (FileRead(thisfile, (char *) &hdr, sizeof(hdr), offset,
+				 WAIT_EVENT_BUFFILE_READ) != sizeof(hdr))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file \"%s\": %m",
+						FilePathName(thisfile))));
+	offset += sizeof(hdr);
+
+	if (hdr.rawlen <= 0 || hdr.rawlen > BLCKSZ ||
+		hdr.len <= 0 || hdr.len > hdr.rawlen || hdr.rawlen < skip)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("invalid compressed block header in temporary file \"%s\"",
+								 FilePathName(thisfile))));
+
+	/* Blocks that didn't compress are stored as is */
+	if (FileRead(thisfile,
+				 hdr.len == hdr.rawlen ? file->buffer.data : file->cbuffer,
+				 hdr.len, offset, WAIT_EVENT_BUFFILE_READ) != hdr.len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file \"%s\": %m",
+						FilePathName(thisfile))));
+
+	if (hdr.len < hdr.rawlen &&
+		pglz_decompress(file->cbuffer, hdr.len, file->buffer.data,
+						hdr.rawlen) != hdr.rawlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed data is corrupted")));
+
+	file->curOffset -= skip;
+	file->pos = skip;
+	file->nbytes = hdr.rawlen;
+
+	pgBufferUsage.temp_blks_read++;
+}
+
 /*
  * BufFileDumpBuffer
  *
@@ -443,6 +601,12 @@ BufFileDumpBuffer(BufFile *file)
 	int			bytestowrite;
 	File		thisfile;
 
+	if (file->compressed)
+	{
+		BufFileDumpBufferCompressed(file);
+		return;
+	}
+
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
 	 * crosses a component-file boundary; so we need a loop.
@@ -507,6 +671,108 @@ BufFileDumpBuffer(BufFile *file)
 	file->nbytes = 0;
 }
 
+/*
+ * BufFileDumpBufferCompressed
+ *
+ * BufFileDumpBuffer for compressed files.  The buffer holds the start of the
+ * block at curOffset, and is compressed and appended to the physical files
+ * as a new version of that block.  On exit, dirty is cleared if successful
+ * write.  If pos is at the end of the block the buffer is set empty and
+ * curOffset advanced to the next block, otherwise the buffer is left as is,
+ * so that the caller can keep reading or writing the same block.
+ */
+static void
+BufFileDumpBufferCompressed(BufFile *file)
+{
+	BufFileCompressedHeader *hdr = (BufFileCompressedHeader *) file->cbuffer;
+	char	   *data = file->cbuffer + sizeof(BufFileCompressedHeader);
+	long		blknum;
+	int32		len;
+	int			bytestowrite;
+	File		thisfile;
+
+	Assert(file->curOffset % BLCKSZ == 0);
+
+	blknum = (long) file->curFile * BUFFILE_SEG_SIZE +
+		(long) (file->curOffset / BLCKSZ);
+
+	/*
+	 * The new version of the block must include all of the old one's
+	 * contents, since we don't merge them.  That's always true when the
+	 * buffer was loaded from the block, and when the file is written
+	 * sequentially.
+	 */
+	if (blknum > file->numBlocks ||
+		(blknum < file->numBlocks - 1 && file->nbytes < BLCKSZ) ||
+		(blknum == file->numBlocks - 1 && file->nbytes < file->lastBlockBytes))
+		elog(ERROR, "cannot partially overwrite a block of a compressed temporary file");
+
+	len = pglz_compress(file->buffer.data, file->nbytes, data,
+						PGLZ_strategy_default);
+	if (len < 0)
+	{
+		/* Didn't compress well enough, store as is */
+		memcpy(data, file->buffer.data, file->nbytes);
+		len = file->nbytes;
+	}
+	hdr->rawlen = file->nbytes;
+	hdr->len = len;
+	bytestowrite = sizeof(BufFileCompressedHeader) + len;
+
+	/* Advance to next component file if the record doesn't fit */
+	if (file->physOffset + bytestowrite > MAX_PHYSICAL_FILESIZE)
+	{
+		while (file->physFile + 1 >= file->numFiles)
+			extendBufFile(file);
+		file->physFile++;
+		file->physOffset = 0L;
+	}
+
+	thisfile = file->files[file->physFile];
+	if (FileWrite(thisfile, file->cbuffer, bytestowrite, file->physOffset,
+				  WAIT_EVENT_BUFFILE_WRITE) != bytestowrite)
+		return;					/* failed to write */
+
+	if (blknum >= file->mapSize)
+	{
+		file->mapSize *= 2;
+		file->blockMap = (int64 *) repalloc(file->blockMap,
+											file->mapSize * sizeof(int64));
+	}
+	file->blockMap[blknum] =
+		(int64) file->physFile * MAX_PHYSICAL_FILESIZE + file->physOffset;
+	if (blknum == file->numBlocks)
+		file->numBlocks++;
+	if (blknum == file->numBlocks - 1)
+		file->lastBlockBytes = file->nbytes;
+	file->physOffset += bytestowrite;
+
+	pgBufferUsage.temp_blks_written++;
+	pgBufferUsage.temp_uncompressed_bytes += file->nbytes;
+	pgBufferUsage.temp_compressed_bytes += bytestowrite;
+	pgstat_count_tempfile_compression(file->nbytes, bytestowrite);
+
+	file->dirty = false;
+
+	if (file->pos >= BLCKSZ)
+	{
+		file->curOffset += BLCKSZ;
+		file->pos = 0;
+		file->nbytes = 0;
+	}
+}
+
+/*
+ * Return the logical size of a compressed file, excluding any dirty buffer.
+ */
+static int64
+BufFileCompressedSize(BufFile *file)
+{
+	if (file->numBlocks == 0)
+		return 0;
+	return (int64) (file->numBlocks - 1) * BLCKSZ + file->lastBlockBytes;
+}
+
 /*
  * BufFileRead
  *
@@ -534,7 +800,7 @@ BufFileRead(BufFile *file, void *ptr, size_t size)
 			file->pos = 0;
 			file->nbytes = 0;
 			BufFileLoadBuffer(file);
-			if (file->nbytes <= 0)
+			if (file->pos >= file->nbytes)
 				break;			/* no more data available */
 		}
 
@@ -587,6 +853,13 @@ BufFileWrite(BufFile *file, void *ptr, size_t size)
 			}
 		}
 
+		/*
+		 * A compressed block can't be partially overwritten, so load any
+		 * existing contents of the block before starting to modify it.
+		 */
+		if (file->compressed && file->nbytes == 0 && !file->dirty)
+			BufFileLoadBuffer(file);
+
 		nthistime = BLCKSZ - file->pos;
 		if (nthistime > size)
 			nthistime = size;
@@ -690,6 +963,23 @@ BufFileSeek(BufFile *file, int fileno, off_t offset, int whence)
 	if (BufFileFlush(file) != 0)
 		return EOF;
 
+	/*
+	 * Compressed files have no holes, and their segments don't correspond to
+	 * the physical ones, so just check against the logical size.
+	 */
+	if (file->compressed)
+	{
+		int64		target = (int64) newFile * MAX_PHYSICAL_FILESIZE + newOffset;
+
+		if (target > BufFileCompressedSize(file))
+			return EOF;
+		file->curFile = (int) (target / MAX_PHYSICAL_FILESIZE);
+		file->curOffset = (off_t) (target % MAX_PHYSICAL_FILESIZE);
+		file->pos = 0;
+		file->nbytes = 0;
+		return 0;
+	}
+
 	/*
 	 * At this point and no sooner, check for seek past last segment. The
 	 * above flush could have created a new segment, so checking sooner would
@@ -745,6 +1035,38 @@ BufFileSeekBlock(BufFile *file, long blknum)
 					   SEEK_SET);
 }
 
+/*
+ * BufFilePrefetchBlocks --- initiate asynchronous read of blocks
+ *
+ * Hints that nblocks BLCKSZ-sized blocks starting at blknum, numbered as for
+ * BufFileSeekBlock(), will be read soon.  This doesn't move the logical
+ * position, and does nothing on platforms without prefetch support.  Blocks
+ * beyond the end of the file are ignored.
+ */
+void
+BufFilePrefetchBlocks(BufFile *file, long blknum, int nblocks)
+{
+	/* Block numbers don't map to physical positions in compressed files */
+	if (file->compressed)
+		return;
+
+	while (nblocks > 0)
+	{
+		int			fileno = (int) (blknum / BUFFILE_SEG_SIZE);
+		long		segblock = blknum % BUFFILE_SEG_SIZE;
+		int			n = (int) Min((long) nblocks, BUFFILE_SEG_SIZE - segblock);
+
+		if (fileno >= file->numFiles)
+			break;
+
+		(void) FilePrefetch(file->files[fileno], (off_t) segblock * BLCKSZ,
+							n * BLCKSZ, WAIT_EVENT_BUFFILE_READ);
+
+		blknum += n;
+		nblocks -= n;
+	}
+}
+
 #ifdef NOT_USED
 /*
  * BufFileTellBlock --- block-oriented tell
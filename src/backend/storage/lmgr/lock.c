@@ -170,6 +170,20 @@ typedef struct TwoPhaseLockRecord
  */
 static int	FastPathLocalUseCount = 0;
 
+/*
+ * Flags to indicate if the relation extension lock or a page lock is held by
+ * this backend.  They are used to check that while holding the relation
+ * extension lock we don't try to acquire a heavyweight lock on any other
+ * object, and that while holding a page lock we only go on to acquire the
+ * relation extension lock.  That's what lets these locks conflict within a
+ * lock group without the risk of an undetected deadlock; see
+ * LOCK_CONFLICTS_IN_GROUP.
+ */
+#ifdef USE_ASSERT_CHECKING
+static bool IsRelationExtensionLockHeld = false;
+static bool IsPageLockHeld = false;
+#endif
+
 /* Macros for manipulating proc->fpLockBits */
 #define FAST_PATH_BITS_PER_SLOT			3
 #define FAST_PATH_LOCKNUMBER_OFFSET		1
@@ -341,6 +355,7 @@ PROCLOCK_PRINT(const char *where, const PROCLOCK *proclockP)
 
 static uint32 proclock_hash(const void *key, Size keysize);
 static void RemoveLocalLock(LOCALLOCK *locallock);
+static inline void CheckAndSetLockHeld(LOCALLOCK *locallock, bool acquired);
 static PROCLOCK *SetupLockInTable(LockMethod lockMethodTable, PGPROC *proc,
 				 const LOCKTAG *locktag, uint32 hashcode, LOCKMODE lockmode);
 static void GrantLockLocal(LOCALLOCK *locallock, ResourceOwner owner);
@@ -840,6 +855,20 @@ LockAcquireExtended(const LOCKTAG *locktag,
 			return LOCKACQUIRE_ALREADY_HELD;
 	}
 
+	/*
+	 * We don't acquire any other heavyweight lock while holding the relation
+	 * extension lock.  Acquiring the same relation extension lock again is
+	 * allowed, but that case doesn't reach here.
+	 */
+	Assert(!IsRelationExtensionLockHeld);
+
+	/*
+	 * We don't acquire any other heavyweight lock while holding a page lock,
+	 * except for the relation extension lock.
+	 */
+	Assert(!IsPageLockHeld ||
+		   (locktag->locktag_type == LOCKTAG_RELATION_EXTEND));
+
 	/*
 	 * Prepare to emit a WAL record if acquisition of this lock needs to be
 	 * replayed in a standby server.
@@ -1289,6 +1318,21 @@ SetupLockInTable(LockMethod lockMethodTable, PGPROC *proc,
 	return proclock;
 }
 
+/*
+ * Check and set/reset the flag that we hold the relation extension lock or
+ * a page lock, for the sake of the assertions in LockAcquireExtended.
+ */
+static inline void
+CheckAndSetLockHeld(LOCALLOCK *locallock, bool acquired)
+{
+#ifdef USE_ASSERT_CHECKING
+	if (LOCALLOCK_LOCKTAG(*locallock) == LOCKTAG_RELATION_EXTEND)
+		IsRelationExtensionLockHeld = acquired;
+	else if (LOCALLOCK_LOCKTAG(*locallock) == LOCKTAG_PAGE)
+		IsPageLockHeld = acquired;
+#endif
+}
+
 /*
  * Subroutine to free a locallock entry
  */
@@ -1324,6 +1368,11 @@ RemoveLocalLock(LOCALLOCK *locallock)
 					 (void *) &(locallock->tag),
 					 HASH_REMOVE, NULL))
 		elog(WARNING, "locallock table corrupted");
+
+	/*
+	 * Indicate that the lock is released for certain types of locks
+	 */
+	CheckAndSetLockHeld(locallock, false);
 }
 
 /*
@@ -1337,8 +1386,9 @@ RemoveLocalLock(LOCALLOCK *locallock)
  * conflict with one another, no matter what purpose they are held for
  * (eg, session and transaction locks do not conflict).  Nor do the locks
  * of one process in a lock group conflict with those of another process in
- * the same group.  So, we must subtract off these locks when determining
- * whether the requested new lock conflicts with those already held.
+ * the same group, except for the lock types that LOCK_CONFLICTS_IN_GROUP
+ * accepts.  So, we must subtract off these locks when determining whether
+ * the requested new lock conflicts with those already held.
  */
 int
 LockCheckConflicts(LockMethod lockMethodTable,
@@ -1405,6 +1455,14 @@ LockCheckConflicts(LockMethod lockMethodTable,
 		return STATUS_FOUND;
 	}
 
+	/* Likewise if group members must conflict on this lock anyway. */
+	if (LOCK_CONFLICTS_IN_GROUP(*lock))
+	{
+		PROCLOCK_PRINT("LockCheckConflicts: conflicting (group)",
+					   proclock);
+		return STATUS_FOUND;
+	}
+
 	/*
 	 * Locks held in conflicting modes by members of our own lock group are
 	 * not real conflicts; we can subtract those out and see if we still have
@@ -1620,6 +1678,9 @@ GrantLockLocal(LOCALLOCK *locallock, ResourceOwner owner)
 	locallock->numLockOwners++;
 	if (owner != NULL)
 		ResourceOwnerRememberLock(owner, locallock);
+
+	/* Indicate that the lock is acquired for certain types of locks. */
+	CheckAndSetLockHeld(locallock, true);
 }
 
 /*
@@ -1078,9 +1078,9 @@ ProcSleep(LOCALLOCK *locallock, LockMethod lockMethodTable)
 
 	/*
 	 * If group locking is in use, locks held by members of my locking group
-	 * need to be included in myHeldLocks.
+	 * need to be included in myHeldLocks, unless they conflict with mine.
 	 */
-	if (leader != NULL)
+	if (leader != NULL && !LOCK_CONFLICTS_IN_GROUP(*lock))
 	{
 		SHM_QUEUE  *procLocks = &(lock->procLocks);
 		PROCLOCK   *otherproclock;
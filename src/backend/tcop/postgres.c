@@ -1324,6 +1324,7 @@ exec_parse_message(const char *query_string,	/* string to execute */
 	List	   *querytree_list;
 	CachedPlanSource *psrc;
 	bool		is_named;
+	bool		from_shared = false;
 	bool		save_log_statement_stats = log_statement_stats;
 	char		msec_str[32];
 
@@ -1434,49 +1435,64 @@ exec_parse_message(const char *query_string,	/* string to execute */
 		psrc = CreateCachedPlan(raw_parse_tree, query_string, commandTag);
 
 		/*
-		 * Set up a snapshot if parse analysis will need one.
+		 * If the shared plan cache is enabled, another session might have
+		 * analyzed the same statement already.  We only try that for named
+		 * statements, which are the ones worth keeping.
 		 */
-		if (analyze_requires_snapshot(raw_parse_tree))
+		if (is_named)
+			from_shared = CompleteCachedPlanFromShared(psrc,
+													   paramTypes,
+													   numParams,
+													   CURSOR_OPT_PARALLEL_OK,
+													   true);
+
+		if (!from_shared)
 		{
-			PushActiveSnapshot(GetTransactionSnapshot());
-			snapshot_set = true;
-		}
+			/*
+			 * Set up a snapshot if parse analysis will need one.
+			 */
+			if (analyze_requires_snapshot(raw_parse_tree))
+			{
+				PushActiveSnapshot(GetTransactionSnapshot());
+				snapshot_set = true;
+			}
 
-		/*
-		 * Analyze and rewrite the query.  Note that the originally specified
-		 * parameter set is not required to be complete, so we have to use
-		 * parse_analyze_varparams().
-		 */
-		if (log_parser_stats)
-			ResetUsage();
+			/*
+			 * Analyze and rewrite the query.  Note that the originally
+			 * specified parameter set is not required to be complete, so we
+			 * have to use parse_analyze_varparams().
+			 */
+			if (log_parser_stats)
+				ResetUsage();
 
-		query = parse_analyze_varparams(raw_parse_tree,
-										query_string,
-										&paramTypes,
-										&numParams);
+			query = parse_analyze_varparams(raw_parse_tree,
+											query_string,
+											&paramTypes,
+											&numParams);
 
-		/*
-		 * Check all parameter types got determined.
-		 */
-		for (int i = 0; i < numParams; i++)
-		{
-			Oid			ptype = paramTypes[i];
+			/*
+			 * Check all parameter types got determined.
+			 */
+			for (int i = 0; i < numParams; i++)
+			{
+				Oid			ptype = paramTypes[i];
 
-			if (ptype == InvalidOid || ptype == UNKNOWNOID)
-				ereport(ERROR,
-						(errcode(ERRCODE_INDETERMINATE_DATATYPE),
-						 errmsg("could not determine data type of parameter $%d",
-								i + 1)));
-		}
+				if (ptype == InvalidOid || ptype == UNKNOWNOID)
+					ereport(ERROR,
+							(errcode(ERRCODE_INDETERMINATE_DATATYPE),
+							 errmsg("could not determine data type of parameter $%d",
+									i + 1)));
+			}
 
-		if (log_parser_stats)
-			ShowUsage("PARSE ANALYSIS STATISTICS");
+			if (log_parser_stats)
+				ShowUsage("PARSE ANALYSIS STATISTICS");
 
-		querytree_list = pg_rewrite_query(query);
+			querytree_list = pg_rewrite_query(query);
 
-		/* Done with the snapshot used for parsing */
-		if (snapshot_set)
-			PopActiveSnapshot();
+			/* Done with the snapshot used for parsing */
+			if (snapshot_set)
+				PopActiveSnapshot();
+		}
 	}
 	else
 	{
@@ -1496,16 +1512,17 @@ exec_parse_message(const char *query_string,	/* string to execute */
 	if (unnamed_stmt_context)
 		MemoryContextSetParent(psrc->context, MessageContext);
 
-	/* Finish filling in the CachedPlanSource */
-	CompleteCachedPlan(psrc,
-					   querytree_list,
-					   unnamed_stmt_context,
-					   paramTypes,
-					   numParams,
-					   NULL,
-					   NULL,
-					   CURSOR_OPT_PARALLEL_OK,	/* allow parallel mode */
-					   true);	/* fixed result */
+	/* Finish filling in the CachedPlanSource, unless that's been done */
+	if (!from_shared)
+		CompleteCachedPlan(psrc,
+						   querytree_list,
+						   unnamed_stmt_context,
+						   paramTypes,
+						   numParams,
+						   NULL,
+						   NULL,
+						   CURSOR_OPT_PARALLEL_OK,	/* allow parallel mode */
+						   true);	/* fixed result */
 
 	/* If we got a cancel signal during analysis, quit */
 	CHECK_FOR_INTERRUPTS();
@@ -3466,6 +3466,93 @@ estimate_hashagg_tablesize(Path *path, const AggClauseCosts *agg_costs,
 	return hashentrysize * dNumGroups;
 }
 
+/*
+ * get_sort_range_bounds
+ *	  choose values of the given expression that split its distribution
+ *	  into ranges of roughly equal size, for range-partitioning a sort.
+ *
+ * At most nbounds values are returned, as a list of Consts of the
+ * expression's type.  They are taken from the histogram if there is one, and
+ * otherwise from the most-common-values list.  The list is not necessarily
+ * ordered according to sortop; the caller must sort it if that matters.
+ * Returns NIL if there are no usable statistics.
+ */
+List *
+get_sort_range_bounds(PlannerInfo *root, Node *expr, Oid sortop, int nbounds)
+{
+	VariableStatData vardata;
+	AttStatsSlot sslot;
+	List	   *result = NIL;
+	int16		typLen;
+	bool		typByVal;
+	Oid			collation = exprCollation(expr);
+
+	if (nbounds <= 0)
+		return NIL;
+
+	examine_variable(root, expr, 0, &vardata);
+
+	/*
+	 * The values will be compared using sortop at execution time, so apply
+	 * the same security check as if we were going to do so here.  Also, the
+	 * stats must be for exactly the expression's type.
+	 */
+	if (!HeapTupleIsValid(vardata.statsTuple) ||
+		vardata.atttype != vardata.vartype ||
+		!statistic_proc_security_check(&vardata, get_opcode(sortop)))
+	{
+		ReleaseVariableStats(vardata);
+		return NIL;
+	}
+
+	get_typlenbyval(vardata.atttype, &typLen, &typByVal);
+
+	if (get_attstatsslot(&sslot, vardata.statsTuple,
+						 STATISTIC_KIND_HISTOGRAM, InvalidOid,
+						 ATTSTATSSLOT_VALUES))
+	{
+		int			prev = 0;
+		int			i;
+
+		/* use evenly spaced interior histogram entries */
+		for (i = 1; i <= nbounds && sslot.nvalues > 2; i++)
+		{
+			int			idx = (int) ((int64) i * (sslot.nvalues - 1) / (nbounds + 1));
+
+			if (idx <= prev || idx >= sslot.nvalues - 1)
+				continue;
+			result = lappend(result,
+							 makeConst(vardata.atttype, vardata.atttypmod,
+									   collation, typLen,
+									   datumCopy(sslot.values[idx],
+												 typByVal, typLen),
+									   false, typByVal));
+			prev = idx;
+		}
+		free_attstatsslot(&sslot);
+	}
+	else if (get_attstatsslot(&sslot, vardata.statsTuple,
+							  STATISTIC_KIND_MCV, InvalidOid,
+							  ATTSTATSSLOT_VALUES))
+	{
+		int			i;
+
+		/* no histogram, so split at the most common values instead */
+		for (i = 0; i < sslot.nvalues && i < nbounds; i++)
+			result = lappend(result,
+							 makeConst(vardata.atttype, vardata.atttypmod,
+									   collation, typLen,
+									   datumCopy(sslot.values[i],
+												 typByVal, typLen),
+									   false, typByVal));
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseVariableStats(vardata);
+
+	return result;
+}
+
 
 /*-------------------------------------------------------------------------
  *
@@ -43,6 +43,12 @@
  * bare-bones; it's the caller's responsibility to build a new expression
  * if the old one gets invalidated.
  *
+ * If shared_plan_cache_size is set, saved CachedPlanSources for ordinary
+ * DML can also take their analyzed query and generic plan from other
+ * backends, through sharedplancache.c; see CompleteCachedPlanFromShared and
+ * GetCachedPlan.  That module learns about invalidations directly from the
+ * backends sending them, so our callbacks needn't tell it anything.
+ *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -57,22 +63,33 @@
 #include <limits.h>
 
 #include "access/transam.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_namespace.h"
 #include "executor/executor.h"
+#include "lib/stringinfo.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/optimizer.h"
 #include "parser/analyze.h"
+#include "parser/parse_expr.h"
+#include "parser/parser.h"
 #include "parser/parsetree.h"
+#include "pgtime.h"
 #include "storage/lmgr.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
+#include "utils/array.h"
 #include "utils/inval.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/pg_locale.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
+#include "utils/xml.h"
 
 
 /*
@@ -96,12 +113,41 @@ static dlist_head saved_plan_list = DLIST_STATIC_INIT(saved_plan_list);
  */
 static dlist_head cached_expression_list = DLIST_STATIC_INIT(cached_expression_list);
 
+/*
+ * Header of the data we put in the shared plan cache for a query.  It is
+ * followed by the resolved parameter types, by the GetPlannerSettings()
+ * string the generic plan was made with, and by the nodeToString() form of a
+ * two-element list: the analyzed-and-rewritten query list and the generic
+ * plan's statement list.
+ */
+typedef struct SharedPlanHeader
+{
+	int			num_params;		/* number of resolved parameter types */
+	int			num_custom_plans;	/* copied from the CachedPlanSource */
+	double		total_custom_cost;	/* likewise */
+} SharedPlanHeader;
+
 static void ReleaseGenericPlan(CachedPlanSource *plansource);
 static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 					  QueryEnvironment *queryEnv);
 static bool CheckCachedPlan(CachedPlanSource *plansource);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 				ParamListInfo boundParams, QueryEnvironment *queryEnv);
+static CachedPlan *MakeCachedPlan(CachedPlanSource *plansource, List *plist,
+			   MemoryContext plan_context);
+static void SetSharedPlanKey(CachedPlanSource *plansource);
+static bool SharedPlanDependencies(CachedPlanSource *plansource,
+					   List *stmt_list,
+					   List **relationOids, List **invalItems);
+static bool SharedPlanIsCurrent(CachedPlanSource *plansource,
+					List *stmt_list, uint64 generation);
+static bool SharedPlanFetch(CachedPlanSource *plansource,
+				SharedPlanHeader *header, Oid **param_types,
+				char **planner_settings,
+				List **query_list, List **stmt_list);
+static bool UseSharedGenericPlan(CachedPlanSource *plansource);
+static void StoreSharedGenericPlan(CachedPlanSource *plansource,
+					   CachedPlan *plan);
 static bool choose_custom_plan(CachedPlanSource *plansource,
 				   ParamListInfo boundParams);
 static double cached_plan_cost(CachedPlan *plan, bool include_planner);
@@ -219,6 +265,11 @@ CreateCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->is_shareable = false;
+	plansource->shared_param_types = NULL;
+	plansource->shared_num_params = 0;
+	plansource->shared_key = NULL;
+	plansource->shared_key_len = 0;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -286,6 +337,11 @@ CreateOneShotCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->is_shareable = false;
+	plansource->shared_param_types = NULL;
+	plansource->shared_num_params = 0;
+	plansource->shared_key = NULL;
+	plansource->shared_key_len = 0;
 
 	return plansource;
 }
@@ -433,6 +489,121 @@ CompleteCachedPlan(CachedPlanSource *plansource,
 	plansource->is_valid = true;
 }
 
+/*
+ * CompleteCachedPlanFromShared: try to complete a CachedPlanSource from the
+ * shared plan cache.
+ *
+ * This is meant to be called right after CreateCachedPlan by callers that
+ * will save the CachedPlanSource, before they do parse analysis.  If another
+ * backend has stored the analyzed-and-rewritten query, we complete the
+ * CachedPlanSource with it and return true, and the caller can skip straight
+ * to saving it.  Otherwise we return false, and the caller must go on with
+ * parse analysis and CompleteCachedPlan as usual.  Either way, the
+ * CachedPlanSource is marked as allowed to fetch and store its generic plan
+ * in the shared plan cache.
+ *
+ * param_types and num_params describe the parameter types specified by the
+ * client, before any unknown types are resolved; the other arguments are as
+ * for CompleteCachedPlan.  Parameter types resolved by parse analysis are
+ * taken from the shared entry.
+ */
+bool
+CompleteCachedPlanFromShared(CachedPlanSource *plansource,
+							 Oid *param_types,
+							 int num_params,
+							 int cursor_options,
+							 bool fixed_result)
+{
+	MemoryContext oldcxt;
+	Node	   *stmt;
+	SharedPlanHeader header;
+	Oid		   *resolved_types;
+	char	   *planner_settings;
+	List	   *query_list;
+	List	   *stmt_list;
+	uint64		generation;
+
+	/* Assert caller is doing things in a sane order */
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(!plansource->is_complete);
+
+	if (!SharedPlanCacheEnabled() || plansource->is_oneshot ||
+		plansource->raw_parse_tree == NULL)
+		return false;
+
+	/*
+	 * Only ordinary DML is worth sharing.  Utility statements don't have
+	 * interesting plans, and can't generally be passed through nodeToString
+	 * anyway.
+	 */
+	stmt = plansource->raw_parse_tree->stmt;
+	if (!IsA(stmt, SelectStmt) &&
+		!IsA(stmt, InsertStmt) &&
+		!IsA(stmt, UpdateStmt) &&
+		!IsA(stmt, DeleteStmt))
+		return false;
+
+	/* Remember what identifies the query in the shared plan cache */
+	oldcxt = MemoryContextSwitchTo(plansource->context);
+	if (num_params > 0)
+	{
+		plansource->shared_param_types = (Oid *) palloc(num_params * sizeof(Oid));
+		memcpy(plansource->shared_param_types, param_types,
+			   num_params * sizeof(Oid));
+	}
+	plansource->shared_num_params = num_params;
+	plansource->cursor_options = cursor_options;
+	plansource->is_shareable = true;
+	MemoryContextSwitchTo(oldcxt);
+
+	/*
+	 * The key reflects the settings parse analysis will run with, whether
+	 * here or in our caller.
+	 */
+	SetSharedPlanKey(plansource);
+
+	/*
+	 * Process pending invalidations first, so that entries they make out of
+	 * date are recognized as such.  If we process another invalidation
+	 * before the CachedPlanSource is saved, our callbacks will not see it;
+	 * so check for that below.
+	 */
+	generation = SharedPlanCacheGetGeneration();
+	AcceptInvalidationMessages();
+
+	if (!SharedPlanFetch(plansource, &header, &resolved_types,
+						 &planner_settings, &query_list, &stmt_list))
+		return false;
+
+	CompleteCachedPlan(plansource,
+					   query_list,
+					   NULL,
+					   resolved_types,
+					   header.num_params,
+					   NULL,
+					   NULL,
+					   cursor_options,
+					   fixed_result);
+
+	elog(DEBUG1, "analyzed query taken from shared plan cache");
+
+	/* We may as well trust the other backend's experience with costs */
+	plansource->total_custom_cost = header.total_custom_cost;
+	plansource->num_custom_plans = header.num_custom_plans;
+
+	/*
+	 * Parse analysis would have locked the relations, so do that too.  Once
+	 * we hold the locks, any conflicting DDL has been accounted for in the
+	 * shared plan cache, so check whether we might have missed something,
+	 * and force re-analysis at first use if so.
+	 */
+	AcquirePlannerLocks(plansource->query_list, true);
+	if (!SharedPlanIsCurrent(plansource, NIL, generation))
+		plansource->is_valid = false;
+
+	return true;
+}
+
 /*
  * SaveCachedPlan: save a cached plan permanently
  *
@@ -776,6 +947,10 @@ RevalidateCachedQuery(CachedPlanSource *plansource,
 
 	plansource->is_valid = true;
 
+	/* The query now reflects the current settings, and so must its key */
+	if (plansource->is_shareable)
+		SetSharedPlanKey(plansource);
+
 	/* Return transient copy of querytrees for possible use in planning */
 	return tlist;
 }
@@ -880,10 +1055,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	CachedPlan *plan;
 	List	   *plist;
 	bool		snapshot_set;
-	bool		is_transient;
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
-	ListCell   *lc;
 
 	/*
 	 * Normally the querytree should be valid already, but if it's not,
@@ -962,6 +1135,30 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	/*
 	 * Create and fill the CachedPlan struct within the new context.
 	 */
+	plan = MakeCachedPlan(plansource, plist, plan_context);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	return plan;
+}
+
+/*
+ * MakeCachedPlan: create the CachedPlan struct for a list of PlannedStmts.
+ *
+ * plist must already be stored in plan_context, which will hold the
+ * CachedPlan as well.
+ */
+static CachedPlan *
+MakeCachedPlan(CachedPlanSource *plansource, List *plist,
+			   MemoryContext plan_context)
+{
+	CachedPlan *plan;
+	bool		is_transient;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+
+	oldcxt = MemoryContextSwitchTo(plan_context);
+
 	plan = (CachedPlan *) palloc(sizeof(CachedPlan));
 	plan->magic = CACHEDPLAN_MAGIC;
 	plan->stmt_list = plist;
@@ -1007,6 +1204,393 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	return plan;
 }
 
+/*
+ * SetSharedPlanKey: set the key for plansource's query in the shared plan
+ * cache, as it would be analyzed now.
+ *
+ * Besides the query text and the options given when it was prepared, the key
+ * includes everything else that parse analysis depends on: the database, the
+ * current user, the current search_path, and the settings that affect how
+ * literals are converted to constants and how some expressions are
+ * transformed.  The key is set to NULL if the query can't be shared in the
+ * current state, namely if the search_path includes our temporary schema,
+ * whose contents are private to this session.
+ */
+static void
+SetSharedPlanKey(CachedPlanSource *plansource)
+{
+	OverrideSearchPath *search_path;
+	Oid			userid = GetUserId();
+	const char *timezone = pg_get_timezone_name(session_timezone);
+	int			nschemas;
+	StringInfoData key;
+	ListCell   *lc;
+
+	if (plansource->shared_key)
+		pfree(plansource->shared_key);
+	plansource->shared_key = NULL;
+	plansource->shared_key_len = 0;
+
+	search_path = GetOverrideSearchPath(CurrentMemoryContext);
+	if (search_path->addTemp)
+		return;
+	foreach(lc, search_path->schemas)
+	{
+		if (isTempNamespace(lfirst_oid(lc)))
+			return;
+	}
+	nschemas = list_length(search_path->schemas);
+
+	initStringInfo(&key);
+	appendBinaryStringInfo(&key, (char *) &MyDatabaseId, sizeof(Oid));
+	appendBinaryStringInfo(&key, (char *) &userid, sizeof(Oid));
+	appendBinaryStringInfo(&key, (char *) &row_security, sizeof(bool));
+	appendBinaryStringInfo(&key, (char *) &plansource->cursor_options,
+						   sizeof(int));
+	appendBinaryStringInfo(&key, (char *) &plansource->shared_num_params,
+						   sizeof(int));
+	if (plansource->shared_num_params > 0)
+		appendBinaryStringInfo(&key, (char *) plansource->shared_param_types,
+							   plansource->shared_num_params * sizeof(Oid));
+	appendBinaryStringInfo(&key, (char *) &search_path->addCatalog,
+						   sizeof(bool));
+	appendBinaryStringInfo(&key, (char *) &nschemas, sizeof(int));
+	foreach(lc, search_path->schemas)
+	{
+		Oid			schema = lfirst_oid(lc);
+
+		appendBinaryStringInfo(&key, (char *) &schema, sizeof(Oid));
+	}
+
+	/* Settings consulted by parse analysis, or by input functions it runs */
+	appendBinaryStringInfo(&key, (char *) &DateStyle, sizeof(int));
+	appendBinaryStringInfo(&key, (char *) &DateOrder, sizeof(int));
+	appendBinaryStringInfo(&key, (char *) &IntervalStyle, sizeof(int));
+	appendBinaryStringInfo(&key, (char *) &xmloption, sizeof(int));
+	appendBinaryStringInfo(&key, (char *) &Transform_null_equals,
+						   sizeof(bool));
+	appendBinaryStringInfo(&key, (char *) &standard_conforming_strings,
+						   sizeof(bool));
+	appendBinaryStringInfo(&key, (char *) &Array_nulls, sizeof(bool));
+	appendBinaryStringInfo(&key, timezone, strlen(timezone) + 1);
+	appendBinaryStringInfo(&key, locale_monetary, strlen(locale_monetary) + 1);
+
+	appendStringInfoString(&key, plansource->query_string);
+
+	plansource->shared_key = MemoryContextAlloc(plansource->context, key.len);
+	memcpy(plansource->shared_key, key.data, key.len);
+	plansource->shared_key_len = key.len;
+	pfree(key.data);
+}
+
+/*
+ * SharedPlanDependencies: list what a shared entry for plansource's query
+ * and the given generic plan depends on.
+ *
+ * Besides the objects that the query and plan depend on themselves, the
+ * entry depends on the schemas in the search_path and on those of the
+ * relations, since changes to them can change how the query text is
+ * analyzed.  Returns false if stmt_list contains a utility statement, which
+ * can't be shared.
+ */
+static bool
+SharedPlanDependencies(CachedPlanSource *plansource, List *stmt_list,
+					   List **relationOids, List **invalItems)
+{
+	List	   *namespaces = NIL;
+	ListCell   *lc;
+
+	*relationOids = list_copy(plansource->relationOids);
+	*invalItems = list_copy(plansource->invalItems);
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+
+		if (plannedstmt->commandType == CMD_UTILITY)
+			return false;
+
+		*relationOids = list_concat(*relationOids,
+									list_copy(plannedstmt->relationOids));
+		*invalItems = list_concat(*invalItems,
+								  list_copy(plannedstmt->invalItems));
+	}
+
+	if (plansource->search_path)
+	{
+		namespaces = list_copy(plansource->search_path->schemas);
+		if (plansource->search_path->addCatalog)
+			namespaces = lappend_oid(namespaces, PG_CATALOG_NAMESPACE);
+	}
+	foreach(lc, *relationOids)
+	{
+		Oid			namespace = get_rel_namespace(lfirst_oid(lc));
+
+		if (OidIsValid(namespace))
+			namespaces = list_append_unique_oid(namespaces, namespace);
+	}
+	foreach(lc, namespaces)
+	{
+		PlanInvalItem *item = makeNode(PlanInvalItem);
+
+		item->cacheId = NAMESPACEOID;
+		item->hashValue = GetSysCacheHashValue1(NAMESPACEOID,
+												ObjectIdGetDatum(lfirst_oid(lc)));
+		*invalItems = lappend(*invalItems, item);
+	}
+	list_free(namespaces);
+
+	return true;
+}
+
+/*
+ * SharedPlanIsCurrent: check that nothing plansource's query, or the given
+ * generic plan, depends on has been invalidated since 'generation' was read
+ * from the shared plan cache.
+ */
+static bool
+SharedPlanIsCurrent(CachedPlanSource *plansource, List *stmt_list,
+					uint64 generation)
+{
+	List	   *relationOids;
+	List	   *invalItems;
+	bool		result;
+
+	result = SharedPlanDependencies(plansource, stmt_list,
+									&relationOids, &invalItems) &&
+		SharedPlanCacheIsCurrent(relationOids, invalItems, generation);
+
+	list_free(relationOids);
+	list_free(invalItems);
+
+	return result;
+}
+
+/*
+ * SharedPlanFetch: look up plansource's query in the shared plan cache.
+ *
+ * If found, return the resolved parameter types, the planner settings the
+ * generic plan was made with, the analyzed-and-rewritten query list and the
+ * generic plan's statement list stored for it, all allocated in the caller's
+ * memory context.
+ */
+static bool
+SharedPlanFetch(CachedPlanSource *plansource, SharedPlanHeader *header,
+				Oid **param_types, char **planner_settings,
+				List **query_list, List **stmt_list)
+{
+	char	   *data;
+	char	   *ptr;
+	Size		data_len;
+	List	   *lists;
+	ListCell   *lc;
+
+	/*
+	 * If our transaction has an XID, it might have changed the catalogs, and
+	 * what others stored would not be valid for us.
+	 */
+	if (plansource->shared_key == NULL ||
+		TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+
+	data = SharedPlanCacheLookup(plansource->shared_key,
+								 plansource->shared_key_len, &data_len);
+	if (data == NULL)
+		return false;
+
+	memcpy(header, data, sizeof(SharedPlanHeader));
+	ptr = data + sizeof(SharedPlanHeader);
+	if (header->num_params > 0)
+	{
+		*param_types = (Oid *) palloc(header->num_params * sizeof(Oid));
+		memcpy(*param_types, ptr, header->num_params * sizeof(Oid));
+		ptr += header->num_params * sizeof(Oid);
+	}
+	else
+		*param_types = NULL;
+	*planner_settings = pstrdup(ptr);
+	ptr += strlen(ptr) + 1;
+	lists = (List *) stringToNode(ptr);
+	pfree(data);
+
+	*query_list = (List *) linitial(lists);
+	*stmt_list = (List *) lsecond(lists);
+
+	/*
+	 * stringToNode doesn't restore location fields.  The statement locations
+	 * are worth having, since they are reported by extensions, and we know
+	 * what they must be.
+	 */
+	foreach(lc, *query_list)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		query->stmt_location = plansource->raw_parse_tree->stmt_location;
+		query->stmt_len = plansource->raw_parse_tree->stmt_len;
+	}
+	foreach(lc, *stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+
+		plannedstmt->stmt_location = plansource->raw_parse_tree->stmt_location;
+		plannedstmt->stmt_len = plansource->raw_parse_tree->stmt_len;
+	}
+
+	return true;
+}
+
+/*
+ * UseSharedGenericPlan: adopt a generic plan from the shared plan cache.
+ *
+ * Caller must have already called RevalidateCachedQuery.  If another backend
+ * has stored a generic plan for the query, make it plansource's generic plan
+ * and check it as CheckCachedPlan does.  On a "true" return, we have acquired
+ * the locks needed to run the plan.
+ */
+static bool
+UseSharedGenericPlan(CachedPlanSource *plansource)
+{
+	SharedPlanHeader header;
+	Oid		   *param_types;
+	char	   *planner_settings;
+	char	   *our_settings;
+	List	   *query_list;
+	List	   *stmt_list;
+	MemoryContext plan_context;
+	MemoryContext oldcxt;
+	CachedPlan *plan;
+	uint64		generation;
+
+	/*
+	 * Invalidations we process before the plan is linked into the
+	 * plansource don't reach it through our callbacks, so check for them
+	 * below, as CompleteCachedPlanFromShared does.
+	 */
+	generation = SharedPlanCacheGetGeneration();
+	AcceptInvalidationMessages();
+	if (!plansource->is_valid)
+		return false;
+
+	if (!SharedPlanFetch(plansource, &header, &param_types,
+						 &planner_settings, &query_list, &stmt_list))
+		return false;
+
+	/*
+	 * The plan reflects the planner settings of the backend that made it, so
+	 * it's only good for us if ours are the same.  Otherwise we make our own,
+	 * which replaces the shared one.
+	 */
+	our_settings = GetPlannerSettings();
+	if (strcmp(planner_settings, our_settings) != 0)
+		return false;
+
+	/*
+	 * The query should have been analyzed the same way as ours, but don't
+	 * take chances with the parameter types.
+	 */
+	if (header.num_params != plansource->num_params ||
+		(header.num_params > 0 &&
+		 memcmp(param_types, plansource->param_types,
+				header.num_params * sizeof(Oid)) != 0))
+		return false;
+
+	if (!SharedPlanIsCurrent(plansource, stmt_list, generation))
+		return false;
+
+	/* Saved plans all live under CacheMemoryContext */
+	plan_context = AllocSetContextCreate(CacheMemoryContext,
+										 "CachedPlan",
+										 ALLOCSET_START_SMALL_SIZES);
+	MemoryContextCopyAndSetIdentifier(plan_context, plansource->query_string);
+	oldcxt = MemoryContextSwitchTo(plan_context);
+	stmt_list = copyObject(stmt_list);
+	MemoryContextSwitchTo(oldcxt);
+
+	plan = MakeCachedPlan(plansource, stmt_list, plan_context);
+	plan->is_saved = true;
+
+	/* Link it into the plansource, as GetCachedPlan does for new plans */
+	ReleaseGenericPlan(plansource);
+	plansource->gplan = plan;
+	plan->refcount++;
+	plansource->generic_cost = cached_plan_cost(plan, false);
+
+	/* Lock what it needs, and make sure it is still valid */
+	if (!CheckCachedPlan(plansource))
+		return false;
+
+	elog(DEBUG1, "generic plan taken from shared plan cache");
+
+	return true;
+}
+
+/*
+ * StoreSharedGenericPlan: put a newly built generic plan, and the query it
+ * was built from, into the shared plan cache.
+ */
+static void
+StoreSharedGenericPlan(CachedPlanSource *plansource, CachedPlan *plan)
+{
+	uint64		generation;
+	StringInfoData data;
+	SharedPlanHeader header;
+	List	   *relationOids;
+	List	   *invalItems;
+	char	   *planner_settings;
+	char	   *str;
+
+	/*
+	 * Process pending invalidations, so that our callbacks get a chance to
+	 * mark the plan invalid.  The shared plan cache refuses the entry if any
+	 * of its dependencies is invalidated after we read the generation
+	 * counter, since we might not have seen it.
+	 */
+	generation = SharedPlanCacheGetGeneration();
+	AcceptInvalidationMessages();
+
+	if (!plansource->is_valid || !plan->is_valid ||
+		plansource->shared_key == NULL)
+		return;
+
+	/*
+	 * Plans specific to our role or transaction are of no use to others.  If
+	 * our transaction has an XID, the plan might also reflect catalog
+	 * changes that others can't see, and that might never be committed.
+	 */
+	if (plan->dependsOnRole || TransactionIdIsValid(plan->saved_xmin) ||
+		TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return;
+
+	if (!SharedPlanDependencies(plansource, plan->stmt_list,
+								&relationOids, &invalItems))
+		return;
+
+	header.num_params = plansource->num_params;
+	header.num_custom_plans = plansource->num_custom_plans;
+	header.total_custom_cost = plansource->total_custom_cost;
+
+	initStringInfo(&data);
+	appendBinaryStringInfo(&data, (char *) &header, sizeof(SharedPlanHeader));
+	if (plansource->num_params > 0)
+		appendBinaryStringInfo(&data, (char *) plansource->param_types,
+							   plansource->num_params * sizeof(Oid));
+	/* The plan was just made, so it reflects our current settings */
+	planner_settings = GetPlannerSettings();
+	appendBinaryStringInfo(&data, planner_settings,
+						   strlen(planner_settings) + 1);
+	pfree(planner_settings);
+	str = nodeToString(list_make2(plansource->query_list, plan->stmt_list));
+	appendBinaryStringInfo(&data, str, strlen(str) + 1);
+	pfree(str);
+
+	SharedPlanCacheInsert(plansource->shared_key, plansource->shared_key_len,
+						  data.data, data.len,
+						  relationOids, invalItems, generation);
+
+	pfree(data.data);
+	list_free(relationOids);
+	list_free(invalItems);
+}
+
 /*
  * choose_custom_plan: choose whether to use custom or generic plan
  *
@@ -1163,6 +1747,16 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 			plan = plansource->gplan;
 			Assert(plan->magic == CACHEDPLAN_MAGIC);
 		}
+		else if (plansource->is_shareable && plansource->is_saved &&
+				 UseSharedGenericPlan(plansource))
+		{
+			/* Another backend made a generic plan, and it's now ours */
+			plan = plansource->gplan;
+			Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+			/* As below, make sure the new generic_cost doesn't change our mind */
+			customplan = choose_custom_plan(plansource, boundParams);
+		}
 		else
 		{
 			/* Build a new generic plan */
@@ -1188,6 +1782,10 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 			/* Update generic_cost whenever we make a new generic plan */
 			plansource->generic_cost = cached_plan_cost(plan, false);
 
+			/* Let other backends use it too, if allowed */
+			if (plansource->is_shareable && plansource->is_saved)
+				StoreSharedGenericPlan(plansource, plan);
+
 			/*
 			 * If, based on the now-known value of generic_cost, we'd not have
 			 * chosen to use a generic plan, then forget it and make a custom
@@ -1398,6 +1996,13 @@ CopyCachedPlan(CachedPlanSource *plansource)
 	newsource->total_custom_cost = plansource->total_custom_cost;
 	newsource->num_custom_plans = plansource->num_custom_plans;
 
+	/* The copy is not saved, so it can't use the shared plan cache */
+	newsource->is_shareable = false;
+	newsource->shared_param_types = NULL;
+	newsource->shared_num_params = 0;
+	newsource->shared_key = NULL;
+	newsource->shared_key_len = 0;
+
 	MemoryContextSwitchTo(oldcxt);
 
 	return newsource;
@@ -0,0 +1,681 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.c
+ *	  Plan cache shared between backends.
+ *
+ * Sessions that prepare the same statements over and over, as happens with
+ * connection poolers, spend a lot of time in parse analysis and planning
+ * whenever new connections are made.  The shared plan cache lets a backend
+ * pick up the analyzed query and generic plan that another backend made for
+ * the same statement.  plancache.c decides what may be shared and how it is
+ * serialized; this module just maps opaque keys to opaque data, and keeps
+ * track of what each entry depends on so that it can be invalidated.
+ *
+ * The entries are found through a hash table in the main shared memory
+ * segment, keyed by a hash of the key bytes, while the keys and data live in
+ * a DSA area created in place, also in the main segment.  The area is not
+ * allowed to grow beyond its initial size: when it or the hash table is
+ * full, we evict the least recently used entries.
+ *
+ * Invalidation works with generation numbers rather than by searching the
+ * table.  Every object an entry can depend on maps to one of a fixed number
+ * of dependency slots, each of which remembers the generation at which an
+ * object mapping to it was last invalidated.  An entry remembers the
+ * generation it was made at, and is out of date once any of its slots has
+ * moved past that.  Out-of-date entries are simply not returned; they are
+ * replaced when the statement is stored again, or evicted in due course.
+ *
+ * The generations are advanced by the backend that sends the invalidation
+ * messages, right after putting them into the sinval queue, so that each
+ * invalidation is only accounted for once.  Since that is after the change
+ * has committed, a backend that reads the generation counter afterwards and
+ * then processes pending invalidations is sure to see the messages itself.
+ * So a backend storing a plan reads the counter before it last processes
+ * invalidations, and the entry is refused if any of its slots has moved
+ * past the value read; if the slots move later, the entry is out of date.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "nodes/plannodes.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/dsa.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/sharedplancache.h"
+#include "utils/syscache.h"
+
+
+/*
+ * We size the hash table for this much DSA space per entry on average.
+ */
+#define SHARED_PLAN_CACHE_ENTRY_SIZE	4096
+
+/*
+ * Number of dependency slots.  Objects that map to the same slot invalidate
+ * each other's entries, so this should be large compared to the number of
+ * objects invalidated between uses of a typical entry.
+ */
+#define SHARED_PLAN_CACHE_INVAL_SLOTS	4096
+
+/* Shared state of the shared plan cache */
+typedef struct SharedPlanCacheControl
+{
+	LWLock		lock;			/* protects the hash table and its entries */
+	pg_atomic_uint64 clock;		/* source of last_used values */
+	pg_atomic_uint64 generation;	/* advanced by every batch of messages */
+	pg_atomic_uint64 inval_all; /* last generation invalidating everything */
+	/* last generation invalidating an object mapping to each slot */
+	pg_atomic_uint64 inval_slots[SHARED_PLAN_CACHE_INVAL_SLOTS];
+	/* the DSA area follows, at a MAXALIGN'd offset */
+} SharedPlanCacheControl;
+
+/* Hash table entry */
+typedef struct SharedPlanCacheEntry
+{
+	uint64		hashkey;		/* hash of the key bytes */
+	dsa_pointer chunk;			/* SharedPlanChunk with everything else */
+	pg_atomic_uint64 last_used; /* clock value at last lookup */
+} SharedPlanCacheEntry;
+
+/*
+ * The DSA chunk of an entry.  The header is followed by the numbers of the
+ * dependency slots of the objects the entry depends on, the key and the
+ * data.
+ */
+typedef struct SharedPlanChunk
+{
+	uint64		generation;		/* generation the entry was made at */
+	int			nslots;
+	Size		key_len;
+	Size		data_len;
+} SharedPlanChunk;
+
+#define SharedPlanChunkSlots(chunk) \
+	((uint32 *) ((char *) (chunk) + MAXALIGN(sizeof(SharedPlanChunk))))
+#define SharedPlanChunkKey(chunk) \
+	((char *) (SharedPlanChunkSlots(chunk) + (chunk)->nslots))
+#define SharedPlanChunkData(chunk) \
+	(SharedPlanChunkKey(chunk) + (chunk)->key_len)
+
+/* GUC parameter: size of the DSA area in kB, or 0 to disable */
+int			shared_plan_cache_size = 0;
+
+static SharedPlanCacheControl *SharedPlanCache = NULL;
+static HTAB *SharedPlanCacheHash = NULL;
+
+/* This backend's attachment to the DSA area */
+static dsa_area *spc_area = NULL;
+
+static Size SharedPlanCacheAreaSize(void);
+static long SharedPlanCacheMaxEntries(void);
+static dsa_area *spc_get_area(void);
+static void spc_release_area(int code, Datum arg);
+static bool spc_evict_one(dsa_area *area);
+static void spc_remove_entry(dsa_area *area, SharedPlanCacheEntry *entry);
+static uint32 spc_relation_slot(Oid relid);
+static uint32 spc_object_slot(int cacheid, uint32 hashvalue);
+static uint32 *spc_dependency_slots(List *relationOids, List *invalItems,
+					 int *nslots);
+static bool spc_slots_current(const uint32 *slots, int nslots,
+				  uint64 generation);
+static void spc_advance(pg_atomic_uint64 *counter, uint64 generation);
+static int	spc_slot_cmp(const void *a, const void *b);
+
+
+/*
+ * Size of the DSA area holding keys and data
+ */
+static Size
+SharedPlanCacheAreaSize(void)
+{
+	return Max(mul_size(shared_plan_cache_size, 1024), dsa_minimum_size());
+}
+
+/*
+ * Maximum number of entries in the hash table
+ */
+static long
+SharedPlanCacheMaxEntries(void)
+{
+	return Max(SharedPlanCacheAreaSize() / SHARED_PLAN_CACHE_ENTRY_SIZE, 64);
+}
+
+/*
+ * Report shared memory space needed by SharedPlanCacheShmemInit
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_plan_cache_size == 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedPlanCacheControl));
+	size = add_size(size, SharedPlanCacheAreaSize());
+	size = add_size(size, hash_estimate_size(SharedPlanCacheMaxEntries(),
+											 sizeof(SharedPlanCacheEntry)));
+
+	return size;
+}
+
+/*
+ * Initialize shared memory for the shared plan cache, if it is enabled
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (shared_plan_cache_size == 0)
+		return;
+
+	SharedPlanCache = (SharedPlanCacheControl *)
+		ShmemInitStruct("Shared Plan Cache",
+						add_size(MAXALIGN(sizeof(SharedPlanCacheControl)),
+								 SharedPlanCacheAreaSize()),
+						&found);
+
+	if (!found)
+	{
+		dsa_area   *area;
+		int			i;
+
+		LWLockInitialize(&SharedPlanCache->lock, LWTRANCHE_SHARED_PLAN_CACHE);
+		pg_atomic_init_u64(&SharedPlanCache->clock, 0);
+		pg_atomic_init_u64(&SharedPlanCache->generation, 0);
+		pg_atomic_init_u64(&SharedPlanCache->inval_all, 0);
+		for (i = 0; i < SHARED_PLAN_CACHE_INVAL_SLOTS; i++)
+			pg_atomic_init_u64(&SharedPlanCache->inval_slots[i], 0);
+
+		/*
+		 * The area must never grow beyond the space we reserved for it, since
+		 * it would then need DSM segments that aren't shared by backends that
+		 * attach later.  We stay attached to it, so that the area lives as
+		 * long as the shared memory segment.
+		 */
+		area = dsa_create_in_place((char *) SharedPlanCache +
+								   MAXALIGN(sizeof(SharedPlanCacheControl)),
+								   SharedPlanCacheAreaSize(),
+								   LWTRANCHE_SHARED_PLAN_CACHE, NULL);
+		dsa_set_size_limit(area, SharedPlanCacheAreaSize());
+	}
+
+	info.keysize = sizeof(uint64);
+	info.entrysize = sizeof(SharedPlanCacheEntry);
+	SharedPlanCacheHash = ShmemInitHash("Shared Plan Cache Hash",
+										SharedPlanCacheMaxEntries(),
+										SharedPlanCacheMaxEntries(),
+										&info,
+										HASH_ELEM | HASH_BLOBS);
+}
+
+/*
+ * Is the shared plan cache enabled?
+ */
+bool
+SharedPlanCacheEnabled(void)
+{
+	return SharedPlanCache != NULL;
+}
+
+/*
+ * Get the current invalidation generation, to be passed to
+ * SharedPlanCacheInsert or SharedPlanCacheIsCurrent.  This must be done
+ * before processing pending invalidations for the last time before the
+ * insertion or the check.
+ */
+uint64
+SharedPlanCacheGetGeneration(void)
+{
+	Assert(SharedPlanCache != NULL);
+
+	return pg_atomic_read_u64(&SharedPlanCache->generation);
+}
+
+/*
+ * Look up the entry with the given key.  If there is one and it is not out
+ * of date, return a palloc'd copy of its data and set *data_len; otherwise
+ * return NULL.
+ */
+char *
+SharedPlanCacheLookup(const char *key, Size key_len, Size *data_len)
+{
+	dsa_area   *area = spc_get_area();
+	uint64		hashkey;
+	SharedPlanCacheEntry *entry;
+	char	   *result = NULL;
+
+	hashkey = DatumGetUInt64(hash_any_extended((const unsigned char *) key,
+											   key_len, 0));
+
+	LWLockAcquire(&SharedPlanCache->lock, LW_SHARED);
+
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash,
+												 &hashkey, HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		SharedPlanChunk *chunk = dsa_get_address(area, entry->chunk);
+
+		/*
+		 * The hash could collide, so compare the whole key.  An out-of-date
+		 * entry is as good as none; it will be replaced or evicted later.
+		 */
+		if (chunk->key_len == key_len &&
+			memcmp(SharedPlanChunkKey(chunk), key, key_len) == 0 &&
+			spc_slots_current(SharedPlanChunkSlots(chunk), chunk->nslots,
+							  chunk->generation))
+		{
+			result = palloc(chunk->data_len);
+			memcpy(result, SharedPlanChunkData(chunk), chunk->data_len);
+			*data_len = chunk->data_len;
+
+			pg_atomic_write_u64(&entry->last_used,
+								pg_atomic_fetch_add_u64(&SharedPlanCache->clock, 1));
+		}
+	}
+
+	LWLockRelease(&SharedPlanCache->lock);
+
+	return result;
+}
+
+/*
+ * Insert an entry, replacing any existing entry with the same key.
+ *
+ * relationOids and invalItems describe what the data depends on, like the
+ * fields of the same names in PlannedStmt.  Nothing is inserted if any of
+ * those objects may have been invalidated since 'generation' was obtained,
+ * or if there is not enough room even after evicting other entries.
+ */
+void
+SharedPlanCacheInsert(const char *key, Size key_len,
+					  const char *data, Size data_len,
+					  List *relationOids, List *invalItems,
+					  uint64 generation)
+{
+	dsa_area   *area = spc_get_area();
+	uint64		hashkey;
+	SharedPlanCacheEntry *entry;
+	SharedPlanChunk *chunk;
+	dsa_pointer chunk_dp;
+	Size		size;
+	bool		found;
+	uint32	   *slots;
+	int			nslots;
+
+	slots = spc_dependency_slots(relationOids, invalItems, &nslots);
+
+	/*
+	 * If the slots move after this check, the entry will be out of date as
+	 * soon as it's made, so there's no need to hold the lock.
+	 */
+	if (!spc_slots_current(slots, nslots, generation))
+	{
+		pfree(slots);
+		return;
+	}
+
+	hashkey = DatumGetUInt64(hash_any_extended((const unsigned char *) key,
+											   key_len, 0));
+
+	size = MAXALIGN(sizeof(SharedPlanChunk));
+	size = add_size(size, mul_size(nslots, sizeof(uint32)));
+	size = add_size(size, key_len);
+	size = add_size(size, data_len);
+
+	/* Don't bother if it could never fit */
+	if (size > SharedPlanCacheAreaSize() / 2)
+	{
+		pfree(slots);
+		return;
+	}
+
+	LWLockAcquire(&SharedPlanCache->lock, LW_EXCLUSIVE);
+
+	/* Get rid of any existing entry for the key, and make room for ours */
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash,
+												 &hashkey, HASH_FIND, NULL);
+	if (entry != NULL)
+		spc_remove_entry(area, entry);
+
+	while (hash_get_num_entries(SharedPlanCacheHash) >=
+		   SharedPlanCacheMaxEntries())
+	{
+		if (!spc_evict_one(area))
+			break;
+	}
+
+	for (;;)
+	{
+		chunk_dp = dsa_allocate_extended(area, size, DSA_ALLOC_NO_OOM);
+		if (DsaPointerIsValid(chunk_dp) || !spc_evict_one(area))
+			break;
+	}
+
+	if (!DsaPointerIsValid(chunk_dp))
+	{
+		LWLockRelease(&SharedPlanCache->lock);
+		pfree(slots);
+		return;
+	}
+
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash,
+												 &hashkey, HASH_ENTER_NULL,
+												 &found);
+	if (entry == NULL)
+	{
+		dsa_free(area, chunk_dp);
+		LWLockRelease(&SharedPlanCache->lock);
+		pfree(slots);
+		return;
+	}
+	Assert(!found);
+
+	chunk = dsa_get_address(area, chunk_dp);
+	chunk->generation = generation;
+	chunk->nslots = nslots;
+	chunk->key_len = key_len;
+	chunk->data_len = data_len;
+	memcpy(SharedPlanChunkSlots(chunk), slots, nslots * sizeof(uint32));
+	memcpy(SharedPlanChunkKey(chunk), key, key_len);
+	memcpy(SharedPlanChunkData(chunk), data, data_len);
+
+	entry->chunk = chunk_dp;
+	pg_atomic_init_u64(&entry->last_used,
+					   pg_atomic_fetch_add_u64(&SharedPlanCache->clock, 1));
+
+	LWLockRelease(&SharedPlanCache->lock);
+
+	pfree(slots);
+}
+
+/*
+ * Check whether any of the given objects may have been invalidated since
+ * 'generation' was obtained.  This is for callers that took data from the
+ * cache before they could be sure to notice invalidations of it themselves.
+ */
+bool
+SharedPlanCacheIsCurrent(List *relationOids, List *invalItems,
+						 uint64 generation)
+{
+	uint32	   *slots;
+	int			nslots;
+	bool		result;
+
+	Assert(SharedPlanCache != NULL);
+
+	slots = spc_dependency_slots(relationOids, invalItems, &nslots);
+	result = spc_slots_current(slots, nslots, generation);
+	pfree(slots);
+
+	return result;
+}
+
+/*
+ * Account for invalidation messages that have just been sent, making the
+ * entries that depend on the objects they concern out of date.
+ *
+ * This is called by the backend sending the messages, and only after it
+ * has put them into the sinval queue; see the header comment.
+ */
+void
+SharedPlanCacheInvalidateMessages(const SharedInvalidationMessage *msgs,
+								  int n)
+{
+	uint64		generation;
+	int			i;
+
+	if (SharedPlanCache == NULL || n <= 0)
+		return;
+
+	generation = pg_atomic_add_fetch_u64(&SharedPlanCache->generation, 1);
+
+	for (i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+		pg_atomic_uint64 *counter = NULL;
+
+		if (msg->id >= 0)
+		{
+			switch (msg->cc.id)
+			{
+				case OPEROID:
+				case AMOPOPID:
+				case FOREIGNSERVEROID:
+				case FOREIGNDATAWRAPPEROID:
+
+					/*
+					 * Plans don't record their dependencies on these, which
+					 * is why plancache.c resets everything for them, too.
+					 */
+					counter = &SharedPlanCache->inval_all;
+					break;
+				default:
+					counter = &SharedPlanCache->inval_slots[
+						spc_object_slot(msg->cc.id, msg->cc.hashValue)];
+					break;
+			}
+		}
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+			counter = &SharedPlanCache->inval_all;
+		else if (msg->id == SHAREDINVALRELCACHE_ID)
+		{
+			if (OidIsValid(msg->rc.relId))
+				counter = &SharedPlanCache->inval_slots[
+					spc_relation_slot(msg->rc.relId)];
+			else
+				counter = &SharedPlanCache->inval_all;
+		}
+
+		/* smgr, relmap and snapshot messages don't concern us */
+		if (counter != NULL)
+			spc_advance(counter, generation);
+	}
+}
+
+/*
+ * Attach to the DSA area, if we haven't yet
+ */
+static dsa_area *
+spc_get_area(void)
+{
+	Assert(SharedPlanCache != NULL);
+
+	if (spc_area == NULL)
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+		spc_area = dsa_attach_in_place((char *) SharedPlanCache +
+									   MAXALIGN(sizeof(SharedPlanCacheControl)),
+									   NULL);
+		dsa_pin_mapping(spc_area);
+		on_shmem_exit(spc_release_area, (Datum) 0);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	return spc_area;
+}
+
+/*
+ * on_shmem_exit callback to drop our reference to the DSA area
+ */
+static void
+spc_release_area(int code, Datum arg)
+{
+	dsa_release_in_place((char *) SharedPlanCache +
+						 MAXALIGN(sizeof(SharedPlanCacheControl)));
+	spc_area = NULL;
+}
+
+/*
+ * Evict the least recently used entry.  Returns false if there are no
+ * entries left.  Caller must hold the lock exclusively.
+ */
+static bool
+spc_evict_one(dsa_area *area)
+{
+	HASH_SEQ_STATUS status;
+	SharedPlanCacheEntry *entry;
+	SharedPlanCacheEntry *victim = NULL;
+	uint64		victim_last_used = PG_UINT64_MAX;
+
+	hash_seq_init(&status, SharedPlanCacheHash);
+	while ((entry = (SharedPlanCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		uint64		last_used = pg_atomic_read_u64(&entry->last_used);
+
+		if (last_used < victim_last_used)
+		{
+			victim = entry;
+			victim_last_used = last_used;
+		}
+	}
+
+	if (victim == NULL)
+		return false;
+
+	spc_remove_entry(area, victim);
+	return true;
+}
+
+/*
+ * Remove an entry and free its chunk.  Caller must hold the lock exclusively.
+ */
+static void
+spc_remove_entry(dsa_area *area, SharedPlanCacheEntry *entry)
+{
+	dsa_free(area, entry->chunk);
+	hash_search(SharedPlanCacheHash, &entry->hashkey, HASH_REMOVE, NULL);
+}
+
+/*
+ * Dependency slot of a relation
+ */
+static uint32
+spc_relation_slot(Oid relid)
+{
+	return murmurhash32((uint32) relid) % SHARED_PLAN_CACHE_INVAL_SLOTS;
+}
+
+/*
+ * Dependency slot of a syscache entry, identified as in a PlanInvalItem
+ */
+static uint32
+spc_object_slot(int cacheid, uint32 hashvalue)
+{
+	return hash_combine(murmurhash32((uint32) cacheid), hashvalue) %
+		SHARED_PLAN_CACHE_INVAL_SLOTS;
+}
+
+/*
+ * Map the given dependencies to a palloc'd array of distinct slot numbers,
+ * and set *nslots to its length.
+ */
+static uint32 *
+spc_dependency_slots(List *relationOids, List *invalItems, int *nslots)
+{
+	uint32	   *slots;
+	int			n = 0;
+	int			i;
+	ListCell   *lc;
+
+	slots = (uint32 *) palloc((list_length(relationOids) +
+							   list_length(invalItems) + 1) * sizeof(uint32));
+
+	foreach(lc, relationOids)
+		slots[n++] = spc_relation_slot(lfirst_oid(lc));
+	foreach(lc, invalItems)
+	{
+		PlanInvalItem *item = lfirst_node(PlanInvalItem, lc);
+
+		slots[n++] = spc_object_slot(item->cacheId, item->hashValue);
+	}
+
+	if (n > 1)
+	{
+		int			nunique = 1;
+
+		qsort(slots, n, sizeof(uint32), spc_slot_cmp);
+		for (i = 1; i < n; i++)
+		{
+			if (slots[i] != slots[nunique - 1])
+				slots[nunique++] = slots[i];
+		}
+		n = nunique;
+	}
+
+	*nslots = n;
+	return slots;
+}
+
+/*
+ * Have none of the given slots, nor everything, been invalidated after
+ * 'generation'?
+ */
+static bool
+spc_slots_current(const uint32 *slots, int nslots, uint64 generation)
+{
+	int			i;
+
+	pg_read_barrier();
+
+	if (pg_atomic_read_u64(&SharedPlanCache->inval_all) > generation)
+		return false;
+
+	for (i = 0; i < nslots; i++)
+	{
+		if (pg_atomic_read_u64(&SharedPlanCache->inval_slots[slots[i]]) >
+			generation)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Advance an invalidation counter to 'generation', unless a concurrent
+ * invalidation has already advanced it further.
+ */
+static void
+spc_advance(pg_atomic_uint64 *counter, uint64 generation)
+{
+	uint64		old = pg_atomic_read_u64(counter);
+
+	while (old < generation)
+	{
+		if (pg_atomic_compare_exchange_u64(counter, &old, generation))
+			break;
+	}
+}
+
+/*
+ * qsort comparator for slot numbers
+ */
+static int
+spc_slot_cmp(const void *a, const void *b)
+{
+	uint32		sa = *(const uint32 *) a;
+	uint32		sb = *(const uint32 *) b;
+
+	if (sa < sb)
+		return -1;
+	if (sa > sb)
+		return 1;
+	return 0;
+}
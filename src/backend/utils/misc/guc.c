@@ -90,6 +90,7 @@
 #include "utils/portal.h"
 #include "utils/ps_status.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/tzparser.h"
 #include "utils/varlena.h"
@@ -512,6 +513,7 @@ double		log_statement_sample_rate = 1.0;
 int			trace_recovery_messages = LOG;
 
 int			temp_file_limit = -1;
+bool		temp_file_compression = false;
 
 int			num_temp_buffers = 1024;
 
@@ -935,6 +937,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_incremental_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of incremental sort steps."),
+			NULL
+		},
+		&enable_incremental_sort,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of hashed aggregation plans."),
@@ -953,6 +964,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_resultcache", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of result caching."),
+			NULL
+		},
+		&enable_resultcache,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_nestloop", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of nested-loop join plans."),
@@ -980,6 +1000,24 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_bloom_pushdown", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables pushing hash join bloom filters down to the outer scan."),
+			NULL
+		},
+		&enable_bloom_pushdown,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"enable_batch_qual", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables evaluating simple scan quals a page at a time."),
+			NULL
+		},
+		&enable_batch_qual,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_gathermerge", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of gather merge plans."),
@@ -1016,6 +1054,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_async_append", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of async append plans."),
+			NULL
+		},
+		&enable_async_append,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_parallel_hash", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of parallel hash plans."),
@@ -1025,6 +1072,24 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_parallel_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel hashed aggregation plans."),
+			NULL
+		},
+		&enable_parallel_hashagg,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"enable_parallel_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel sort plans."),
+			NULL
+		},
+		&enable_parallel_sort,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_partition_pruning", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable plan-time and run-time partition pruning."),
@@ -1826,6 +1891,16 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"temp_file_compression", PGC_USERSET, RESOURCES_DISK,
+			gettext_noop("Compresses temporary files written by hash joins and hash aggregation."),
+			NULL
+		},
+		&temp_file_compression,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"jit", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Allow JIT compilation."),
@@ -2327,6 +2402,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"shared_plan_cache_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the amount of shared memory used to share prepared statement plans between sessions."),
+			gettext_noop("Zero disables the shared plan cache."),
+			GUC_UNIT_KB
+		},
+		&shared_plan_cache_size,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 #ifdef LOCK_DEBUG
 	{
 		{"trace_lock_oidmin", PGC_SUSET, DEVELOPER_OPTIONS,
@@ -8920,6 +9006,60 @@ GetNumConfigOptions(void)
 	return num_guc_variables;
 }
 
+/*
+ * Return a palloc'd string describing the current values of the variables
+ * that can affect the plans the planner makes.  Two such strings are equal
+ * only if all those variables have the same values.
+ *
+ * That covers all the query tuning variables, and a few others that the
+ * planner consults.
+ */
+char *
+GetPlannerSettings(void)
+{
+	static const char *const other_planner_vars[] = {
+		"jit_expressions",
+		"jit_tuple_deforming",
+		"max_parallel_workers_per_gather",
+		"parallel_leader_participation",
+		"work_mem",
+		NULL
+	};
+	StringInfoData buf;
+	int			i;
+
+	initStringInfo(&buf);
+
+	for (i = 0; i < num_guc_variables; i++)
+	{
+		struct config_generic *conf = guc_variables[i];
+		char	   *value;
+
+		if (conf->group != QUERY_TUNING &&
+			conf->group != QUERY_TUNING_METHOD &&
+			conf->group != QUERY_TUNING_COST &&
+			conf->group != QUERY_TUNING_GEQO &&
+			conf->group != QUERY_TUNING_OTHER)
+		{
+			const char *const *name;
+
+			for (name = other_planner_vars; *name != NULL; name++)
+			{
+				if (guc_name_compare(conf->name, *name) == 0)
+					break;
+			}
+			if (*name == NULL)
+				continue;
+		}
+
+		value = _ShowOption(conf, false);
+		appendStringInfo(&buf, "%s=%s\n", conf->name, value);
+		pfree(value);
+	}
+
+	return buf.data;
+}
+
 /*
  * show_config_by_name - equiv to SHOW X command but implemented as
  * a function.
@@ -285,6 +285,9 @@ ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 static bool
 ltsReadFillBuffer(LogicalTapeSet *lts, LogicalTape *lt)
 {
+	long		prevblocknum = -1L;
+	bool		consecutive = true;
+
 	lt->pos = 0;
 	lt->nbytes = 0;
 
@@ -299,6 +302,10 @@ ltsReadFillBuffer(LogicalTapeSet *lts, LogicalTape *lt)
 		/* Apply worker offset, needed for leader tapesets */
 		datablocknum += lt->offsetBlockNumber;
 
+		if (prevblocknum != -1L && datablocknum != prevblocknum + 1)
+			consecutive = false;
+		prevblocknum = datablocknum;
+
 		/* Read the block */
 		ltsReadBlock(lts, datablocknum, (void *) thisbuf);
 		if (!lt->frozen)
@@ -318,6 +325,24 @@ ltsReadFillBuffer(LogicalTapeSet *lts, LogicalTape *lt)
 		/* Advance to next block, if we have buffer space left */
 	} while (lt->buffer_size - lt->nbytes > BLCKSZ);
 
+	/*
+	 * Start reading ahead what the next call will need, so that the I/O
+	 * overlaps with consuming this buffer.  Only the next block's number is
+	 * known, as the rest are chained from it, but a tape's blocks are mostly
+	 * allocated consecutively.  If the ones we just read were, bet on that
+	 * continuing, and prefetch a whole buffer's worth.
+	 */
+	if (lt->nextBlockNumber != -1L)
+	{
+		long		nextblocknum = lt->nextBlockNumber + lt->offsetBlockNumber;
+		int			nblocks = 1;
+
+		if (consecutive && nextblocknum == prevblocknum + 1)
+			nblocks = Max(lt->buffer_size / BLCKSZ, 1);
+
+		BufFilePrefetchBlocks(lts->pfile, nextblocknum, nblocks);
+	}
+
 	return (lt->nbytes > 0);
 }
 
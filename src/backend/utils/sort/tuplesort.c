@@ -226,6 +226,25 @@ typedef enum
 typedef int (*SortTupleComparator) (const SortTuple *a, const SortTuple *b,
 									Tuplesortstate *state);
 
+/*
+ * Radix sorting of the in-memory tuple array, see radix_sort_memtuples().
+ *
+ * RADIX_SORT_THRESHOLD is the minimum number of tuples to radix sort, as for
+ * smaller inputs the counting passes don't pay off.  Partitions that get
+ * smaller than RADIX_QSORT_THRESHOLD during the sort are finished with
+ * quicksort, for the same reason.
+ */
+#define RADIX_SORT_THRESHOLD	1024
+#define RADIX_QSORT_THRESHOLD	64
+
+/* How the leading key's datum1 maps onto an unsigned radix key */
+typedef enum
+{
+	RADIX_KEY_UNSIGNED,			/* Datum compares as unsigned */
+	RADIX_KEY_SIGNED,			/* Datum compares as int64 */
+	RADIX_KEY_INT32				/* Datum compares as int32 */
+} RadixKeyKind;
+
 /*
  * Private state of a Tuplesort operation.
  */
@@ -419,6 +438,13 @@ struct Tuplesortstate
 	 */
 	SortSupport onlyKey;
 
+	/*
+	 * Radix sort parameters for the current in-memory sort, set up by
+	 * radix_sort_applicable().
+	 */
+	RadixKeyKind radixKind;		/* how to interpret datum1 */
+	int			radixBytes;		/* number of significant bytes in datum1 */
+
 	/*
 	 * Additional state for managing "abbreviated key" sortsupport routines
 	 * (which currently may be used by all cases except the hash index case).
@@ -605,6 +631,12 @@ static void dumptuples(Tuplesortstate *state, bool alltuples);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
 static void tuplesort_sort_memtuples(Tuplesortstate *state);
+static bool radix_sort_applicable(Tuplesortstate *state);
+static void radix_sort_memtuples(Tuplesortstate *state);
+static void radix_sort_tuple(Tuplesortstate *state, SortTuple *begin,
+				 size_t n, int level);
+static void sort_tuple_ties(Tuplesortstate *state, SortTuple *begin,
+				size_t n);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_delete_top(Tuplesortstate *state);
@@ -3312,8 +3344,12 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/* Can we sort on the leading key's bits rather than by comparing? */
+		if (state->memtupcount >= RADIX_SORT_THRESHOLD &&
+			radix_sort_applicable(state))
+			radix_sort_memtuples(state);
 		/* Can we use the single-key sort function? */
-		if (state->onlyKey != NULL)
+		else if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
 					   state->onlyKey);
 		else
@@ -3324,6 +3360,243 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 	}
 }
 
+/*
+ * Can the in-memory tuples be radix sorted on datum1?
+ *
+ * That's the case if the leading key's comparator is one of the
+ * ssup_datum_*_cmp() functions, which means the order of datum1 values is
+ * that of plain integers, whether they're the values themselves or
+ * abbreviated keys.  If so, also set up state->radixKind and radixBytes.
+ */
+static bool
+radix_sort_applicable(Tuplesortstate *state)
+{
+	SortSupport ssup = state->sortKeys;
+
+	/* hash index builds don't sort on a SortSupport key */
+	if (ssup == NULL)
+		return false;
+
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+	{
+		state->radixKind = RADIX_KEY_UNSIGNED;
+		state->radixBytes = SIZEOF_DATUM;
+	}
+#if SIZEOF_DATUM >= 8
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+	{
+		state->radixKind = RADIX_KEY_SIGNED;
+		state->radixBytes = 8;
+	}
+#endif
+	else if (ssup->comparator == ssup_datum_int32_cmp)
+	{
+		state->radixKind = RADIX_KEY_INT32;
+		state->radixBytes = 4;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * Map a non-NULL datum1 onto an unsigned integer with the same ordering,
+ * accounting for the sort direction.
+ */
+static inline uint64
+radix_sort_key(Tuplesortstate *state, Datum datum1)
+{
+	uint64		key;
+
+	switch (state->radixKind)
+	{
+		case RADIX_KEY_UNSIGNED:
+			key = (uint64) datum1;
+			break;
+		case RADIX_KEY_SIGNED:
+			/* flip the sign bit, so negative values sort first */
+			key = (uint64) DatumGetInt64(datum1) ^ (UINT64CONST(1) << 63);
+			break;
+		case RADIX_KEY_INT32:
+			key = (uint32) DatumGetInt32(datum1) ^ ((uint32) 1 << 31);
+			break;
+		default:
+			elog(ERROR, "unrecognized radix key kind: %d",
+				 (int) state->radixKind);
+			key = 0;			/* keep compiler quiet */
+			break;
+	}
+
+	if (state->sortKeys->ssup_reverse)
+		key = ~key;
+
+	return key;
+}
+
+/* Extract the byte of the radix key to partition on at the given level */
+static inline int
+radix_sort_byte(Tuplesortstate *state, const SortTuple *stup, int level)
+{
+	return (radix_sort_key(state, stup->datum1) >> (level * 8)) & 0xFF;
+}
+
+/*
+ * Sort the in-memory tuples by radix sorting on the leading key's datum1.
+ *
+ * The tuples are first split into the NULL and non-NULL ones for the
+ * leading key, putting the NULLs where the sort order wants them.  The
+ * non-NULLs are then sorted with an in-place most-significant-digit radix
+ * sort, one byte of datum1 per level.  Tuples whose datum1 is equal are
+ * ordered by the full comparator, if the leading key doesn't decide the
+ * order by itself.
+ */
+static void
+radix_sort_memtuples(Tuplesortstate *state)
+{
+	SortTuple  *memtuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	size_t		nnulls = 0;
+	SortTuple  *notnull;
+	size_t		i;
+
+	if (state->sortKeys->ssup_nulls_first)
+	{
+		/* move NULLs to the front */
+		for (i = 0; i < n; i++)
+		{
+			if (memtuples[i].isnull1)
+			{
+				SortTuple	tmp = memtuples[i];
+
+				memtuples[i] = memtuples[nnulls];
+				memtuples[nnulls++] = tmp;
+			}
+		}
+		sort_tuple_ties(state, memtuples, nnulls);
+		notnull = memtuples + nnulls;
+	}
+	else
+	{
+		/* move NULLs to the back */
+		for (i = n; i > 0; i--)
+		{
+			if (memtuples[i - 1].isnull1)
+			{
+				SortTuple	tmp = memtuples[i - 1];
+
+				nnulls++;
+				memtuples[i - 1] = memtuples[n - nnulls];
+				memtuples[n - nnulls] = tmp;
+			}
+		}
+		sort_tuple_ties(state, memtuples + n - nnulls, nnulls);
+		notnull = memtuples;
+	}
+
+	radix_sort_tuple(state, notnull, n - nnulls, state->radixBytes - 1);
+}
+
+/*
+ * Radix sort a partition of non-NULL tuples that agree on all bytes of the
+ * radix key above "level".
+ *
+ * This is an American flag sort: count the tuples per value of the current
+ * byte, then permute them into their buckets in place, and recurse into
+ * each bucket for the next byte.
+ */
+static void
+radix_sort_tuple(Tuplesortstate *state, SortTuple *begin, size_t n, int level)
+{
+	size_t		counts[256];
+	size_t		next[256];
+	size_t		ends[256];
+	size_t		offset;
+	size_t		i;
+	int			b;
+
+	if (n < RADIX_QSORT_THRESHOLD)
+	{
+		if (state->onlyKey != NULL)
+			qsort_ssup(begin, n, state->onlyKey);
+		else
+			qsort_tuple(begin, n, state->comparetup, state);
+		return;
+	}
+
+	CHECK_FOR_INTERRUPTS();
+
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < n; i++)
+		counts[radix_sort_byte(state, &begin[i], level)]++;
+
+	offset = 0;
+	for (b = 0; b < 256; b++)
+	{
+		next[b] = offset;
+		offset += counts[b];
+		ends[b] = offset;
+	}
+
+	/*
+	 * Permute the tuples into their buckets, unless they're all in one
+	 * already.  Each tuple is swapped directly into the next free position
+	 * of its bucket, until the one landing in the current position belongs
+	 * there.
+	 */
+	if (counts[radix_sort_byte(state, &begin[0], level)] != n)
+	{
+		for (b = 0; b < 256; b++)
+		{
+			while (next[b] < ends[b])
+			{
+				SortTuple	tmp = begin[next[b]];
+				int			tb = radix_sort_byte(state, &tmp, level);
+
+				while (tb != b)
+				{
+					SortTuple	tmp2 = begin[next[tb]];
+
+					begin[next[tb]++] = tmp;
+					tmp = tmp2;
+					tb = radix_sort_byte(state, &tmp, level);
+				}
+				begin[next[b]++] = tmp;
+			}
+		}
+	}
+
+	/* Sort the buckets on the next byte, or break ties if none is left */
+	offset = 0;
+	for (b = 0; b < 256; b++)
+	{
+		if (counts[b] > 1)
+		{
+			if (level > 0)
+				radix_sort_tuple(state, begin + offset, counts[b], level - 1);
+			else
+				sort_tuple_ties(state, begin + offset, counts[b]);
+		}
+		offset += counts[b];
+	}
+}
+
+/*
+ * Sort tuples whose leading keys are equal (or all NULL).
+ *
+ * With a single key that isn't abbreviated there's nothing left to do;
+ * otherwise the comparator decides, starting with the leading key again,
+ * which takes care of abbreviated keys.
+ */
+static void
+sort_tuple_ties(Tuplesortstate *state, SortTuple *begin, size_t n)
+{
+	if (n < 2 || state->onlyKey != NULL)
+		return;
+
+	qsort_tuple(begin, n, state->comparetup, state);
+}
+
 /*
  * Insert a new tuple into an empty or existing heap, maintaining the
  * heap invariant.  Caller is responsible for ensuring there's room.
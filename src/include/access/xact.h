@@ -429,5 +429,7 @@ extern void ParseAbortRecord(uint8 info, xl_xact_abort *xlrec, xl_xact_parsed_ab
 extern void EnterParallelMode(void);
 extern void ExitParallelMode(void);
 extern bool IsInParallelMode(void);
+extern void AllowParallelWorkerInserts(void);
+extern bool ParallelWorkerInsertsAllowed(void);
 
 #endif							/* XACT_H */
@@ -208,6 +208,18 @@
 #define unlikely(x) ((x) != 0)
 #endif
 
+/*
+ * Hint to the compiler that the memory at address "a" will be read soon, so
+ * that the cache line can be fetched while other work proceeds.  Like the
+ * branch hints above, this should only be used in hot code paths where
+ * cache misses are known to matter.
+ */
+#if __GNUC__ >= 3
+#define pg_prefetch_mem(a)	__builtin_prefetch(a)
+#else
+#define pg_prefetch_mem(a)	((void) (a))
+#endif
+
 /*
  * CppAsString
  *		Convert the argument to a string, using the C preprocessor.
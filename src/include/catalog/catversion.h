@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201902161
+#define CATALOG_VERSION_NO	201902162
 
 #endif
@@ -0,0 +1,94 @@
+/*-------------------------------------------------------------------------
+ * execBatch.h
+ *		Batch evaluation of simple scan quals
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/executor/execBatch.h
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef EXECBATCH_H
+#define EXECBATCH_H
+
+#include "access/htup.h"
+#include "nodes/execnodes.h"
+#include "nodes/primnodes.h"
+
+/* Comparison performed by a batch qual clause */
+typedef enum BatchCmpOp
+{
+	BATCH_CMP_EQ,
+	BATCH_CMP_NE,
+	BATCH_CMP_LT,
+	BATCH_CMP_LE,
+	BATCH_CMP_GT,
+	BATCH_CMP_GE
+} BatchCmpOp;
+
+/* How a column's datums are converted into the batch arrays */
+typedef enum BatchColType
+{
+	BATCH_COL_INT2,
+	BATCH_COL_INT4,
+	BATCH_COL_INT8,
+	BATCH_COL_FLOAT4,
+	BATCH_COL_FLOAT8
+} BatchColType;
+
+/*
+ * One column referenced by the batch quals.  Integer types are widened to
+ * int64 and float types to float8, so that cross-type comparisons need no
+ * special handling.
+ */
+typedef struct BatchQualColumn
+{
+	AttrNumber	attno;			/* attribute number in the scan tuple */
+	BatchColType type;
+	bool		isfloat;		/* values are in fvals, rather than ivals */
+	int64	   *ivals;			/* per-tuple values, if integer */
+	float8	   *fvals;			/* per-tuple values, if float */
+	bool	   *nulls;			/* per-tuple null flags */
+} BatchQualColumn;
+
+/* A "Var op Const" comparison, as recognized by ExecGetSimpleCompare */
+typedef struct SimpleCompare
+{
+	Var		   *var;
+	BatchColType coltype;		/* how to fetch the Var's values */
+	BatchCmpOp	op;
+	int64		ival;			/* comparison constant, if integer */
+	float8		fval;			/* comparison constant, if float */
+} SimpleCompare;
+
+/* One "column op constant" clause */
+typedef struct BatchQualClause
+{
+	int			colno;			/* index into BatchQual->columns */
+	BatchCmpOp	op;
+	int64		ival;			/* comparison constant, if integer */
+	float8		fval;			/* comparison constant, if float */
+} BatchQualClause;
+
+typedef struct BatchQual
+{
+	int			ncolumns;
+	BatchQualColumn *columns;
+	int			nclauses;
+	BatchQualClause *clauses;
+	AttrNumber	maxattno;		/* highest attno we need to deform */
+	TupleTableSlot *slot;		/* scratch slot used for deforming */
+	int			maxtuples;		/* allocated length of the column arrays */
+	int			ntuples;		/* number of tuples in the current batch */
+} BatchQual;
+
+extern bool ExecGetSimpleCompare(Expr *clause, SimpleCompare *cmp);
+extern BatchQual *ExecInitBatchQual(List *qual, ScanState *node,
+				  int maxtuples, List **residual);
+extern void ExecBatchQualReset(BatchQual *bq);
+extern void ExecBatchQualAddTuple(BatchQual *bq, HeapTuple tuple);
+extern int	ExecBatchQualEval(BatchQual *bq, uint16 *sel);
+
+#endif							/* EXECBATCH_H */
@@ -14,6 +14,7 @@
 #ifndef EXEC_EXPR_H
 #define EXEC_EXPR_H
 
+#include "executor/execBatch.h"
 #include "executor/nodeAgg.h"
 #include "nodes/execnodes.h"
 
@@ -91,6 +92,13 @@ typedef enum ExprEvalOp
 	EEOP_FUNCEXPR_FUSAGE,
 	EEOP_FUNCEXPR_STRICT_FUSAGE,
 
+	/*
+	 * Compare a scan Var with a constant directly, in place of the SCAN_VAR,
+	 * CONST and FUNCEXPR_STRICT steps the comparison would otherwise need.
+	 * Only used for the comparisons recognized by ExecGetSimpleCompare().
+	 */
+	EEOP_SCAN_VAR_CMP_CONST,
+
 	/*
 	 * Evaluate boolean AND expression, one step per subexpression. FIRST/LAST
 	 * subexpressions are special-cased for performance.  Since AND always has
@@ -220,11 +228,31 @@ typedef enum ExprEvalOp
 	EEOP_SUBPLAN,
 	EEOP_ALTERNATIVE_SUBPLAN,
 
+	/*
+	 * Common subexpression memoization: RESET forgets all remembered values
+	 * at the start of an evaluation; LOAD fetches a subexpression's value if
+	 * it has already been computed, and jumps past its evaluation; STORE
+	 * remembers the value once computed.
+	 */
+	EEOP_CSE_RESET,
+	EEOP_CSE_LOAD,
+	EEOP_CSE_STORE,
+
+	/*
+	 * Compute a hash value over a set of keys: SET_INITVAL sets the starting
+	 * value, each NEXT32 step rotates it and XORs in the hash of one key.
+	 * The _STRICT variant returns NULL if the key is NULL.
+	 */
+	EEOP_HASHDATUM_SET_INITVAL,
+	EEOP_HASHDATUM_NEXT32,
+	EEOP_HASHDATUM_NEXT32_STRICT,
+
 	/* aggregation related nodes */
 	EEOP_AGG_STRICT_DESERIALIZE,
 	EEOP_AGG_DESERIALIZE,
 	EEOP_AGG_STRICT_INPUT_CHECK_ARGS,
 	EEOP_AGG_STRICT_INPUT_CHECK_NULLS,
+	EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
 	EEOP_AGG_INIT_TRANS,
 	EEOP_AGG_STRICT_TRANS_CHECK,
 	EEOP_AGG_PLAIN_TRANS_BYVAL,
@@ -324,6 +352,50 @@ typedef struct ExprEvalStep
 			int			nargs;	/* number of arguments */
 		}			func;
 
+		/* for EEOP_SCAN_VAR_CMP_CONST */
+		struct
+		{
+			int			attnum; /* attr number - 1 */
+			Oid			vartype;	/* type OID of variable */
+			BatchColType coltype;	/* how to interpret the Var's datum */
+			BatchCmpOp	op;
+			int64		ival;	/* comparison constant, if integer */
+			float8		fval;	/* comparison constant, if float */
+		}			cmpconst;
+
+		/* for EEOP_CSE_RESET */
+		struct
+		{
+			bool	   *valid;	/* array of "value computed" flags */
+			int			ncse;	/* length of the array */
+		}			cse_reset;
+
+		/* for EEOP_CSE_LOAD / EEOP_CSE_STORE */
+		struct
+		{
+			Datum	   *value;	/* remembered value */
+			bool	   *isnull;
+			bool	   *valid;	/* has value been computed yet? */
+			int			jumpdone;	/* LOAD: jump here if valid */
+			bool		make_ro;	/* STORE: force value to R/O? */
+		}			cse;
+
+		/* for EEOP_HASHDATUM_SET_INITVAL */
+		struct
+		{
+			Datum		init_value;
+		}			hashdatum_initvalue;
+
+		/* for EEOP_HASHDATUM_NEXT32[_STRICT] */
+		struct
+		{
+			FmgrInfo   *finfo;	/* hash function's lookup data */
+			FunctionCallInfo fcinfo_data;	/* key value is in args[0] */
+			/* faster to access without additional indirection: */
+			PGFunction	fn_addr;	/* actual call address */
+			int			jumpdone;	/* STRICT: jump here if key is NULL */
+		}			hashdatum;
+
 		/* for EEOP_BOOL_*_STEP */
 		struct
 		{
@@ -622,6 +694,13 @@ typedef struct ExprEvalStep
 			int			jumpnull;
 		}			agg_strict_input_check;
 
+		/* for EEOP_AGG_PLAIN_PERGROUP_NULLCHECK */
+		struct
+		{
+			int			setoff;
+			int			jumpnull;
+		}			agg_plain_pergroup_nullcheck;
+
 		/* for EEOP_AGG_INIT_TRANS */
 		struct
 		{
@@ -713,6 +792,12 @@ extern void ExecEvalFuncExprFusage(ExprState *state, ExprEvalStep *op,
 					   ExprContext *econtext);
 extern void ExecEvalFuncExprStrictFusage(ExprState *state, ExprEvalStep *op,
 							 ExprContext *econtext);
+extern void ExecEvalScanVarCmpConst(ExprState *state, ExprEvalStep *op,
+						ExprContext *econtext);
+extern void ExecEvalCSEReset(ExprState *state, ExprEvalStep *op,
+				 ExprContext *econtext);
+extern void ExecEvalCSEStore(ExprState *state, ExprEvalStep *op,
+				 ExprContext *econtext);
 extern void ExecEvalParamExec(ExprState *state, ExprEvalStep *op,
 				  ExprContext *econtext);
 extern void ExecEvalParamExtern(ExprState *state, ExprEvalStep *op,
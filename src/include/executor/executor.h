@@ -136,6 +136,11 @@ extern TupleHashTable BuildTupleHashTableExt(PlanState *parent,
 extern TupleHashEntry LookupTupleHashEntry(TupleHashTable hashtable,
 					 TupleTableSlot *slot,
 					 bool *isnew);
+extern uint32 TupleHashTableHash(TupleHashTable hashtable,
+				   TupleTableSlot *slot);
+extern TupleHashEntry LookupTupleHashEntryHash(TupleHashTable hashtable,
+						 TupleTableSlot *slot,
+						 bool *isnew, uint32 hash);
 extern TupleHashEntry FindTupleHashEntry(TupleHashTable hashtable,
 				   TupleTableSlot *slot,
 				   ExprState *eqcomp,
@@ -258,6 +263,18 @@ extern ExprState *ExecBuildGroupingEqual(TupleDesc ldesc, TupleDesc rdesc,
 					   const AttrNumber *keyColIdx,
 					   const Oid *eqfunctions,
 					   PlanState *parent);
+extern ExprState *ExecBuildHash32FromAttrs(TupleDesc desc,
+						 const TupleTableSlotOps *ops,
+						 FmgrInfo *hashfunctions,
+						 int numCols,
+						 const AttrNumber *keyColIdx,
+						 uint32 init_value,
+						 PlanState *parent);
+extern ExprState *ExecBuildHash32Expr(List *hash_exprs,
+					const Oid *hashfunc_oids,
+					const bool *reject_nulls,
+					uint32 init_value,
+					PlanState *parent);
 extern ProjectionInfo *ExecBuildProjectionInfo(List *targetList,
 						ExprContext *econtext,
 						TupleTableSlot *slot,
@@ -14,6 +14,7 @@
 #ifndef HASHJOIN_H
 #define HASHJOIN_H
 
+#include "lib/bloomfilter.h"
 #include "nodes/execnodes.h"
 #include "port/atomics.h"
 #include "storage/barrier.h"
@@ -57,6 +58,13 @@
  * inner batch file.  Subsequently, while reading either inner or outer batch
  * files, we might find tuples that no longer belong to the current batch;
  * if so, we just dump them out to the correct batch file.
+ *
+ * Increasing nbatch doesn't help if a batch is dominated by duplicates of a
+ * single hash value.  Once that has been detected, a batch that still
+ * doesn't fit is processed in several "stripes" instead: as many inner
+ * tuples as fit are loaded, the rest are written to a stripe file, and the
+ * outer batch is scanned once per stripe.  (For batch 0 this means the outer
+ * tuples must be written to an outer batch file during the first pass.)
  * ----------------------------------------------------------------
  */
 
@@ -80,6 +88,29 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MinimalTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * Each bucket of the main hash table holds the head of its chain of tuples,
+ * plus a small signature of the hash values found in the chain.  A probe
+ * whose HJ_BUCKET_TAG bit isn't set in the signature can't find a match in
+ * the bucket, so it skips the chain without touching any tuple; with a large
+ * hash table, each of those would likely be a cache miss.  The bucket and
+ * batch numbers are taken from the low-order bits of the hash value, so the
+ * tag is taken from the highest-order ones.
+ */
+typedef struct HashJoinBucketData
+{
+	struct HashJoinTupleData *tuples;	/* head of chain, or NULL */
+	uint32		tags;			/* OR of HJ_BUCKET_TAG() of chain members */
+} HashJoinBucketData;
+
+typedef struct ParallelHashJoinBucket
+{
+	dsa_pointer_atomic tuples;	/* head of chain, or InvalidDsaPointer */
+	pg_atomic_uint32 tags;		/* OR of HJ_BUCKET_TAG() of chain members */
+} ParallelHashJoinBucket;
+
+#define HJ_BUCKET_TAG(hashvalue)	(((uint32) 1) << ((hashvalue) >> 27))
+
 /*
  * If the outer relation's distribution is sufficiently nonuniform, we attempt
  * to optimize the join by treating the hash values corresponding to the outer
@@ -159,6 +190,7 @@ typedef struct ParallelHashJoinBatch
 	size_t		ntuples;		/* number of tuples loaded */
 	size_t		old_ntuples;	/* number of tuples before repartitioning */
 	bool		space_exhausted;
+	bool		skip_unmatched; /* whether to abandon unmatched scan */
 
 	/*
 	 * Variable-sized SharedTuplestore objects follow this struct in memory.
@@ -204,6 +236,7 @@ typedef struct ParallelHashJoinBatchAccessor
 	size_t		old_ntuples;	/* how many tuples before repartitioning? */
 	bool		at_least_one_chunk; /* has this backend allocated a chunk? */
 
+	bool		outer_eof;		/* has this process hit end of batch? */
 	bool		done;			/* flag to remember that a batch is done */
 	SharedTuplestoreAccessor *inner_tuples;
 	SharedTuplestoreAccessor *outer_tuples;
@@ -240,6 +273,7 @@ typedef struct ParallelHashJoinState
 	int			nbuckets;		/* number of buckets */
 	ParallelHashGrowth growth;	/* control batch/bucket growth */
 	dsa_pointer chunk_work_queue;	/* chunk work queue */
+	dsa_pointer bloom_filter;	/* shared bloom filter, if any */
 	int			nparticipants;
 	size_t		space_allowed;
 	size_t		total_tuples;	/* total number of inner tuples */
@@ -265,7 +299,8 @@ typedef struct ParallelHashJoinState
 #define PHJ_BATCH_ALLOCATING			1
 #define PHJ_BATCH_LOADING				2
 #define PHJ_BATCH_PROBING				3
-#define PHJ_BATCH_DONE					4
+#define PHJ_BATCH_SCANNING				4
+#define PHJ_BATCH_DONE					5
 
 /* The phases of batch growth while hashing, for grow_batches_barrier. */
 #define PHJ_GROW_BATCHES_ELECTING		0
@@ -294,9 +329,9 @@ typedef struct HashJoinTableData
 	union
 	{
 		/* unshared array is per-batch storage, as are all the tuples */
-		struct HashJoinTupleData **unshared;
+		HashJoinBucketData *unshared;
 		/* shared array is per-query DSA area, as are all the tuples */
-		dsa_pointer_atomic *shared;
+		ParallelHashJoinBucket *shared;
 	}			buckets;
 
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
@@ -322,13 +357,28 @@ typedef struct HashJoinTableData
 	/*
 	 * These arrays are allocated for the life of the hash join, but only if
 	 * nbatch > 1.  A file is opened only when we first write a tuple into it
-	 * (otherwise its pointer remains NULL).  Note that the zero'th array
-	 * elements never get used, since we will process rather than dump out any
-	 * tuples of batch zero.
+	 * (otherwise its pointer remains NULL).  Note that the zero'th inner
+	 * element never gets used, since we will process rather than dump out any
+	 * tuples of batch zero; the zero'th outer element is only used if batch
+	 * zero has to be processed in stripes.
 	 */
 	BufFile   **innerBatchFile; /* buffered virtual temp file per batch */
 	BufFile   **outerBatchFile; /* buffered virtual temp file per batch */
 
+	/*
+	 * Once growEnabled is off, a batch that doesn't fit in spaceAllowed is
+	 * processed in several stripes: inner tuples that don't fit go to
+	 * stripeFile, and the outer batch is rescanned for each stripe.  To
+	 * emit outer-join and semi/anti join results only once, the match status
+	 * of each outer tuple is remembered in outerMatched, indexed by the
+	 * tuple's position in the outer batch file.
+	 */
+	int			curstripe;		/* current stripe of curbatch; 0 in 1st pass */
+	BufFile    *stripeFile;		/* inner tuples left for later stripes */
+	int64		outerOrdinal;	/* # outer tuples read in current stripe */
+	uint8	   *outerMatched;	/* bitmap of outer tuples known to match */
+	Size		outerMatchedSize;	/* allocated length of outerMatched */
+
 	/*
 	 * Info about the datatype-specific hash functions for the datatypes being
 	 * hashed. These are arrays of the same length as the number of hash join
@@ -344,6 +394,15 @@ typedef struct HashJoinTableData
 	Size		spaceUsedSkew;	/* skew hash table's current space usage */
 	Size		spaceAllowedSkew;	/* upper limit for skew hashtable */
 
+	/*
+	 * Bloom filter over the hash values of all inner tuples, for use by the
+	 * outer scan.  NULL unless the filter was requested and is complete.
+	 * During a Parallel Hash build, bloomBuild holds this backend's partial
+	 * filter until it is merged into the shared one.
+	 */
+	bloom_filter *bloomFilter;
+	bloom_filter *bloomBuild;
+
 	MemoryContext hashCxt;		/* context for whole-hash-join storage */
 	MemoryContext batchCxt;		/* context for this-batch-only storage */
 
@@ -16,6 +16,7 @@
 
 #include "access/tupconvert.h"
 #include "executor/instrument.h"
+#include "lib/ilist.h"
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
@@ -110,6 +111,12 @@ typedef struct ExprState
 
 	Datum	   *innermost_domainval;
 	bool	   *innermost_domainnull;
+
+	/* common subexpressions, and where their values are remembered */
+	List	   *cse_exprs;
+	Datum	   *cse_values;
+	bool	   *cse_nulls;
+	bool	   *cse_valid;
 } ExprState;
 
 
@@ -476,6 +483,9 @@ typedef struct ResultRelInfo
 
 	/* Additional information specific to partition tuple routing */
 	struct PartitionRoutingInfo *ri_PartitionInfo;
+
+	/* For use by copy.c when performing multi-inserts */
+	struct CopyMultiInsertBuffer *ri_CopyMultiInsertBuffer;
 } ResultRelInfo;
 
 /* ----------------
@@ -690,6 +700,7 @@ typedef struct TupleHashTableData
 	AttrNumber *keyColIdx;		/* attr numbers of key columns */
 	FmgrInfo   *tab_hash_funcs; /* hash functions for table datatype(s) */
 	ExprState  *tab_eq_func;	/* comparator for table datatype(s) */
+	ExprState  *tab_hash_expr;	/* computes hash for table datatype(s) */
 	MemoryContext tablecxt;		/* memory context containing table */
 	MemoryContext tempcxt;		/* context for function evaluations */
 	Size		entrysize;		/* actual size to make each hash entry */
@@ -919,6 +930,24 @@ typedef struct DomainConstraintState
  */
 typedef TupleTableSlot *(*ExecProcNodeMtd) (struct PlanState *pstate);
 
+/* ----------------
+ *	 AsyncRequest
+ *
+ * State for an asynchronous tuple request made by one executor node (the
+ * requestor) to another (the requestee).  See execAsync.c.
+ * ----------------
+ */
+typedef struct AsyncRequest
+{
+	struct PlanState *requestor;	/* Node that wants a tuple */
+	struct PlanState *requestee;	/* Node from which a tuple is wanted */
+	int			request_index;	/* Scratch space for requestor */
+	bool		callback_pending;	/* Callback is needed */
+	bool		request_complete;	/* Request complete, result valid */
+	TupleTableSlot *result;		/* Result (NULL or an empty slot if no more
+								 * tuples) */
+} AsyncRequest;
+
 /* ----------------
  *		PlanState node
  *
@@ -946,6 +975,8 @@ typedef struct PlanState
 	/* Per-worker JIT instrumentation */
 	struct SharedJitInstrumentation *worker_jit_instrument;
 
+	bool		async_capable;	/* true if node is async-capable */
+
 	/*
 	 * Common structural data for all Plan types.  These links to subsidiary
 	 * state trees parallel links in the associated plan tree (except for the
@@ -1164,6 +1195,21 @@ struct AppendState
 	struct PartitionPruneState *as_prune_state;
 	Bitmapset  *as_valid_subplans;
 	bool		(*choose_next_subplan) (AppendState *);
+
+	/* Asynchronous execution state; see ExecAppendAsyncBegin */
+	bool		as_begun;		/* false means need to initialize */
+	Bitmapset  *as_asyncplans;	/* asynchronous plans indexes */
+	int			as_nasyncplans; /* # of asynchronous plans */
+	AsyncRequest **as_asyncrequests;	/* array of AsyncRequests */
+	TupleTableSlot **as_asyncresults;	/* unreturned results of async plans */
+	int			as_nasyncresults;	/* # of valid entries in as_asyncresults */
+	bool		as_syncdone;	/* true if all synchronous plans done in
+								 * asynchronous mode, else false */
+	int			as_nasyncremain;	/* # of remaining asynchronous plans */
+	Bitmapset  *as_needrequest; /* asynchronous plans needing a new request */
+	struct WaitEventSet *as_eventset;	/* WaitEventSet used to configure file
+										 * descriptor wait events */
+	Bitmapset  *as_valid_asyncplans;	/* valid asynchronous plans indexes */
 };
 
 /* ----------------
@@ -1275,12 +1321,26 @@ typedef struct ScanState
 
 /* ----------------
  *	 SeqScanState information
+ *
+ *		bloomkeys			ExprStates of the pushed-down hash join keys
+ *		bloomsource			hash join whose hash table supplies the filter
+ *		batchqual			quals evaluated a page at a time, or NULL
+ *		batchblock			block the batchpass flags were computed for
+ *		batchpass			per visible tuple of batchblock: passed quals?
  * ----------------
  */
+struct HashJoinState;
+struct BatchQual;
+
 typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
 	Size		pscan_len;		/* size of parallel heap scan descriptor */
+	List	   *bloomkeys;
+	struct HashJoinState *bloomsource;
+	struct BatchQual *batchqual;
+	BlockNumber batchblock;
+	bool	   *batchpass;
 } SeqScanState;
 
 /* ----------------
@@ -1840,6 +1900,7 @@ typedef struct MergeJoinState
  *		hj_OuterHashKeys		the outer hash keys in the hashjoin condition
  *		hj_InnerHashKeys		the inner hash keys in the hashjoin condition
  *		hj_HashOperators		the join operators in the hashjoin condition
+ *		hj_OuterHash			computes the hash value of an outer tuple
  *		hj_HashTable			hash table for the hashjoin
  *								(NULL if table not built yet)
  *		hj_CurHashValue			hash value for current outer tuple
@@ -1871,16 +1932,23 @@ typedef struct HashJoinState
 	List	   *hj_OuterHashKeys;	/* list of ExprState nodes */
 	List	   *hj_InnerHashKeys;	/* list of ExprState nodes */
 	List	   *hj_HashOperators;	/* list of operator OIDs */
+	ExprState  *hj_OuterHash;	/* see ExecBuildHash32Expr() */
 	HashJoinTable hj_HashTable;
 	uint32		hj_CurHashValue;
 	int			hj_CurBucketNo;
 	int			hj_CurSkewBucketNo;
 	HashJoinTuple hj_CurTuple;
+	int64		hj_CurOuterOrdinal; /* position in outer batch file, or -1 */
 	TupleTableSlot *hj_OuterTupleSlot;
 	TupleTableSlot *hj_HashTupleSlot;
 	TupleTableSlot *hj_NullOuterTupleSlot;
 	TupleTableSlot *hj_NullInnerTupleSlot;
 	TupleTableSlot *hj_FirstOuterTupleSlot;
+	TupleTableSlot **hj_PrefetchSlots;	/* outer tuples read ahead */
+	uint32	   *hj_PrefetchHashValues;	/* ... and their hash values */
+	int			hj_PrefetchCount;	/* number of tuples read ahead */
+	int			hj_PrefetchNext;	/* next one to return */
+	bool		hj_PrefetchDone;	/* end of batch reached while reading ahead */
 	int			hj_JoinState;
 	bool		hj_MatchedOuter;
 	bool		hj_OuterNotEmpty;
@@ -1909,6 +1977,66 @@ typedef struct MaterialState
 	Tuplestorestate *tuplestorestate;
 } MaterialState;
 
+struct ResultCacheEntry;
+struct ResultCacheTuple;
+struct ResultCacheKey;
+
+/* ----------------
+ *	 Instrumentation information for ResultCache
+ * ----------------
+ */
+typedef struct ResultCacheInstrumentation
+{
+	uint64		cache_hits;		/* number of rescans where we've found the
+								 * scan parameter values to be cached */
+	uint64		cache_misses;	/* number of rescans where we've not found the
+								 * scan parameter values to be cached. */
+	uint64		cache_evictions;	/* number of cache entries removed due to
+									 * the need to free memory */
+	uint64		cache_overflows;	/* number of times we've had to bypass the
+									 * cache when filling it due to not being
+									 * able to free enough space to store the
+									 * current scan's tuples. */
+	uint64		mem_peak;		/* peak memory usage in bytes */
+} ResultCacheInstrumentation;
+
+/* ----------------
+ *	 ResultCacheState information
+ *
+ *		resultcache nodes are used to cache recent and commonly seen results
+ *		from a parameterized scan.
+ * ----------------
+ */
+typedef struct ResultCacheState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	int			rc_status;		/* value of ExecResultCache state machine */
+	int			nkeys;			/* number of cache keys */
+	struct resultcache_hash *hashtable; /* hash table for cache entries */
+	TupleDesc	hashkeydesc;	/* tuple descriptor for cache keys */
+	TupleTableSlot *tableslot;	/* min tuple slot for existing cache entries */
+	TupleTableSlot *probeslot;	/* virtual slot used for hash lookups */
+	ExprState  *cache_eq_expr;	/* Compare exec params to hash key */
+	ExprState **param_exprs;	/* exprs containing the parameters to this
+								 * node */
+	FmgrInfo   *hashfunctions;	/* lookup data for hash funcs nkeys in size */
+	uint64		mem_used;		/* bytes of memory used by cache */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	MemoryContext tableContext; /* memory context to store cache data */
+	dlist_head	lru_list;		/* least recently used entry list */
+	struct ResultCacheTuple *last_tuple;	/* Used to point to the last tuple
+											 * returned during a cache hit and
+											 * the tuple we last stored when
+											 * populating the cache. */
+	struct ResultCacheEntry *entry; /* the entry that 'last_tuple' belongs to
+									 * or NULL if 'last_tuple' is NULL. */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first tuple. */
+	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
+								 * param_exprs */
+	ResultCacheInstrumentation stats;	/* execution statistics */
+} ResultCacheState;
+
 /* ----------------
  *	 Shared memory container for per-worker sort information
  * ----------------
@@ -1935,8 +2063,52 @@ typedef struct SortState
 	void	   *tuplesortstate; /* private state of tuplesort.c */
 	bool		am_worker;		/* are we a worker? */
 	SharedSortInfo *shared_info;	/* one entry per worker */
+	/* these fields are used only for a parallel-aware sort */
+	struct ParallelSortState *pstate;	/* shared state in DSM */
+	SortSupport sortkeys;		/* for comparing tuples by all sort keys */
+	Datum	   *range_bounds;	/* bounds of the key ranges, in sort order */
+	int			nrange_bounds;	/* number of bounds (ranges minus one) */
+	struct SortMergeRun *merge_runs;	/* runs we're merging our ranges from */
+	int			nmerge_runs;	/* number of runs in merge_runs */
+	struct binaryheap *merge_heap;	/* merge_runs indexes, by next tuple */
+	bool		merge_started;	/* has the first merged tuple been returned? */
 } SortState;
 
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *		Tuples are read from the outer plan in batches of at least
+ *		INCREMENTAL_SORT_MIN_BATCH tuples, extended until the presorted key
+ *		columns change, and each batch is sorted separately.
+ * ----------------
+ */
+typedef struct PresortedKeyData
+{
+	FmgrInfo	flinfo;			/* comparison function info */
+	FunctionCallInfo fcinfo;	/* comparison function call info */
+	OffsetNumber attno;			/* attribute number in tuple */
+} PresortedKeyData;
+
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	int64		bound_Done;		/* number of tuples already returned */
+	bool		outerNodeDone;	/* finished fetching tuples from outer node */
+	bool		batch_Done;		/* current batch sorted and being returned? */
+	PresortedKeyData *presorted_keys;	/* keys the input is presorted by */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	TupleTableSlot *group_pivot;	/* last tuple of the minimal batch; later
+									 * tuples join the batch if they are equal
+									 * to it on the presorted keys */
+	TupleTableSlot *transfer_tuple; /* first tuple of the next batch */
+	/* statistics for EXPLAIN ANALYZE */
+	int64		batches;		/* number of batches sorted */
+	long		peakMemorySpace;	/* largest in-memory batch sort, in kB */
+	long		peakDiskSpace;	/* largest on-disk batch sort, in kB */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2017,6 +2189,29 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+
+	/* support for spilling hashed groups to disk (AGG_HASHED/AGG_MIXED): */
+	MemoryContext hash_metacxt; /* memory for hash table buckets */
+	struct HashAggSpill *hash_spills;	/* HashAggSpill for each grouping set,
+										 * exists only during first pass */
+	List	   *hash_batches;	/* hash batches remaining to be processed */
+	TupleTableSlot *hash_spill_slot;	/* slot for reading from spill files */
+	ExprState  *hash_spill_evaltrans;	/* transition functions, for input
+										 * read back from spill files */
+	bool		hash_ever_spilled;	/* ever spilled during this execution? */
+	bool		hash_spill_mode;	/* memory limit reached, don't create
+									 * new groups in the current pass */
+	Size		hash_mem_limit; /* limit before spilling hash table */
+	uint64		hash_ngroups_current;	/* number of groups currently in
+										 * memory in all hash tables */
+	double		hashentrysize;	/* estimated memory per group */
+	Size		hash_mem_peak;	/* peak hash table memory usage */
+	uint64		hash_disk_used; /* bytes written to spill files */
+	int			hash_batches_used;	/* batches used during entire execution */
+	struct ParallelAggState *hash_parallel_state;	/* shared state for
+													 * Parallel HashAgg */
+	struct SharedTuplestoreAccessor **hash_parallel_partitions;
+	bool		hash_parallel_attached; /* attached to the barrier? */
 } AggState;
 
 /* ----------------
@@ -2164,6 +2359,7 @@ typedef struct GatherMergeState
 	TupleDesc	tupDesc;		/* descriptor for subplan result tuples */
 	int			gm_nkeys;		/* number of sort columns */
 	SortSupport gm_sortkeys;	/* array of length gm_nkeys */
+	bool		gm_by_range;	/* is the outer plan a Parallel Sort? */
 	struct ParallelExecutorInfo *pei;
 	/* all remaining fields are reinitialized during a rescan */
 	/* (but the arrays are not reallocated, just cleared) */
@@ -2173,6 +2369,10 @@ typedef struct GatherMergeState
 	struct TupleQueueReader **reader;	/* array with nreaders active entries */
 	struct GMReaderTupleBuffer *gm_tuple_buffers;	/* nreaders tuple buffers */
 	struct binaryheap *gm_heap; /* binary heap of slot indices */
+	int		   *gm_range_readers;	/* with gm_by_range, readers in order
+									 * of the key ranges they return */
+	int			gm_nrange_readers;	/* number of entries in that array */
+	int			gm_next_range;	/* index of the reader being returned */
 } GatherMergeState;
 
 /* ----------------
@@ -2208,10 +2408,14 @@ typedef struct HashState
 	HashJoinTable hashtable;	/* hash table for the hashjoin */
 	List	   *hashkeys;		/* list of ExprState nodes */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+	ExprState  *hash_expr;		/* computes the hash value of inner tuples */
 
 	SharedHashInfo *shared_info;	/* one entry per worker */
 	HashInstrumentation *hinstrument;	/* this worker's entry */
 
+	/* build a bloom filter for the parent join's outer scan? */
+	bool		build_bloom;
+
 	/* Parallel hash state. */
 	struct ParallelHashJoinState *parallel_state;
 } HashState;
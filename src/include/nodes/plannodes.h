@@ -133,6 +133,11 @@ typedef struct Plan
 	bool		parallel_aware; /* engage parallel-aware logic? */
 	bool		parallel_safe;	/* OK to use as part of parallel plan? */
 
+	/*
+	 * information needed for asynchronous execution
+	 */
+	bool		async_capable;	/* engage asynchronous-capable logic? */
+
 	/*
 	 * Common structural data for all Plan types.
 	 */
@@ -342,9 +347,18 @@ typedef struct Scan
 
 /* ----------------
  *		sequential scan node
+ *
+ * bloomkeys, if not NIL, are the outer hash keys of a parent HashJoin,
+ * expressed in terms of the scan tuple.  At execution the join's Hash node
+ * builds a bloom filter over the inner hash values, and the scan discards
+ * tuples whose hash value is definitely not in that filter.
  * ----------------
  */
-typedef Scan SeqScan;
+typedef struct SeqScan
+{
+	Scan		scan;
+	List	   *bloomkeys;		/* expressions to probe the bloom filter */
+} SeqScan;
 
 /* ----------------
  *		table sample scan node
@@ -747,6 +761,27 @@ typedef struct Material
 	Plan		plan;
 } Material;
 
+/* ----------------
+ *		result cache node
+ *
+ * Caches the results of its parameterized subplan, keyed by the values of
+ * param_exprs, so that rescans with previously seen parameter values can be
+ * answered from the cache instead of re-executing the subplan.
+ * ----------------
+ */
+typedef struct ResultCache
+{
+	Plan		plan;
+	int			numKeys;		/* size of hashOperators array */
+	Oid		   *hashOperators;	/* hash operators for each key */
+	List	   *param_exprs;	/* exprs containing the cache key values */
+	bool		singlerow;		/* true if the cache entry is complete after
+								 * caching the first tuple */
+	uint32		est_entries;	/* planner's estimate of the number of
+								 * cache entries, or 0 if unknown */
+	Bitmapset  *keyparamids;	/* paramids from param_exprs */
+} ResultCache;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -759,8 +794,24 @@ typedef struct Sort
 	Oid		   *sortOperators;	/* OIDs of operators to sort them by */
 	Oid		   *collations;		/* OIDs of collations */
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
+	List	   *rangeBounds;	/* Consts splitting the leading key's values
+								 * into ranges, for a parallel-aware sort */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is known to be sorted on the first nPresortedCols sort keys
+ * already, so each group of tuples that are equal on those keys can be
+ * sorted independently.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
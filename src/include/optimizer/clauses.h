@@ -16,6 +16,7 @@
 
 #include "access/htup.h"
 #include "nodes/pathnodes.h"
+#include "utils/relcache.h"
 
 typedef struct
 {
@@ -36,6 +37,7 @@ extern double expression_returns_set_rows(PlannerInfo *root, Node *clause);
 extern bool contain_subplans(Node *clause);
 
 extern char max_parallel_hazard(Query *parse);
+extern char max_parallel_hazard_for_insert(Relation rel, Node *exprs);
 extern bool is_parallel_safe(PlannerInfo *root, Node *node);
 extern bool contain_nonstrict_functions(Node *clause);
 extern bool contain_leaked_vars(Node *clause);
@@ -52,6 +54,8 @@ extern int	NumRelids(Node *clause);
 
 extern void CommuteOpExpr(OpExpr *clause);
 
+extern Bitmapset *pull_paramids(Expr *expr);
+
 extern Query *inline_set_returning_function(PlannerInfo *root,
 							  RangeTblEntry *rte);
 
@@ -64,6 +64,7 @@ typedef enum StatMsgType
 	PGSTAT_MTYPE_FUNCPURGE,
 	PGSTAT_MTYPE_RECOVERYCONFLICT,
 	PGSTAT_MTYPE_TEMPFILE,
+	PGSTAT_MTYPE_TEMPCOMPRESSION,
 	PGSTAT_MTYPE_DEADLOCK
 } StatMsgType;
 
@@ -446,6 +447,20 @@ typedef struct PgStat_MsgTempFile
 	size_t		m_filesize;
 } PgStat_MsgTempFile;
 
+/* ----------
+ * PgStat_MsgTempCompression	Sent by the backend to report the data it
+ *								wrote to compressed temp files
+ * ----------
+ */
+typedef struct PgStat_MsgTempCompression
+{
+	PgStat_MsgHdr m_hdr;
+
+	Oid			m_databaseid;
+	int64		m_uncompressed;
+	int64		m_compressed;
+} PgStat_MsgTempCompression;
+
 /* ----------
  * PgStat_FunctionCounts	The actual per-function counts kept by a backend
  *
@@ -566,7 +581,7 @@ typedef union PgStat_Msg
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9D
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9E
 
 /* ----------
  * PgStat_StatDBEntry			The collector's data per database
@@ -592,6 +607,8 @@ typedef struct PgStat_StatDBEntry
 	PgStat_Counter n_conflict_startup_deadlock;
 	PgStat_Counter n_temp_files;
 	PgStat_Counter n_temp_bytes;
+	PgStat_Counter n_temp_uncompressed_bytes;
+	PgStat_Counter n_temp_compressed_bytes;
 	PgStat_Counter n_deadlocks;
 	PgStat_Counter n_block_read_time;	/* times in microseconds */
 	PgStat_Counter n_block_write_time;
@@ -799,11 +816,13 @@ typedef enum
  */
 typedef enum
 {
-	WAIT_EVENT_BGWORKER_SHUTDOWN = PG_WAIT_IPC,
+	WAIT_EVENT_APPEND_READY = PG_WAIT_IPC,
+	WAIT_EVENT_BGWORKER_SHUTDOWN,
 	WAIT_EVENT_BGWORKER_STARTUP,
 	WAIT_EVENT_BTREE_PAGE,
 	WAIT_EVENT_CLOG_GROUP_UPDATE,
 	WAIT_EVENT_EXECUTE_GATHER,
+	WAIT_EVENT_HASH_AGG_PARTITIONING,
 	WAIT_EVENT_HASH_BATCH_ALLOCATING,
 	WAIT_EVENT_HASH_BATCH_ELECTING,
 	WAIT_EVENT_HASH_BATCH_LOADING,
@@ -828,6 +847,7 @@ typedef enum
 	WAIT_EVENT_PARALLEL_BITMAP_SCAN,
 	WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN,
 	WAIT_EVENT_PARALLEL_FINISH,
+	WAIT_EVENT_PARALLEL_SORT_RUNS,
 	WAIT_EVENT_PROCARRAY_GROUP_UPDATE,
 	WAIT_EVENT_PROMOTE,
 	WAIT_EVENT_REPLICATION_ORIGIN_DROP,
@@ -1159,6 +1179,12 @@ extern PgStat_MsgBgWriter BgWriterStats;
 extern PgStat_Counter pgStatBlockReadTime;
 extern PgStat_Counter pgStatBlockWriteTime;
 
+/*
+ * Updated by pgstat_count_tempfile_compression macro
+ */
+extern PgStat_Counter pgStatTempUncompressedBytes;
+extern PgStat_Counter pgStatTempCompressedBytes;
+
 /* ----------
  * Functions called from postmaster
  * ----------
@@ -1324,6 +1350,11 @@ pgstat_report_wait_end(void)
 	(pgStatBlockReadTime += (n))
 #define pgstat_count_buffer_write_time(n)							\
 	(pgStatBlockWriteTime += (n))
+#define pgstat_count_tempfile_compression(u, c)						\
+	do {															\
+		pgStatTempUncompressedBytes += (u);							\
+		pgStatTempCompressedBytes += (c);							\
+	} while (0)
 
 extern void pgstat_count_heap_insert(Relation rel, PgStat_Counter n);
 extern void pgstat_count_heap_update(Relation rel, bool hot);
@@ -0,0 +1,120 @@
+/*-------------------------------------------------------------------------
+ *
+ * simd.h
+ *	  Support for platform-specific vector operations.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/simd.h
+ *
+ * NOTES
+ * - Vector8 is a register holding 8-bit elements.  Its width depends on the
+ * platform, so callers that care must look at sizeof(Vector8).
+ * - These are meant for scanning buffers for a few interesting bytes, as in
+ * COPY's input parsing.  Callers must still be correct when a test reports a
+ * match, since the portable fallback is only exact about whether there is a
+ * match, not where it is.
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SIMD_H
+#define SIMD_H
+
+#if (defined(__x86_64__) || defined(_M_AMD64))
+/*
+ * SSE2 instructions are part of the spec for the 64-bit x86 ISA, so we can
+ * use them without a runtime check.  We include emmintrin.h rather than
+ * immintrin.h so as to not use anything beyond SSE2 by accident.
+ */
+#include <emmintrin.h>
+#define USE_SSE2
+typedef __m128i Vector8;
+
+#else
+/*
+ * Without SIMD instructions, we can still process eight bytes at a time with
+ * bitwise operations on a uint64.
+ */
+#define USE_NO_SIMD
+typedef uint64 Vector8;
+#endif
+
+static inline void vector8_load(Vector8 *v, const uint8 *s);
+static inline Vector8 vector8_broadcast(const uint8 c);
+static inline bool vector8_has(const Vector8 v, const uint8 c);
+static inline bool vector8_has_zero(const Vector8 v);
+static inline bool vector8_is_highbit_set(const Vector8 v);
+
+/*
+ * Load a chunk of memory into the given vector.  No alignment is required.
+ */
+static inline void
+vector8_load(Vector8 *v, const uint8 *s)
+{
+#ifdef USE_SSE2
+	*v = _mm_loadu_si128((const __m128i *) s);
+#else
+	memcpy(v, s, sizeof(Vector8));
+#endif
+}
+
+/*
+ * Create a vector with all elements set to the same value.
+ */
+static inline Vector8
+vector8_broadcast(const uint8 c)
+{
+#ifdef USE_SSE2
+	return _mm_set1_epi8((char) c);
+#else
+	return ~UINT64CONST(0) / 0xFF * c;
+#endif
+}
+
+/*
+ * Return true if any elements in the vector are equal to the given scalar.
+ */
+static inline bool
+vector8_has(const Vector8 v, const uint8 c)
+{
+#ifdef USE_SSE2
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(v, vector8_broadcast(c))) != 0;
+#else
+	/* any bytes in v equal to c will be zero after XOR */
+	return vector8_has_zero(v ^ vector8_broadcast(c));
+#endif
+}
+
+/*
+ * Convenience function equivalent to vector8_has(v, 0).
+ */
+static inline bool
+vector8_has_zero(const Vector8 v)
+{
+#ifdef USE_SSE2
+	return vector8_has(v, 0);
+#else
+	/*
+	 * Subtracting one from each byte sets the high bit of the zero bytes,
+	 * and of no other byte below the first zero one.  See
+	 * https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
+	 */
+	return ((v - vector8_broadcast(0x01)) & ~v & vector8_broadcast(0x80)) != 0;
+#endif
+}
+
+/*
+ * Return true if the high bit of any element is set.
+ */
+static inline bool
+vector8_is_highbit_set(const Vector8 v)
+{
+#ifdef USE_SSE2
+	return _mm_movemask_epi8(v) != 0;
+#else
+	return (v & vector8_broadcast(0x80)) != 0;
+#endif
+}
+
+#endif							/* SIMD_H */
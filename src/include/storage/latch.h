@@ -176,6 +176,7 @@ extern int WaitLatch(volatile Latch *latch, int wakeEvents, long timeout,
 		  uint32 wait_event_info);
 extern int WaitLatchOrSocket(volatile Latch *latch, int wakeEvents,
 				  pgsocket sock, long timeout, uint32 wait_event_info);
+extern int	GetNumRegisteredWaitEvents(WaitEventSet *set);
 
 /*
  * Unix implementation uses SIGUSR1 for inter-process signaling.
@@ -299,6 +299,19 @@ typedef struct LOCK
 
 #define LOCK_LOCKMETHOD(lock) ((LOCKMETHODID) (lock).tag.locktag_lockmethodid)
 
+/*
+ * Relation extension and page locks protect physical structures rather than
+ * database objects, so they conflict even between members of a lock group;
+ * otherwise parallel workers writing to the same relation could corrupt it.
+ * This can't cause an undetected deadlock within the group because a backend
+ * holding the relation extension lock acquires no other heavyweight lock,
+ * and one holding a page lock acquires only the relation extension lock (as
+ * GIN's pending list cleanup does).  LockAcquireExtended asserts both.
+ */
+#define LOCK_CONFLICTS_IN_GROUP(lock) \
+	((lock).tag.locktag_type == LOCKTAG_RELATION_EXTEND || \
+	 (lock).tag.locktag_type == LOCKTAG_PAGE)
+
 
 /*
  * We may have several different backends holding or awaiting locks
@@ -416,6 +429,7 @@ typedef struct LOCALLOCK
 } LOCALLOCK;
 
 #define LOCALLOCK_LOCKMETHOD(llock) ((llock).tag.lock.locktag_lockmethodid)
+#define LOCALLOCK_LOCKTAG(llock) ((LockTagType) (llock).tag.lock.locktag_type)
 
 
 /*
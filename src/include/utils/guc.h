@@ -254,6 +254,7 @@ extern int	log_temp_files;
 extern double log_statement_sample_rate;
 
 extern int	temp_file_limit;
+extern bool temp_file_compression;
 
 extern int	num_temp_buffers;
 
@@ -371,6 +372,7 @@ extern char *GetConfigOptionByName(const char *name, const char **varname,
 					  bool missing_ok);
 extern void GetConfigOptionByNum(int varnum, const char **values, bool *noshow);
 extern int	GetNumConfigOptions(void);
+extern char *GetPlannerSettings(void);
 
 extern void SetPGVariable(const char *name, List *args, bool is_local);
 extern void GetPGVariable(const char *name, DestReceiver *dest);
@@ -128,6 +128,12 @@ typedef struct CachedPlanSource
 	double		generic_cost;	/* cost of generic plan, or -1 if not known */
 	double		total_custom_cost;	/* total cost of custom plans so far */
 	int			num_custom_plans;	/* number of plans included in total */
+	/* State for sharing the query and generic plan with other backends: */
+	bool		is_shareable;	/* may it use the shared plan cache? */
+	Oid		   *shared_param_types; /* parameter types given by client */
+	int			shared_num_params;	/* length of shared_param_types array */
+	char	   *shared_key;		/* key for the current analysis, or NULL */
+	int			shared_key_len; /* length of shared_key */
 } CachedPlanSource;
 
 /*
@@ -199,6 +205,11 @@ extern void CompleteCachedPlan(CachedPlanSource *plansource,
 				   void *parserSetupArg,
 				   int cursor_options,
 				   bool fixed_result);
+extern bool CompleteCachedPlanFromShared(CachedPlanSource *plansource,
+							 Oid *param_types,
+							 int num_params,
+							 int cursor_options,
+							 bool fixed_result);
 
 extern void SaveCachedPlan(CachedPlanSource *plansource);
 extern void DropCachedPlan(CachedPlanSource *plansource);
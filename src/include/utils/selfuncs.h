@@ -189,6 +189,8 @@ extern void estimate_hash_bucket_stats(PlannerInfo *root,
 extern double estimate_hashagg_tablesize(Path *path,
 						   const AggClauseCosts *agg_costs,
 						   double dNumGroups);
+extern List *get_sort_range_bounds(PlannerInfo *root, Node *expr,
+					  Oid sortop, int nbounds);
 
 extern List *get_quals_from_indexclauses(List *indexclauses);
 extern Cost index_other_operands_eval_cost(PlannerInfo *root,
@@ -0,0 +1,40 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.h
+ *	  Plan cache shared between backends
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDPLANCACHE_H
+#define SHAREDPLANCACHE_H
+
+#include "nodes/pg_list.h"
+#include "storage/sinval.h"
+
+/* GUC parameter */
+extern int	shared_plan_cache_size;
+
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+
+extern bool SharedPlanCacheEnabled(void);
+extern uint64 SharedPlanCacheGetGeneration(void);
+extern char *SharedPlanCacheLookup(const char *key, Size key_len,
+					  Size *data_len);
+extern void SharedPlanCacheInsert(const char *key, Size key_len,
+					  const char *data, Size data_len,
+					  List *relationOids, List *invalItems,
+					  uint64 generation);
+extern bool SharedPlanCacheIsCurrent(List *relationOids, List *invalItems,
+						 uint64 generation);
+
+extern void SharedPlanCacheInvalidateMessages(const SharedInvalidationMessage *msgs,
+								  int n);
+
+#endif							/* SHAREDPLANCACHE_H */
@@ -0,0 +1,83 @@
+# Sharing prepared statements between sessions through the shared plan cache
+
+use strict;
+use warnings;
+
+use TestLib;
+use Test::More tests => 18;
+use PostgresNode;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf('postgresql.conf', 'shared_plan_cache_size = 1MB');
+$node->start;
+
+$node->safe_psql('postgres',
+	'create table t as select g as a from generate_series(1, 10) g');
+
+# Run a statement as a prepared statement in a new session, returning its
+# output and what the session took from the shared plan cache: "query,plan"
+# if both the analyzed query and the generic plan, "query" if just the former,
+# or "" if nothing.
+sub run_prepared
+{
+	my ($setup, $query) = @_;
+
+	my ($ret, $stdout, $stderr) = $node->psql(
+		'postgres', qq{
+		$setup
+		set client_min_messages = debug1;
+		prepare s as $query;
+		execute s;
+		reset client_min_messages;
+	});
+	is($ret, 0, "prepared \"$query\" ran") or diag($stderr);
+
+	my @shared;
+	push @shared, 'query'
+	  if $stderr =~ /analyzed query taken from shared plan cache/;
+	push @shared, 'plan'
+	  if $stderr =~ /generic plan taken from shared plan cache/;
+	return ($stdout, join(',', @shared));
+}
+
+my ($result, $shared);
+
+# The first session fills the cache, and the second one uses it
+($result, $shared) = run_prepared('', 'select * from t where a = 3');
+is("$result|$shared", '3|', 'first session does not find the statement');
+($result, $shared) = run_prepared('', 'select * from t where a = 3');
+is("$result|$shared", '3|query,plan', 'second session uses the shared statement');
+
+# DDL on the table makes the entry out of date, until it is stored again
+$node->safe_psql('postgres', 'alter table t add column b int default 0');
+($result, $shared) = run_prepared('', 'select * from t where a = 3');
+is("$result|$shared", '3|0|', 'session after DDL does not use the entry');
+($result, $shared) = run_prepared('', 'select * from t where a = 3');
+is("$result|$shared", '3|0|query,plan', 'next session uses the stored entry again');
+
+# A session with other planner settings takes the analyzed query, but plans
+# it itself, and its plan replaces the shared one
+($result, $shared) =
+  run_prepared('set enable_seqscan = off;', 'select * from t where a = 3');
+is("$result|$shared", '3|0|query',
+	'session with other planner settings does not use the plan');
+($result, $shared) =
+  run_prepared('set enable_seqscan = off;', 'select * from t where a = 3');
+is("$result|$shared", '3|0|query,plan',
+	'next session with the same settings uses the plan');
+
+# The timestamptz literal is converted during parse analysis, so sessions
+# with another TimeZone must not share the query
+($result, $shared) = run_prepared("set timezone = 'UTC';",
+	"select '2019-01-01 00:00'::timestamptz::text");
+is("$result|$shared", '2019-01-01 00:00:00+00|',
+	'literal is converted with the first session\'s TimeZone');
+($result, $shared) = run_prepared("set timezone = 'PST8PDT';",
+	"select '2019-01-01 00:00'::timestamptz::text");
+is("$result|$shared", '2019-01-01 00:00:00-08|',
+	'session with another TimeZone does not use the entry');
+($result, $shared) = run_prepared("set timezone = 'UTC';",
+	"select '2019-01-01 00:00'::timestamptz::text");
+is("$result|$shared", '2019-01-01 00:00:00+00|query,plan',
+	'session with the same TimeZone uses the entry');
@@ -987,3 +987,70 @@ select v||'a', case v||'a' when 'aa' then 1 else 0 end, count(*)
 select v||'a', case when v||'a' = 'aa' then 1 else 0 end, count(*)
   from unnest(array['a','b']) u(v)
  group by v||'a' order by 1;
+
+--
+-- Hash Aggregation Spill tests
+--
+
+set enable_sort=false;
+set work_mem='64kB';
+
+create function explain_hashagg_spill(query text) returns setof text
+language plpgsql as
+$$
+declare ln text;
+begin
+    for ln in
+        execute 'explain (analyze, costs off, timing off, summary off) ' || query
+    loop
+        ln := regexp_replace(ln, 'Batches: ([2-9]|\d{2,})\M', 'Batches: >1');
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        ln := regexp_replace(ln, 'Disk Usage: \d+', 'Disk Usage: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+create function hashagg_peak_memory(query text) returns int
+language plpgsql as
+$$
+declare plan json;
+begin
+    execute 'explain (analyze, costs off, timing off, summary off, format json) '
+        || query into plan;
+    return (plan->0->'Plan'->>'Peak Memory Usage')::int;
+end;
+$$;
+
+explain (costs off)
+select g % 10000 as k, count(*) as c
+  from generate_series(0, 29999) g
+ group by g % 10000;
+select explain_hashagg_spill('
+select g % 10000 as k, count(*) as c
+  from generate_series(0, 29999) g
+ group by g % 10000');
+select count(*), sum(c), min(k), max(k)
+  from (select g % 10000 as k, count(*) as c
+          from generate_series(0, 29999) g
+         group by g % 10000) s;
+
+explain (costs off)
+select g % 1000 as a, g % 7 as b, count(*) as c
+  from generate_series(0, 19999) g
+ group by grouping sets ((g % 1000), (g % 7));
+select count(*), sum(c)
+  from (select g % 1000 as a, g % 7 as b, count(*) as c
+          from generate_series(0, 19999) g
+         group by grouping sets ((g % 1000), (g % 7))) s;
+
+-- The planner expects 10000 groups, whose buckets alone would take 384kB,
+-- but the initial hash table must be sized to fit in work_mem
+select hashagg_peak_memory('select unique1 % 10000, count(*) from tenk1 group by 1') < 384
+  as fits_work_mem;
+
+drop function explain_hashagg_spill(text);
+drop function hashagg_peak_memory(text);
+
+reset work_mem;
+reset enable_sort;
@@ -177,6 +177,50 @@ c\.d
 
 COPY testeoc TO stdout CSV;
 
+-- test special characters on either side of the 16-byte boundaries that
+-- COPY FROM scans its input at, in fields both longer and shorter than that
+CREATE TEMP TABLE testvec (a text, b text);
+
+COPY testvec FROM stdin;
+abcdefghijklmnopqrstuvwxyz0123456789	ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*()
+xxxxxxxxxxxxxxx	yyyyyyyyyyyyyyy
+xxxxxxxxxxxxxxxx	yyyyyyyyyyyyyyyy
+xxxxxxxxxxxxxxxxx	yyyyyyyyyyyyyyyyy
+xxxxxxxxxxxxxxx\tx	yyyyyyyyyyyyyyyy\n
+xxxxxxxxxxxxxxxx\\x	yyyyyyyyyyyyyyy\\
+xxxxxxxxxxxxxxxxx\x41	\N
+xxxxxxxxxxxxxxx\	xx	b
+\.
+-- with \r\n line endings
+COPY testvec FROM stdin;
+xxxxxxx	yyyyyyy
+xxxxxxxx	yyyyyyy
+xxxxxxxxxxxxxxxx	yyyyyyyyyyyyyy
+\.
+
+COPY testvec TO stdout;
+TRUNCATE testvec;
+
+COPY testvec FROM stdin CSV;
+abcdefghijklmnopqrstuvwxyz0123456789,ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789
+xxxxxxxxxxxxxxx,yyyyyyyyyyyyyyy
+xxxxxxxxxxxxxxxx,yyyyyyyyyyyyyyyy
+xxxxxxxxxxxxxxxxx,yyyyyyyyyyyyyyyyy
+xxxxxxxxxxxxxxx"q,q"x,yyyyyyyyyyyyyyyyyyyy
+"yyyyyyyyyyyyyyy""yyyyyyyyyyyyyyyy",z
+"nnnnnnnnnnnnnn
+nnn",wwwwwwwwwwwwwwww
+xxxxxxxxxxxxxxxx,"yyyyyyyyyyyyyyy,y"
+,zzzzzzzzzzzzzzzzzzzz
+\.
+COPY testvec FROM stdin WITH (FORMAT csv, ESCAPE E'\\');
+"zzzzzzzzzzzzzz\"zz",a
+"yyyyyyyyyyyyyyy\\",b
+xxxxxxxxxxxx,"y"
+\.
+
+COPY testvec TO stdout CSV;
+
 -- test handling of nonstandard null marker that violates escaping rules
 
 CREATE TEMP TABLE testnull(a int, b text);
@@ -440,6 +484,36 @@ test1
 SELECT * FROM instead_of_insert_tbl;
 COMMIT;
 
+-- Test parallel COPY FROM
+CREATE TABLE parallel_copytest (a int PRIMARY KEY, b text, c int DEFAULT 42);
+COPY parallel_copytest (a, b) FROM stdin WITH (parallel 2);
+1	one
+2	two
+3	three
+\.
+COPY parallel_copytest FROM stdin WITH (format csv, header, parallel 2);
+a,b,c
+4,"four
+and a half",4
+5,five,
+\.
+SELECT count(*), sum(a), sum(c), max(length(b)) FROM parallel_copytest;
+
+-- errors are still reported with the line they occurred on; hide the
+-- "parallel worker" context line, which depends on whether any workers
+-- could be launched
+SET force_parallel_mode = regress;
+COPY parallel_copytest (a, b) FROM stdin WITH (parallel 2);
+6	six
+seven	7
+\.
+COPY parallel_copytest (a, b) FROM stdin WITH (parallel 2);
+6	six
+2	two again
+\.
+RESET force_parallel_mode;
+COPY parallel_copytest TO stdout WITH (parallel 2);
+
 -- clean up
 DROP TABLE forcetest;
 DROP TABLE vistest;
@@ -454,3 +528,4 @@ DROP TABLE instead_of_insert_tbl;
 DROP VIEW instead_of_insert_tbl_view;
 DROP VIEW instead_of_insert_tbl_view_2;
 DROP FUNCTION fun_instead_of_insert_tbl();
+DROP TABLE parallel_copytest;
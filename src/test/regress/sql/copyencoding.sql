@@ -0,0 +1,26 @@
+--
+-- encoding-sensitive tests for COPY
+--
+
+-- the client encoding used below can only be converted to these
+SELECT getdatabaseencoding() NOT IN ('UTF8', 'EUC_JP', 'MULE_INTERNAL')
+       AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+
+-- In SJIS, the second byte of a multibyte character can be a backslash.
+-- COPY FROM must not take it for one, even when it skips over the input a
+-- vector at a time.
+CREATE TEMP TABLE copy_sjis (a text, b text);
+SET client_encoding TO SJIS;
+COPY copy_sjis FROM stdin;
+xxxxxxx	yyyyyyy\
+\.
+COPY copy_sjis FROM stdin WITH (FORMAT csv, ESCAPE E'\\');
+"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\",b
+\.
+RESET client_encoding;
+SELECT replace(a, convert_from('\x955c', 'SJIS'), '<hyo>') AS a,
+       replace(b, convert_from('\x955c', 'SJIS'), '<hyo>') AS b
+  FROM copy_sjis;
@@ -34,3 +34,33 @@ SELECT current_schema;
 SET search_path = 'pg_catalog';
 SELECT current_schema;
 RESET search_path;
+
+--
+-- Fused comparisons of a column with a constant
+--
+CREATE TEMP TABLE cmpconst (i2 int2, i4 int4, i8 int8, f4 float4, f8 float8, d date);
+INSERT INTO cmpconst VALUES (1, 1, 1, 1, 1, '2000-01-01'),
+  (2, 2, 5000000000, 'NaN', 'NaN', '2000-01-02'),
+  (NULL, NULL, NULL, NULL, NULL, NULL);
+SELECT i4, i4 < 2 AS lt, 2 <= i4 AS ge, i8 > 4000000000 AS i8gt,
+  f8 > 1e300 AS nan_gt, f4 = 'NaN' AS nan_eq, d <> '2000-01-01' AS dne
+  FROM cmpconst ORDER BY i4;
+SELECT i2 FROM cmpconst WHERE i2 >= 2;
+SELECT i4 FROM cmpconst WHERE 1.5 < f8;
+DROP TABLE cmpconst;
+
+--
+-- Common subexpressions are evaluated only once per row
+--
+CREATE FUNCTION cse_f(int) RETURNS int LANGUAGE plpgsql IMMUTABLE AS
+$$ BEGIN RAISE NOTICE 'cse_f(%)', $1; RETURN $1 * 10; END $$;
+CREATE FUNCTION cse_v(int) RETURNS int LANGUAGE plpgsql VOLATILE AS
+$$ BEGIN RAISE NOTICE 'cse_v(%)', $1; RETURN $1 * 10; END $$;
+SELECT cse_f(a), cse_f(a) + 1 FROM (VALUES (1), (2)) v(a);
+SELECT a FROM (VALUES (1), (2), (3)) v(a) WHERE cse_f(a) > 10 AND cse_f(a) < 30;
+-- conditionally evaluated occurrences are still evaluated lazily
+SELECT CASE WHEN a > 1 THEN cse_f(a) END, cse_f(a) FROM (VALUES (1), (2)) v(a);
+-- volatile functions are evaluated every time
+SELECT cse_v(a), cse_v(a) FROM (VALUES (1)) v(a);
+DROP FUNCTION cse_f(int);
+DROP FUNCTION cse_v(int);
@@ -0,0 +1,66 @@
+--
+-- Incremental Sort
+--
+
+create table incsort_small (a int, b int);
+insert into incsort_small select i / 10, 100 - i from generate_series(1, 100) i;
+create index incsort_small_a_idx on incsort_small (a);
+analyze incsort_small;
+
+create table incsort_large (a int, b int);
+insert into incsort_large select i / 50, (i * 37) % 50 from generate_series(0, 199) i;
+create index incsort_large_a_idx on incsort_large (a);
+analyze incsort_large;
+
+set enable_sort = off;
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+
+-- Each batch of the sort spans several groups of equal "a"
+explain (costs off)
+select * from incsort_small order by a, b limit 12;
+select * from incsort_small order by a, b limit 12;
+
+-- Groups larger than the minimum batch size
+select * from incsort_large order by a, b offset 48 limit 3;
+select * from incsort_large order by a, b desc offset 98 limit 4;
+
+reset enable_sort;
+reset enable_seqscan;
+reset enable_bitmapscan;
+
+-- With the default settings, a LIMIT query only sorts the first groups of
+-- an index scan's output
+create table incsort_big (a int, b int);
+insert into incsort_big select i / 100, (i * 37) % 100 from generate_series(0, 9999) i;
+create index incsort_big_a_idx on incsort_big (a);
+analyze incsort_big;
+
+explain (costs off)
+select * from incsort_big order by a, b limit 3;
+select * from incsort_big order by a, b limit 3;
+
+create function explain_incremental_sort(query text) returns setof text
+language plpgsql as
+$$
+declare ln text;
+begin
+    for ln in
+        execute 'explain (analyze, costs off, summary off, timing off) ' || query
+    loop
+        ln := regexp_replace(ln, 'Peak Memory: \d+', 'Peak Memory: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+-- Only the first two groups are read, each sorted in a batch of its own
+select explain_incremental_sort('
+select * from incsort_big order by a, b offset 150 limit 3');
+select * from incsort_big order by a, b offset 150 limit 3;
+
+drop function explain_incremental_sort(text);
+
+drop table incsort_small;
+drop table incsort_large;
+drop table incsort_big;
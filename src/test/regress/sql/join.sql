@@ -2214,6 +2214,38 @@ $$
 $$);
 rollback to settings;
 
+-- non-parallel, with compressed batch files
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '128kB';
+set local temp_file_compression = on;
+select count(*), sum(r.id) from simple r join simple s using (id);
+create or replace function hash_join_temp_compression(query text)
+returns table (uncompressed bigint, compressed bigint) language plpgsql
+as
+$$
+declare
+  whole_plan json;
+  top_node json;
+begin
+  for whole_plan in
+    execute 'explain (analyze, buffers, format ''json'') ' || query
+  loop
+    top_node := json_extract_path(whole_plan, '0', 'Plan');
+    uncompressed := top_node->>'Temp Uncompressed';
+    compressed := top_node->>'Temp Compressed';
+    return next;
+  end loop;
+end;
+$$;
+select uncompressed > 0 as wrote_compressed,
+       compressed < uncompressed as saved_space
+  from hash_join_temp_compression(
+$$
+  select count(*) from simple r join simple s using (id);
+$$);
+rollback to settings;
+
 -- parallel with parallel-oblivious hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
@@ -2340,6 +2372,41 @@ $$
 $$);
 rollback to settings;
 
+-- Parallel-oblivious hash joins don't blow through work_mem in that
+-- case anymore: the oversized batch is loaded in several stripes that
+-- each fit, and the outer batch is rescanned for each stripe.  Check
+-- that each join type still produces the right answer, and that the
+-- hash table stayed near its budget.
+create or replace function hash_join_peak_memory(query text)
+returns int language plpgsql
+as
+$$
+declare
+  whole_plan json;
+  hash_node json;
+begin
+  execute 'explain (analyze, format ''json'') ' || query into whole_plan;
+  hash_node := find_hash(json_extract_path(whole_plan, '0', 'Plan'));
+  return hash_node->>'Peak Memory Usage';
+end;
+$$;
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '128kB';
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+select count(*), count(s.id) from simple r left join extremely_skewed s using (id);
+select count(*), count(s.id) from simple r full join extremely_skewed s using (id);
+select count(*) from simple r
+  where exists (select 1 from extremely_skewed s where s.id = r.id);
+select count(*) from simple r
+  where not exists (select 1 from extremely_skewed s where s.id = r.id);
+select hash_join_peak_memory(
+$$
+  select count(*) from simple r join extremely_skewed s using (id);
+$$) <= 256 as within_budget;
+rollback to settings;
+
 -- A couple of other hash join tests unrelated to work_mem management.
 
 -- Check that EXPLAIN ANALYZE has data even if the leader doesn't participate
@@ -2353,6 +2420,46 @@ $$
 $$);
 rollback to settings;
 
+-- With a big enough bucket array, outer tuples are read ahead so that
+-- their buckets can be prefetched.  Check that this path is reached with
+-- a plain SeqScan on the outer side, with extra join quals and projection.
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '64MB';
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+create table hj_read_ahead as
+  select g as id, g % 7 as grp from generate_series(1, 100000) g;
+analyze hj_read_ahead;
+create or replace function hash_join_buckets(query text)
+returns int language plpgsql
+as
+$$
+declare
+  whole_plan json;
+  hash_node json;
+begin
+  for whole_plan in
+    execute 'explain (analyze, format ''json'') ' || query
+  loop
+    hash_node := find_hash(json_extract_path(whole_plan, '0', 'Plan'));
+    return (hash_node->>'Hash Buckets')::int;
+  end loop;
+end;
+$$;
+select hash_join_buckets(
+$$
+  select count(*) from hj_read_ahead o join hj_read_ahead i on o.id = i.id * 2;
+$$) >= 65536 as read_ahead;
+select count(*), sum(o.id + i.grp)
+  from hj_read_ahead o join hj_read_ahead i
+    on o.id = i.id * 2 and o.grp <> 0;
+select count(*), count(i.id)
+  from hj_read_ahead o left join hj_read_ahead i on o.id = i.id * 2;
+select count(*) from hj_read_ahead o
+  where not exists (select 1 from hj_read_ahead i where o.id = i.id * 2);
+rollback to settings;
+
 -- Exercise rescans.  We'll turn off parallel_leader_participation so
 -- that we can check that instrumentation comes back correctly.
 
@@ -2479,7 +2586,16 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s using (id);
 rollback to settings;
 
--- parallelism not possible with parallel-oblivious outer hash join
+-- parallelism not possible with parallel-oblivious full hash join
+savepoint settings;
+set enable_parallel_hash = off;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s using (id);
+select  count(*) from simple r full outer join simple s using (id);
+rollback to settings;
+
+-- parallelism is possible with parallel-aware full hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
 explain (costs off)
@@ -2497,7 +2613,16 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
 rollback to settings;
 
--- parallelism not possible with parallel-oblivious outer hash join
+-- parallelism not possible with parallel-oblivious full hash join
+savepoint settings;
+set enable_parallel_hash = off;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+rollback to settings;
+
+-- parallelism is possible with parallel-aware full hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
 explain (costs off)
@@ -2529,3 +2654,108 @@ $$);
 rollback to settings;
 
 rollback;
+
+--
+-- Result Cache
+--
+
+begin;
+
+set local enable_resultcache = on;
+set local enable_hashjoin = off;
+set local enable_mergejoin = off;
+set local enable_bitmapscan = off;
+
+create function explain_resultcache(query text) returns setof text
+language plpgsql as
+$$
+declare ln text;
+begin
+    for ln in
+        execute 'explain (analyze, costs off, summary off, timing off) ' || query
+    loop
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        ln := regexp_replace(ln, 'Heap Fetches: \d+', 'Heap Fetches: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+-- Each outer row looks up one of just 20 distinct parameter values
+select explain_resultcache('
+select count(*), avg(t1.unique1)
+from tenk1 t1 inner join tenk1 t2 on t1.unique1 = t2.twenty
+where t2.unique1 < 1000');
+select count(*), avg(t1.unique1)
+from tenk1 t1 inner join tenk1 t2 on t1.unique1 = t2.twenty
+where t2.unique1 < 1000;
+
+-- A cache key must be compared with the clause's own operator, so there is
+-- no cache for a cross-type clause
+explain (costs off)
+select count(*), avg(t1.unique1)
+from tenk1 t1 inner join tenk1 t2 on t1.unique1 = t2.twenty::int8
+where t2.unique1 < 1000;
+
+-- Likewise, with a cache too small to hold every entry
+set local work_mem = '64kB';
+select count(*), avg(t2.unique1)
+from tenk1 t1 inner join tenk1 t2 on t1.unique1 = t2.thousand
+where t1.unique1 < 1000;
+
+rollback;
+
+--
+-- Bloom filter pushdown from Hash to the outer scan
+--
+
+create function explain_bloom_filter(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        if ln like '%Bloom Filter%' then
+            return next ltrim(ln);
+        end if;
+    end loop;
+end;
+$$;
+
+begin;
+
+set local enable_bloom_pushdown = on;
+set local enable_nestloop = off;
+set local enable_mergejoin = off;
+set local enable_indexscan = off;
+set local enable_bitmapscan = off;
+
+explain (costs off)
+select count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique2
+where t2.thousand = 0;
+select count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique2
+where t2.thousand = 0;
+select explain_bloom_filter('
+select count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique2
+where t2.thousand = 0');
+
+-- Left joins must not filter the outer side
+explain (costs off)
+select count(t2.ten) from tenk1 t1 left join tenk1 t2
+  on t1.unique1 = t2.unique2 and t2.thousand = 0;
+
+-- Parallel Hash shares a single filter between participants
+set local parallel_setup_cost = 0;
+set local parallel_tuple_cost = 0;
+set local min_parallel_table_scan_size = 0;
+set local max_parallel_workers_per_gather = 2;
+select count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique2
+where t2.thousand = 0;
+
+rollback;
+
+drop function explain_bloom_filter(text);
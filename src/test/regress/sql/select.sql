@@ -262,3 +262,75 @@ create table list_parted_tbl1 partition of list_parted_tbl
   for values in (1) partition by list(b);
 explain (costs off) select * from list_parted_tbl;
 drop table list_parted_tbl;
+
+--
+-- Test batch evaluation of simple scan quals
+--
+create temp table batchqual (i2 int2, i4 int4, i8 int8, f4 float4, f8 float8,
+  d date, ts timestamptz, t text);
+insert into batchqual
+  select g, g, g * 1000000000::int8, g / 4.0, g / 4.0, '2000-01-01'::date + g,
+         '2000-01-01'::timestamptz + g * interval '1 hour', 'x' || g
+  from generate_series(1, 1000) g;
+insert into batchqual (f4, f8, t) values ('NaN', 'NaN', 'nan');
+set enable_batch_qual = on;
+select count(*) from batchqual where i2 < 100;
+select count(*) from batchqual where i4 >= 500 and i8 < 600000000000;
+select count(*) from batchqual where 10 > i4;
+select count(*) from batchqual where i4 <> 3 and i2 <= 5;
+select count(*) from batchqual where i8 = 7000000000;
+select count(*) from batchqual where f8 > 249.5;
+select count(*) from batchqual where f4 < 1;
+select count(*) from batchqual where f4 > 249.5::float8;
+select count(*) from batchqual where d between '2000-01-10' and '2000-01-20';
+select count(*) from batchqual where ts >= '2000-01-02';
+-- mix of batched and per-row quals
+select count(*) from batchqual where i4 < 50 and t like 'x1%';
+explain (analyze, costs off, timing off, summary off)
+select * from batchqual where i4 > 990;
+-- results must survive changes of scan direction
+begin;
+declare c scroll cursor for select i4 from batchqual where i4 > 997;
+fetch all from c;
+fetch backward all from c;
+commit;
+reset enable_batch_qual;
+drop table batchqual;
+
+--
+-- In-memory sorts on int4, int8 and abbreviated text keys go through the
+-- radix sort path; check the output order with lag()
+--
+create temp table radixsort as
+  select case when g % 97 = 0 then null
+              else (g * 7919) % 5003 - 2500 end as i4,
+         ((g * 7919) % 5003 - 2500)::int8 * 1000000007 as i8,
+         g::text as t,
+         g
+  from generate_series(1, 10000) g;
+-- leading key with duplicates and nulls, ties broken by the second key
+select count(*) from
+  (select i4, g, lag(i4) over w as pi4, lag(g) over w as pg,
+          row_number() over w as rn
+   from radixsort window w as (order by i4, g)) s
+  where rn > 1 and (pi4 > i4 or (pi4 = i4 and pg >= g) or
+                    (pi4 is null and i4 is not null) or
+                    (pi4 is null and i4 is null and pg >= g));
+select count(*) from
+  (select i4, g, lag(i4) over w as pi4, lag(g) over w as pg,
+          row_number() over w as rn
+   from radixsort window w as (order by i4 desc nulls last, g desc)) s
+  where rn > 1 and (pi4 < i4 or (pi4 = i4 and pg <= g) or
+                    (pi4 is null and i4 is not null) or
+                    (pi4 is null and i4 is null and pg <= g));
+-- single int8 key, including negative values
+select count(*) from
+  (select i8, lag(i8) over w as pi8, row_number() over w as rn
+   from radixsort window w as (order by i8 desc)) s
+  where rn > 1 and pi8 < i8;
+-- abbreviated keys
+select count(*) from
+  (select t, lag(t) over w as pt, row_number() over w as rn
+   from radixsort window w as (order by t collate "C")) s
+  where rn > 1 and pt >= t collate "C";
+drop table radixsort;
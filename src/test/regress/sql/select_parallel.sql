@@ -296,6 +296,92 @@ reset enable_material;
 
 reset enable_hashagg;
 
+-- test parallel-aware hash aggregation
+set enable_parallel_hashagg = on;
+
+-- string_agg can't be partially aggregated, so this can only be parallel
+-- by aggregating below the Gather
+set enable_gathermerge = off;
+explain (costs off)
+select ten, length(string_agg(unique1::text, ',')) from tenk1
+  group by ten order by ten;
+select ten, length(string_agg(unique1::text, ',')) from tenk1
+  group by ten order by ten;
+reset enable_gathermerge;
+
+select count(*), sum(c) from
+  (select unique1 % 1000 as k, count(*) as c from tenk1 group by 1) ss;
+
+select ten, count(*) from tenk1 group by ten order by ten;
+
+reset enable_parallel_hashagg;
+
+-- test parallel-aware sort, with the merge split up by key ranges
+set enable_parallel_sort = on;
+
+explain (costs off)
+  select unique1 - fivethous * 10000 as key from tenk1
+  order by fivethous desc, unique1;
+select count(*), count(*) filter (where prev > key) as out_of_order from
+  (select key, lag(key) over () as prev from
+    (select unique1 - fivethous * 10000 as key from tenk1
+     order by fivethous desc, unique1) ss) ss2;
+
+select count(*), count(*) filter (where (ps, pu) > (s, u)) as out_of_order from
+  (select string4 as s, unique1 as u,
+          lag(string4) over () as ps, lag(unique1) over () as pu from
+    (select string4, unique1 from tenk1 order by string4, unique1) ss) ss2;
+
+reset enable_parallel_sort;
+
+-- INSERT ... SELECT can run the SELECT part in parallel
+create table sp_insert_test (a int, b name);
+explain (costs off)
+  insert into sp_insert_test select unique1, stringu1 from tenk1 where ten = 3;
+insert into sp_insert_test select unique1, stringu1 from tenk1 where ten = 3;
+select count(*), sum(a) from sp_insert_test;
+drop table sp_insert_test;
+
+-- ... but not if the leader can't do the rest of the INSERT in parallel mode
+create function sp_unsafe_int(int) returns int language plpgsql immutable as
+  $$ begin return $1; end $$;
+create table sp_insert_conflict (a int primary key, b name);
+explain (costs off)
+  insert into sp_insert_conflict select unique1, stringu1 from tenk1 where ten = 3
+  on conflict do nothing;
+
+create table sp_insert_trigger (a int, b name);
+create function sp_insert_trigger_func() returns trigger language plpgsql as
+  $$ begin return new; end $$;
+create trigger sp_insert_trigger before insert on sp_insert_trigger
+  for each row execute procedure sp_insert_trigger_func();
+explain (costs off)
+  insert into sp_insert_trigger select unique1, stringu1 from tenk1 where ten = 3;
+
+create table sp_insert_check (a int check (sp_unsafe_int(a) >= 0), b name);
+explain (costs off)
+  insert into sp_insert_check select unique1, stringu1 from tenk1 where ten = 3;
+
+create table sp_insert_index_expr (a int, b name);
+create index on sp_insert_index_expr (sp_unsafe_int(a));
+explain (costs off)
+  insert into sp_insert_index_expr select unique1, stringu1 from tenk1 where ten = 3;
+
+create table sp_insert_index_pred (a int, b name);
+create index on sp_insert_index_pred (a) where sp_unsafe_int(a) > 0;
+explain (costs off)
+  insert into sp_insert_index_pred select unique1, stringu1 from tenk1 where ten = 3;
+
+create table sp_insert_part (a int, b name) partition by range (a);
+create table sp_insert_part_1 partition of sp_insert_part
+  for values from (minvalue) to (maxvalue);
+explain (costs off)
+  insert into sp_insert_part select unique1, stringu1 from tenk1 where ten = 3;
+drop table sp_insert_conflict, sp_insert_trigger, sp_insert_check,
+  sp_insert_index_expr, sp_insert_index_pred, sp_insert_part;
+drop function sp_insert_trigger_func();
+drop function sp_unsafe_int(int);
+
 -- check parallelized int8 aggregate (bug #14897)
 explain (costs off)
 select avg(unique1::int8) from tenk1;